@@ -0,0 +1,114 @@
+#pragma once
+
+#include "DirectoryWatcher.h"
+#include "JobSystem.h"
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class AssetType : uint8_t {
+    Unknown,
+    Texture,
+    Mesh,
+    Material,
+    Shader,
+    Audio,
+    Count
+};
+
+using AssetId = uint32_t;
+
+struct AssetRecord {
+    std::string path;          // relative to the project root, '/' separated
+    uint64_t size = 0;
+    int64_t modifiedTime = 0;  // file clock ticks, only compared for equality
+    uint64_t contentHash = 0;  // FNV-1a of the file contents
+    AssetType type = AssetType::Unknown;
+    std::vector<std::string> dependencies;  // project-relative paths this asset references
+    bool alive = false;
+};
+
+// Index of every file under the project root, persisted in <root>/.editor so the
+// next launch starts from it instead of an empty project. Only files whose size
+// or mtime differ from the index are re-read and re-hashed; while the editor runs,
+// a DirectoryWatcher feeds individual changes instead of rescanning the tree.
+// Scans run on the JobSystem; their results are applied on the main thread in update().
+class AssetDatabase {
+public:
+    static const char* typeName(AssetType type);
+    static AssetType typeFromPath(const std::string& path);
+    static std::string metadataDirectory(const std::string& root) { return root + "/.editor"; }
+
+    // Loads the saved index; nothing else is touched, so this can run on a worker
+    // during startup. Does nothing if the root does not exist.
+    void open(const std::string& root, JobSystem* jobs);
+    // Starts the watcher and a background pass that brings the index up to date.
+    void startWatching();
+    // Stops watching and saves the index if it changed.
+    void close();
+
+    // Main thread, once per frame.
+    void update();
+
+    bool isOpen() const { return _open; }
+    const std::string& root() const { return _root; }
+    std::string absolutePath(AssetId id) const { return _root + "/" + _records[id].path; }
+
+    const AssetRecord& record(AssetId id) const { return _records[id]; }
+    std::optional<AssetId> find(const std::string& path) const;
+    uint32_t assetCount() const { return static_cast<uint32_t>(_byPath.size()); }
+    uint32_t pendingScans() const { return _pendingScans; }
+    // Bumped whenever records change; lets views cache their listings.
+    uint64_t generation() const { return _generation; }
+
+    // Direct children of `folder` ("" is the root). With a filter, assets anywhere
+    // below `folder` whose file name contains it (case-insensitive) and no folders.
+    void list(const std::string& folder, const std::string& filter, std::optional<AssetType> type,
+              std::vector<std::string>& folders, std::vector<AssetId>& assets) const;
+
+private:
+    static constexpr uint32_t INDEX_MAGIC = 0x49414556;  // "VEAI"
+    static constexpr uint32_t INDEX_VERSION = 1;
+    static constexpr size_t SCAN_BATCH = 64;
+
+    struct ScanResult {
+        std::string path;
+        bool exists = false;
+        AssetRecord record;
+    };
+
+    std::string _root;
+    JobSystem* _jobs = nullptr;
+    bool _open = false;
+
+    std::vector<AssetRecord> _records;
+    std::unordered_map<std::string, AssetId> _byPath;
+    std::vector<AssetId> _freeIds;
+    uint64_t _generation = 0;
+    bool _dirty = false;
+
+    DirectoryWatcher _watcher;
+    std::atomic<uint32_t> _pendingScans{ 0 };
+    std::atomic<bool> _closing{ false };
+    std::mutex _resultsMutex;
+    std::vector<ScanResult> _results;
+    std::future<void> _save;
+
+    std::string indexPath() const { return metadataDirectory(_root) + "/asset_index.bin"; }
+    bool isMetadata(const std::string& path) const;
+
+    void reconcile();
+    void scanFiles(std::vector<std::string> paths);
+    ScanResult scanFile(const std::string& path) const;
+    void apply(ScanResult& result);
+    void remove(const std::string& path);
+
+    bool loadIndex();
+    std::vector<char> serializeIndex() const;
+    void saveIndex(bool wait);
+};
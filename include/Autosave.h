@@ -0,0 +1,55 @@
+#pragma once
+
+#include "TransformStore.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <string>
+
+// Saves the scene's transforms in the background at most every INTERVAL while there
+// are unsaved edits. The worker writes a TransformStore snapshot, which shares its
+// pages with the live store: taking one costs a pointer per page, and edits made
+// while it is written copy only the pages they touch. The file is replaced atomically.
+class Autosave {
+public:
+    static constexpr std::chrono::seconds INTERVAL{ 30 };
+
+    struct Stats {
+        uint64_t bytes = 0;
+        double writeMs = 0.0;
+        bool failed = false;
+    };
+
+    // An empty path disables autosave.
+    void init(JobSystem* jobs, std::string path, const TransformStore& transforms);
+    // Waits for a save in flight.
+    void cleanup();
+
+    // Once per frame. Nothing is started while `editing`, so a drag never begins
+    // with its pages shared.
+    void update(const TransformStore& transforms, bool editing);
+
+    bool enabled() const { return !_path.empty(); }
+    bool saving() const { return _save.valid(); }
+    // Since the last save that completed; negative before the first.
+    double secondsSinceSave() const;
+    // From the last save that completed.
+    const Stats& stats() const { return _stats; }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    JobSystem* _jobs = nullptr;
+    std::string _path;
+    std::future<Stats> _save;
+    uint64_t _savedGeneration = 0;
+    uint64_t _savingGeneration = 0;
+    Clock::time_point _lastAttempt;
+    Clock::time_point _lastSave;
+    bool _hasSaved = false;
+    Stats _stats;
+
+    void finishSave();
+    static Stats write(const std::string& path, const TransformStore::Snapshot& snapshot);
+};
@@ -9,6 +9,10 @@ class Camera {
 public:
     void setPerspective(float fov, float aspect, float near, float far) {
         _projection = glm::perspective(glm::radians(fov), aspect, near, far);
+        _fov = glm::radians(fov);
+        _aspect = aspect;
+        _nearPlane = near;
+        _farPlane = far;
     }
 
     void lookAt(glm::vec3 eye, glm::vec3 center, glm::vec3 up) {
@@ -17,8 +21,22 @@ public:
 
     const glm::mat4& projection() const { return _projection; }
     const glm::mat4& view() const { return _view; }
+    float fov() const { return _fov; }
+    float aspect() const { return _aspect; }
+    float nearPlane() const { return _nearPlane; }
+    float farPlane() const { return _farPlane; }
+
+    // Vulkan clip space has Y pointing down; projection() stays in the GL convention ImGuizmo expects.
+    glm::mat4 viewProjection() const {
+        glm::mat4 flipY = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f, -1.0f, 1.0f));
+        return flipY * _projection * _view;
+    }
 
 private:
     glm::mat4 _projection;
     glm::mat4 _view;
+    float _fov = glm::radians(45.0f);
+    float _aspect = 1.0f;
+    float _nearPlane = 0.1f;
+    float _farPlane = 100.0f;
 };
@@ -0,0 +1,92 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "VulkanContext.h"
+#include "Renderer.h"
+#include <algorithm>
+#include <atomic>
+
+// Immediate-mode debug geometry (grid, bounds, gizmo helpers, frusta).
+// Any thread may submit between beginFrame() and flush(): each primitive claims
+// space in the frame's persistently mapped buffer with a single atomic add, and
+// flush() draws everything with at most three draw calls (lines, triangles,
+// instanced boxes) regardless of how many primitives were submitted.
+class DebugDraw {
+public:
+    static constexpr uint32_t MAX_LINE_VERTICES = 512 * 1024;
+    static constexpr uint32_t MAX_TRIANGLE_VERTICES = 128 * 1024;
+    static constexpr uint32_t MAX_BOXES = 128 * 1024;
+
+    static uint32_t rgba(float r, float g, float b, float a = 1.0f);
+
+    void init(VulkanContext* context, VkRenderPass scenePass, bool hasEntityIdAttachment);
+    void cleanup();
+
+    // Selects this frame slot's buffer and discards its previous contents.
+    // Must not overlap with submissions from other threads.
+    void beginFrame(uint32_t frameIndex);
+    void flush(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection);
+
+    void line(const glm::vec3& a, const glm::vec3& b, uint32_t color);
+    void triangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, uint32_t color);
+    void point(const glm::vec3& position, float size, uint32_t color);
+    void aabb(const glm::vec3& min, const glm::vec3& max, uint32_t color);
+    void box(const glm::mat4& transform, uint32_t color);
+    void frustum(const glm::mat4& viewProjection, uint32_t color);
+    void grid(float halfExtent, float spacing, uint32_t color, uint32_t axisColor);
+
+    uint32_t lineCount() const { return std::min(_lineVertexCount.load(), MAX_LINE_VERTICES) / 2; }
+    uint32_t triangleCount() const { return std::min(_triangleVertexCount.load(), MAX_TRIANGLE_VERTICES) / 3; }
+    uint32_t boxCount() const { return std::min(_boxCount.load(), MAX_BOXES); }
+    uint32_t droppedCount() const { return _dropped.load(); }
+
+private:
+    struct Vertex {
+        glm::vec3 position;
+        uint32_t color;
+    };
+
+    struct BoxInstance {
+        glm::vec3 min;
+        uint32_t color;
+        glm::vec3 max;
+        float padding;
+    };
+
+    struct FrameBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint8_t* mapped = nullptr;
+    };
+
+    static constexpr VkDeviceSize LINE_OFFSET = 0;
+    static constexpr VkDeviceSize TRIANGLE_OFFSET = LINE_OFFSET + MAX_LINE_VERTICES * sizeof(Vertex);
+    static constexpr VkDeviceSize BOX_OFFSET = TRIANGLE_OFFSET + MAX_TRIANGLE_VERTICES * sizeof(Vertex);
+    static constexpr VkDeviceSize FRAME_BUFFER_SIZE = BOX_OFFSET + MAX_BOXES * sizeof(BoxInstance);
+
+    VulkanContext* _vkContext;
+    VkPipelineLayout _pipelineLayout;
+    VkPipeline _linePipeline;
+    VkPipeline _trianglePipeline;
+    VkPipeline _boxPipeline;
+
+    FrameBuffer _frames[Renderer::MAX_FRAMES_IN_FLIGHT];
+    uint32_t _frameIndex = 0;
+    Vertex* _lineVertices = nullptr;
+    Vertex* _triangleVertices = nullptr;
+    BoxInstance* _boxes = nullptr;
+
+    std::atomic<uint32_t> _lineVertexCount{ 0 };
+    std::atomic<uint32_t> _triangleVertexCount{ 0 };
+    std::atomic<uint32_t> _boxCount{ 0 };
+    std::atomic<uint32_t> _dropped{ 0 };
+
+    void createPipelines(VkRenderPass scenePass, bool hasEntityIdAttachment);
+    VkPipeline createPipeline(VkRenderPass scenePass, bool hasEntityIdAttachment, VkPrimitiveTopology topology,
+                              const char* vertexShader, const VkVertexInputBindingDescription& binding,
+                              const VkVertexInputAttributeDescription* attributes, uint32_t attributeCount);
+    void createBuffers();
+};
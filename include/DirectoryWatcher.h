@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reports changes under a directory tree as paths relative to its root ('/'
+// separated), from a background thread: ReadDirectoryChangesW on the whole subtree on
+// Windows, an inotify watch per directory on Linux and an FSEvents stream on macOS.
+// Where none is available, or inotify runs out of watches, the tree is polled for
+// size/mtime changes every POLL_INTERVAL instead. A reported path may be a file or a
+// directory, and may no longer exist.
+class DirectoryWatcher {
+public:
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{ 2000 };
+
+    ~DirectoryWatcher() { stop(); }
+
+    void start(const std::string& root);
+    void stop();
+
+    // Moves the changes seen since the last call into `changedPaths`. Returns false
+    // if changes were lost (the OS buffer overflowed) and the caller must rescan.
+    bool poll(std::vector<std::string>& changedPaths);
+
+private:
+    std::string _root;
+    std::thread _thread;
+    std::atomic<bool> _running{ false };
+
+    std::mutex _mutex;
+    std::condition_variable _stopped;
+    std::vector<std::string> _changes;
+    bool _overflowed = false;
+#ifdef _WIN32
+    void* _stopEvent = nullptr;
+#elif defined(__linux__)
+    int _stopEvent = -1;  // eventfd
+#endif
+
+    void watch();
+#ifndef _WIN32
+    // False if the native API could not be used; changes it may have missed are
+    // reported as an overflow.
+    bool watchNative();
+    void pollTree();
+#endif
+    void push(std::string path);
+};
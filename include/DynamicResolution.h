@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// Picks the Viewport's internal render scale from measured GPU time so the
+// scene stays inside a frame-time budget. Cost is assumed to scale with pixel
+// count (scale^2); drops are applied immediately, recovery is gradual.
+class DynamicResolution {
+public:
+    void setEnabled(bool enabled) { _enabled = enabled; }
+    void setTargetMs(float targetMs) { _targetMs = targetMs; }
+    void setScaleRange(float minScale, float maxScale);
+
+    bool enabled() const { return _enabled; }
+    float targetMs() const { return _targetMs; }
+    float scale() const { return _scale; }
+    float smoothedMs() const { return _smoothedMs; }
+
+    void update(float gpuMs);
+
+private:
+    static constexpr float SCALE_STEP = 0.025f;
+    static constexpr float MAX_SCALE_UP_PER_STEP = 0.05f;
+    static constexpr uint32_t SETTLE_FRAMES = 8;
+
+    bool _enabled = true;
+    float _targetMs = 12.0f;
+    float _minScale = 0.5f;
+    float _maxScale = 1.0f;
+    float _scale = 1.0f;
+    float _smoothedMs = 0.0f;
+    uint32_t _cooldown = 0;
+};
@@ -1,26 +1,73 @@
 #pragma once
 
 #include "VulkanContext.h"
+#include "Scene.h"
+#include "SceneOutline.h"
+#include "SceneSearchIndex.h"
+#include "Selection.h"
+#include "TransformStore.h"
+#include "Autosave.h"
+#include "AssetDatabase.h"
+#include "JobSystem.h"
+#include "StartupTrace.h"
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_vulkan.h>
+#include <functional>
+
+struct LaunchOptions {
+    bool startupTrace = false;             // --startup-trace
+    std::string projectRoot = "assets";    // --project <dir>
+};
 
 class EditorApp {
 public:
-    void run();
+    void run(const LaunchOptions& options = {});
 
 private:
     GLFWwindow* _window;
     VulkanContext _vkContext;
     VkDescriptorPool _imguiPool;
+    Scene _scene;
+    SceneOutline _outline;
+    SceneSearchIndex _searchIndex;
+    TransformStore _transforms;
+    Selection _selection;
+    Entity _selectionAnchor = NULL_ENTITY;  // where Shift-click ranges start
+    Autosave _autosave;
+    char _searchText[128] = "";
+    int _searchTypeFilter = 0;
+    LaunchOptions _options;
+    StartupTrace _startupTrace;
+
+    // Content Browser; the listing is rebuilt only when the key below changes.
+    AssetDatabase _assets;
+    std::string _browserFolder;
+    char _browserSearch[128] = "";
+    int _browserTypeFilter = 0;
+    std::vector<std::string> _browserFolders;
+    std::vector<AssetId> _browserAssets;
+    uint64_t _browserGeneration = UINT64_MAX;
+    std::string _browserListedKey;
+
+    // Last member: destroyed first, so queued jobs finish while everything they touch is alive.
+    JobSystem _jobs;
 
     void initWindow();
     void initVulkan();
+    void initImGuiContext();
     void initImGui();
+    void initScene();
     void mainLoop();
     void drawFrame();
+    void updateStreamingWorld();
+    void updateSelectionBounds();
+    void updateCullingObjects();
     void cleanup();
 
     void renderUI();
     void setupDockspace();
+    void drawHierarchy();
+    void clickRow(int row, int rowCount, const std::function<Entity(int)>& rowEntity);
+    void drawContentBrowser();
 };
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "VulkanContext.h"
+#include "Renderer.h"
+#include "TransformStore.h"
+#include "RenderGraph.h"
+#include <vector>
+
+// Device-local copy of every entity's transform, for the mesh renderer to bind as a
+// storage buffer indexed by entity id. Each frame only the blocks the TransformStore
+// marked dirty are packed into the frame slot's staging buffer and copied over in a
+// single vkCmdCopyBuffer, so moving 100k entities uploads 6 MB, not the whole scene.
+class InstanceBuffer {
+public:
+    struct Stats {
+        uint32_t regions = 0;
+        VkDeviceSize bytes = 0;
+    };
+
+    void init(VulkanContext* context, Renderer* renderer);
+    void cleanup();
+
+    // After Renderer::beginFrame(): packs the dirty blocks and adds an "instances" pass
+    // that copies them (none when nothing changed). Returns the buffer, imported into
+    // `graph`, for the passes that read it to declare.
+    RenderGraph::ResourceId addPass(RenderGraph& graph, uint32_t frameIndex, TransformStore& transforms);
+
+    // Valid until the next addPass(), which replaces it when the scene outgrows it.
+    VkBuffer buffer() const { return _buffer; }
+    VkDeviceSize size() const { return _capacity; }
+
+    // From the last addPass().
+    const Stats& stats() const { return _stats; }
+
+private:
+    struct Staging {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+        VkDeviceSize size = 0;
+    };
+
+    VulkanContext* _vkContext;
+    Renderer* _renderer;
+    VkBuffer _buffer = VK_NULL_HANDLE;
+    VkDeviceMemory _memory = VK_NULL_HANDLE;
+    VkDeviceSize _capacity = 0;
+    Staging _staging[Renderer::MAX_FRAMES_IN_FLIGHT];
+    std::vector<TransformStore::Range> _ranges;
+    std::vector<VkBufferCopy> _regions;
+    Stats _stats;
+
+    void destroyStaging(Staging& staging);
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads for independent CPU work: file I/O, decoding,
+// index builds. Jobs start in submission order; a job's exception is rethrown
+// from its future's get(). The destructor finishes queued jobs before joining.
+class JobSystem {
+public:
+    // 0 picks one worker per hardware thread, minus the main thread.
+    explicit JobSystem(uint32_t workerCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    template <typename Job>
+    auto submit(Job&& job) -> std::future<decltype(job())> {
+        using Result = decltype(job());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Job>(job));
+        std::future<Result> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _jobs.emplace([task] { (*task)(); });
+        }
+        _wake.notify_one();
+        return result;
+    }
+
+    // Runs body(begin, end) over [0, count) in chunks of `grain` on the workers and
+    // the calling thread together, and returns once every chunk is done. The caller
+    // takes chunks too, so it never waits on helpers still queued behind other jobs.
+    // The first exception a chunk throws is rethrown here.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+    uint32_t workerCount() const { return static_cast<uint32_t>(_workers.size()); }
+
+private:
+    std::vector<std::thread> _workers;
+    std::queue<std::function<void()>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    bool _stopping = false;
+
+    void workerLoop();
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "VulkanContext.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Selection.h"
+#include <vector>
+
+// Draws every mesh entity into the viewport's scene pass as an instance of one
+// shared mesh, in a single vkCmdDrawIndexed. Instance i takes its entity id from
+// the frame's draw list and its model matrix from the InstanceBuffer at that id;
+// mesh.frag writes the id to the entity-id attachment that picking reads back.
+// There are no mesh assets yet, so every mesh is the unit cube that
+// TransformStore::cubeBounds() assumes.
+class MeshRenderer : public Scene::Listener {
+public:
+    static constexpr uint32_t INDEX_COUNT = 36;
+
+    // The mesh pipeline is created against `scenePass`; `shadowSetLayout` is its set 1.
+    void init(VulkanContext* context, Scene* scene, VkRenderPass scenePass, bool hasEntityIdAttachment,
+              VkDescriptorSetLayout shadowSetLayout);
+    void cleanup();
+
+    // After InstanceBuffer::addPass(), with the buffer it left: points the slot's set
+    // at it and uploads the draw list if it changed since the slot's last frame.
+    // `moving` is the selection while it is being edited (null otherwise); its meshes
+    // go to the end of the draw list so shadow passes can draw them apart.
+    void beginFrame(uint32_t frameIndex, VkBuffer instances, const Selection* moving);
+
+    // Inside the scene pass: binds the pipeline, both sets, the mesh and the camera.
+    // draw() or indirect draws of INDEX_COUNT indices follow, one instance per mesh.
+    void bind(VkCommandBuffer commandBuffer, VkDescriptorSet shadowSet, const glm::mat4& viewProjection, const glm::mat4& view);
+    void draw(VkCommandBuffer commandBuffer);
+
+    // For another pipeline whose set 0 matches mesh.vert's (the shadow casters): binds
+    // the slot's set 0 and the mesh. The draws return whether any instance was drawn.
+    void bindInstances(VkCommandBuffer commandBuffer, VkPipelineLayout layout);
+    bool drawStatic(VkCommandBuffer commandBuffer);
+    bool drawMoving(VkCommandBuffer commandBuffer);
+
+    // Draw list order: instance i is drawList()[i]; the first staticCount() are not moving.
+    const std::vector<Entity>& drawList() const { return _drawList; }
+    uint32_t staticCount() const { return _staticCount; }
+    // Bumped whenever drawList() is rebuilt.
+    uint64_t drawListVersion() const { return _version; }
+
+    void onEntityCreated(const Scene& scene, Entity entity) override;
+    void onEntityRenamed(const Scene&, Entity, const std::string&) override {}
+
+private:
+    // Matches mesh.vert's inputs.
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 color;
+        glm::vec3 normal;
+    };
+
+    // Matches mesh.vert's push constants.
+    struct PushConstants {
+        glm::mat4 viewProjection;
+        glm::mat4 view;
+    };
+
+    struct FrameData {
+        VkBuffer drawList = VK_NULL_HANDLE;
+        VkDeviceMemory drawListMemory = VK_NULL_HANDLE;
+        Entity* mapped = nullptr;
+        uint32_t capacity = 0;
+        uint64_t version = UINT64_MAX;  // of _drawList, when it was uploaded
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        uint32_t count = 0;
+        uint32_t staticCount = 0;
+    };
+
+    VulkanContext* _vkContext;
+    VkDescriptorSetLayout _setLayout;
+    VkDescriptorPool _descriptorPool;
+    VkPipelineLayout _pipelineLayout;
+    VkPipeline _pipeline;
+
+    VkBuffer _geometry = VK_NULL_HANDLE;
+    VkDeviceMemory _geometryMemory = VK_NULL_HANDLE;
+    VkDeviceSize _indexOffset = 0;
+
+    std::vector<Entity> _meshes;  // in creation order
+    bool _meshesChanged = true;
+    std::vector<Entity> _drawList;
+    uint32_t _staticCount = 0;
+    uint64_t _version = 0;
+    uint64_t _movingGeneration = UINT64_MAX;  // of the moving selection in _drawList, MAX when none
+    FrameData _frames[Renderer::MAX_FRAMES_IN_FLIGHT];
+    uint32_t _frameIndex = 0;
+
+    void createDescriptors();
+    void createPipeline(VkRenderPass scenePass, bool hasEntityIdAttachment, VkDescriptorSetLayout shadowSetLayout);
+    void createGeometry();
+    void buildDrawList(const Selection* moving);
+    void reserveDrawList(FrameData& frame, uint32_t count);
+    void destroyDrawList(FrameData& frame);
+};
@@ -0,0 +1,145 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "VulkanContext.h"
+#include "Renderer.h"
+#include "ViewportRenderer.h"
+#include <vector>
+
+// Two-phase GPU occlusion culling against a hierarchical depth pyramid (Hi-Z).
+//   1. "cull early":        objects visible last frame that are inside the frustum.
+//   2. (draw them), "depth pyramid" from the resulting depth, then
+//   3. the late cull:       every object tested against the pyramid; the newly
+//                           visible ones are drawn and become next frame's phase-1 set.
+// Each object costs one bounds test in compute; an occluded object leaves a
+// zero-instance command behind and is never rasterized.
+// tests/OcclusionCullerTest.cpp runs a CPU port of both shaders over a fixed scene,
+// and the culler itself over the same scene on a headless device.
+class OcclusionCuller {
+public:
+    static constexpr uint32_t MAX_OBJECTS = 32 * 1024;
+    static constexpr VkFormat PYRAMID_FORMAT = VK_FORMAT_R32_SFLOAT;
+
+    struct Bounds {
+        glm::vec4 min;  // xyz, world space
+        glm::vec4 max;
+    };
+
+    struct Stats {
+        uint32_t earlyVisible = 0;
+        uint32_t lateVisible = 0;
+        uint32_t occluded = 0;
+    };
+
+    void init(VulkanContext* context);
+    void cleanup();
+
+    // Object i is drawn with draws[i] (its instanceCount is kept when visible).
+    // Extra objects beyond MAX_OBJECTS are ignored. The buffers are created by the
+    // first call with objects; until then the culler holds no GPU memory.
+    void setObjects(const std::vector<Bounds>& bounds, const std::vector<VkDrawIndexedIndirectCommand>& draws);
+    // The same objects, moved: unlike setObjects(), last frame's visibility is kept.
+    void updateBounds(const std::vector<Bounds>& bounds);
+
+    // Call after ViewportRenderer::beginFrame(): the slot's last frame has completed, so
+    // its stats can be read and its pyramid resized to the new render extent.
+    void beginFrame(uint32_t frameIndex, VkExtent2D renderExtent);
+
+    bool active() const;
+
+    // Adds the early cull passes ahead of the viewport's, and fills in `scene`: the
+    // indirect draws (recorded with the mesh pipeline and buffers bound), the pyramid
+    // build and late cull between the scene halves, and the buffers both use.
+    // Does nothing while inactive.
+    void addPasses(RenderGraph& graph, const glm::mat4& viewProjection, ViewportRenderer::SceneCallbacks& scene);
+
+    // From the last completed frame in this slot.
+    const Stats& stats() const { return _stats; }
+
+private:
+    struct Pyramid {
+        VkExtent2D extent{ 0, 0 };
+        uint32_t levels = 0;
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        std::vector<VkImageView> levelViews;
+        std::vector<VkDescriptorSet> downsampleSets;
+        bool inGeneralLayout = false;
+    };
+
+    struct HostBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+    };
+
+    struct FrameData {
+        HostBuffer objects;
+        HostBuffer templates;
+        HostBuffer stats;
+        VkBuffer draws = VK_NULL_HANDLE;
+        VkDeviceMemory drawsMemory = VK_NULL_HANDLE;
+        VkDescriptorSet cullSet = VK_NULL_HANDLE;
+        Pyramid pyramid;
+        uint32_t objectCount = 0;
+        bool objectsDirty = false;
+        bool statsPending = false;
+    };
+
+    struct CullPushConstants {
+        glm::mat4 viewProjection;
+        int32_t pyramidSize[2];
+        uint32_t objectCount;
+        uint32_t phase;
+        uint32_t drawOffset;
+        uint32_t pyramidLevels;
+    };
+
+    struct DownsamplePushConstants {
+        int32_t inputSize[2];
+        int32_t outputSize[2];
+    };
+
+    VulkanContext* _vkContext;
+    VkDescriptorSetLayout _cullSetLayout;
+    VkDescriptorSetLayout _downsampleSetLayout;
+    VkPipelineLayout _cullPipelineLayout;
+    VkPipelineLayout _downsamplePipelineLayout;
+    VkPipeline _cullPipeline;
+    VkPipeline _downsamplePipeline;
+    VkDescriptorPool _descriptorPool;
+    VkSampler _sampler;
+
+    // Persistent across frames: which objects passed the last late test.
+    VkBuffer _visibility = VK_NULL_HANDLE;
+    VkDeviceMemory _visibilityMemory = VK_NULL_HANDLE;
+    bool _visibilityReset = true;
+
+    FrameData _frames[Renderer::MAX_FRAMES_IN_FLIGHT];
+    uint32_t _frameIndex = 0;
+    VkExtent2D _renderExtent{ 0, 0 };
+    glm::mat4 _viewProjection{ 1.0f };
+    Stats _stats;
+
+    std::vector<Bounds> _bounds;
+    std::vector<VkDrawIndexedIndirectCommand> _draws;
+
+    void createDescriptorLayouts();
+    void createPipelines();
+    VkPipeline createComputePipeline(const char* shader, VkPipelineLayout layout);
+    void createBuffers();
+    void createHostBuffer(VkDeviceSize size, VkBufferUsageFlags usage, HostBuffer& buffer);
+    void destroyHostBuffer(HostBuffer& buffer);
+
+    void createPyramid(Pyramid& pyramid, VkExtent2D extent);
+    void destroyPyramid(Pyramid& pyramid);
+
+    void dispatchCull(VkCommandBuffer commandBuffer, uint32_t phase);
+    void buildDepthPyramid(VkCommandBuffer commandBuffer, VkImageView depthView);
+    void cullLate(VkCommandBuffer commandBuffer);
+    void recordDraws(VkCommandBuffer commandBuffer, VkDeviceSize offset);
+};
@@ -0,0 +1,236 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class RenderGraphExecutor;
+
+// A frame's GPU work as passes that declare which images and buffers they read and
+// write. compile() works on the declarations alone, without a device:
+//   - passes whose results nothing reads are culled (unless they have side effects),
+//   - layout transitions and hazards become one batched barrier in front of each
+//     pass that needs one, plus a final batch for imported images,
+//   - transient images whose lifetimes don't overlap share memory.
+// RenderGraphExecutor then allocates the transient images and records the passes.
+// Consecutive frames may compile to different graphs; compile() assumes nothing
+// about the previous one.
+// Buffers and persistent images are owned by their systems and imported each frame.
+//
+// Passes run in the order they were added; the graph does not reorder them.
+class RenderGraph {
+public:
+    using ResourceId = uint32_t;
+    static constexpr ResourceId NO_RESOURCE = UINT32_MAX;
+
+    enum class Access : uint8_t {
+        ColorAttachment,
+        DepthAttachment,
+        SampledFragment,   // sampled in a fragment shader
+        SampledCompute,    // sampled in a compute shader
+        StorageCompute,    // storage image or buffer in a compute shader
+        StorageVertex,     // storage buffer read in a vertex shader
+        IndirectCommand,   // indirect draw arguments
+        TransferSrc,
+        TransferDst,
+    };
+
+    struct Use {
+        ResourceId resource;
+        Access access;
+        bool read;
+        bool write;
+    };
+
+    static Use read(ResourceId resource, Access access) { return { resource, access, true, false }; }
+    static Use write(ResourceId resource, Access access) { return { resource, access, false, true }; }
+    static Use readWrite(ResourceId resource, Access access) { return { resource, access, true, true }; }
+
+    struct ImageDesc {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{ 0, 0 };
+        VkImageUsageFlags usage = 0;   // every use across frames, so the allocation stays stable
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    };
+
+    // What the device needs for an image; in tests, anything consistent.
+    struct MemoryRequirements {
+        VkDeviceSize size;
+        VkDeviceSize alignment;
+        uint32_t memoryTypeIndex;
+    };
+    using MemoryQuery = std::function<MemoryRequirements(const ImageDesc&)>;
+
+    using Record = std::function<void(VkCommandBuffer, RenderGraphExecutor&)>;
+
+    struct ImageBarrier {
+        ResourceId resource;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+        VkAccessFlags srcAccess;
+        VkAccessFlags dstAccess;
+    };
+
+    // Whole buffer.
+    struct BufferBarrier {
+        ResourceId resource;
+        VkAccessFlags srcAccess;
+        VkAccessFlags dstAccess;
+    };
+
+    // One vkCmdPipelineBarrier.
+    struct BarrierBatch {
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<ImageBarrier> images;
+        std::vector<BufferBarrier> buffers;
+
+        bool empty() const { return images.empty() && buffers.empty(); }
+    };
+
+    struct Placement {
+        uint32_t heap;
+        VkDeviceSize offset;
+        VkDeviceSize size;
+    };
+
+    struct Heap {
+        uint32_t memoryTypeIndex;
+        VkDeviceSize size;
+    };
+
+    // What backing a compiled graph takes: its heaps and each transient image's shape
+    // and place in them. Graphs with equal layouts can run on the same allocation.
+    struct TransientImage {
+        ResourceId resource;
+        ImageDesc desc;
+        Placement placement;
+    };
+
+    struct MemoryLayout {
+        std::vector<Heap> heaps;
+        std::vector<TransientImage> images;   // by ResourceId
+
+        bool operator==(const MemoryLayout& other) const;
+    };
+
+    struct CompiledPass {
+        uint32_t pass;
+        BarrierBatch barriers;   // empty when nothing needs to wait
+    };
+
+    struct Stats {
+        uint32_t passes = 0;
+        uint32_t culledPasses = 0;
+        uint32_t barrierBatches = 0;      // vkCmdPipelineBarrier calls
+        uint32_t imageBarriers = 0;
+        uint32_t bufferBarriers = 0;
+        uint32_t uses = 0;                // resource uses by live passes
+        VkDeviceSize transientBytes = 0;  // heaps after aliasing
+        VkDeviceSize unaliasedBytes = 0;  // one allocation per transient image
+    };
+
+    // Forgets every resource and pass, keeping capacity.
+    void reset();
+
+    ResourceId createImage(const std::string& name, const ImageDesc& desc);
+    // An image owned elsewhere. Its first use waits for `initialStages`; after the
+    // last pass it is moved to `finalLayout` (UNDEFINED: left as the last pass used it).
+    ResourceId importImage(const std::string& name, const ImageDesc& desc, VkImage image, VkImageView view,
+                           VkImageLayout initialLayout, VkPipelineStageFlags initialStages, VkImageLayout finalLayout);
+    // A buffer owned elsewhere, e.g. one written each frame and read by the next. Its
+    // first use waits for `initialStages` and sees their `initialAccess` writes.
+    ResourceId importBuffer(const std::string& name, VkBuffer buffer, VkPipelineStageFlags initialStages, VkAccessFlags initialAccess = 0);
+
+    // Side-effect passes (writes outside the graph: host readbacks, presentation)
+    // are never culled.
+    void addPass(const std::string& name, std::vector<Use> uses, Record record, bool sideEffects = false);
+
+    // Throws std::runtime_error on an invalid graph (unknown resource, an image access
+    // on a buffer or the reverse, or a use the image's usage flags don't allow).
+    void compile(const MemoryQuery& memoryQuery);
+
+    // After compile().
+    const std::vector<CompiledPass>& compiledPasses() const { return _compiled; }
+    const BarrierBatch& finalBarriers() const { return _finalBarriers; }
+    const std::vector<Heap>& heaps() const { return _heaps; }
+    MemoryLayout memoryLayout() const;
+    const Stats& stats() const { return _stats; }
+    bool allocated(ResourceId resource) const { return _resources[resource].placement.heap != NO_HEAP; }
+    const Placement& placement(ResourceId resource) const { return _resources[resource].placement; }
+
+    uint32_t resourceCount() const { return static_cast<uint32_t>(_resources.size()); }
+    const std::string& resourceName(ResourceId resource) const { return _resources[resource].name; }
+    const ImageDesc& desc(ResourceId resource) const { return _resources[resource].desc; }
+    bool imported(ResourceId resource) const { return _resources[resource].imported; }
+    bool isBuffer(ResourceId resource) const { return _resources[resource].bufferResource; }
+    VkBuffer importedBuffer(ResourceId resource) const { return _resources[resource].buffer; }
+    VkImage importedImage(ResourceId resource) const { return _resources[resource].image; }
+    VkImageView importedView(ResourceId resource) const { return _resources[resource].view; }
+    VkImageLayout initialLayout(ResourceId resource) const { return _resources[resource].initialLayout; }
+    VkImageLayout finalLayout(ResourceId resource) const { return _resources[resource].finalLayout; }
+    const std::string& passName(uint32_t pass) const { return _passes[pass].name; }
+    const std::vector<Use>& passUses(uint32_t pass) const { return _passes[pass].uses; }
+    const Record& passRecord(uint32_t pass) const { return _passes[pass].record; }
+
+    void printStats(std::ostream& out) const;
+
+private:
+    static constexpr uint32_t NO_HEAP = UINT32_MAX;
+
+    struct Resource {
+        std::string name;
+        ImageDesc desc;
+        bool imported = false;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        bool bufferResource = false;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags initialStages = 0;
+        VkAccessFlags initialAccess = 0;
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        // compile()
+        uint32_t firstUse = UINT32_MAX;   // index into _compiled
+        uint32_t lastUse = 0;
+        VkPipelineStageFlags lastStages = 0;
+        VkAccessFlags lastWriteAccess = 0;
+        Placement placement{ NO_HEAP, 0, 0 };
+    };
+
+    struct Pass {
+        std::string name;
+        std::vector<Use> uses;
+        Record record;
+        bool sideEffects;
+    };
+
+    struct AccessInfo {
+        VkPipelineStageFlags stages;
+        VkAccessFlags readAccess;
+        VkAccessFlags writeAccess;
+        VkImageLayout layout;
+        VkImageUsageFlags usage;
+        bool image;    // valid on images
+        bool buffer;   // valid on buffers
+    };
+
+    std::vector<Resource> _resources;
+    std::vector<Pass> _passes;
+    std::vector<CompiledPass> _compiled;
+    BarrierBatch _finalBarriers;
+    std::vector<Heap> _heaps;
+    Stats _stats;
+
+    static AccessInfo accessInfo(Access access, VkImageAspectFlags aspect);
+    void validate() const;
+    std::vector<bool> cullPasses() const;
+    void computeLifetimes();
+    void placeTransients(const MemoryQuery& memoryQuery);
+    void computeBarriers();
+    bool memoryOverlaps(const Resource& a, const Resource& b) const;
+};
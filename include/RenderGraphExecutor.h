@@ -0,0 +1,69 @@
+#pragma once
+
+#include "VulkanContext.h"
+#include "RenderGraph.h"
+#include "Renderer.h"
+#include <initializer_list>
+#include <map>
+#include <tuple>
+#include <vector>
+
+// Backs a compiled RenderGraph with memory and records it. Transient images are
+// bound into one allocation per memory type at the offsets compile() chose, and
+// each frame slot has its own allocation, so a frame never shares transient memory
+// with the one still in flight. A slot's allocation is kept for as long as the graph
+// compiles to the same memory layout; when that changes (a resize, a pass coming or
+// going) it is handed to Renderer::retire() and the slot gets a new one.
+class RenderGraphExecutor {
+public:
+    void init(VulkanContext* context, Renderer* renderer);
+    void cleanup();
+
+    // Compiles `graph` and records its live passes, each behind its batched barrier.
+    void execute(RenderGraph& graph, VkCommandBuffer commandBuffer);
+
+    // Valid inside a pass's record callback.
+    VkImage image(RenderGraph::ResourceId resource) const;
+    VkImageView view(RenderGraph::ResourceId resource) const;
+    // Sized to the first attachment and cached with the transient images, so it
+    // stays valid for as long as the allocation does.
+    VkFramebuffer framebuffer(VkRenderPass renderPass, std::initializer_list<RenderGraph::ResourceId> attachments);
+
+    // From the last execute().
+    const RenderGraph::Stats& stats() const { return _stats; }
+
+private:
+    struct Image {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+    };
+
+    struct Framebuffer {
+        VkRenderPass renderPass;
+        std::vector<VkImageView> views;
+        VkFramebuffer framebuffer;
+    };
+
+    struct Allocation {
+        RenderGraph::MemoryLayout layout;
+        std::vector<VkDeviceMemory> heaps;
+        std::vector<Image> images;   // indexed by ResourceId; empty entries for imported or culled images
+        std::vector<Framebuffer> framebuffers;
+    };
+
+    using RequirementsKey = std::tuple<VkFormat, uint32_t, uint32_t, VkImageUsageFlags>;
+
+    VulkanContext* _vkContext;
+    Renderer* _renderer;
+    Allocation _allocations[Renderer::MAX_FRAMES_IN_FLIGHT];
+    Allocation* _allocation = nullptr;   // the recording frame's, inside execute()
+    std::map<RequirementsKey, RenderGraph::MemoryRequirements> _requirements;
+    const RenderGraph* _graph = nullptr;
+    RenderGraph::Stats _stats;
+
+    RenderGraph::MemoryRequirements memoryRequirements(const RenderGraph::ImageDesc& desc);
+    VkImage createImage(const RenderGraph::ImageDesc& desc);
+    Allocation allocate(RenderGraph::MemoryLayout layout, uint32_t resourceCount);
+    void destroy(Allocation& allocation);
+    void recordBarriers(VkCommandBuffer commandBuffer, const RenderGraph::BarrierBatch& batch);
+};
@@ -1,21 +1,61 @@
 #pragma once
 
 #include "VulkanContext.h"
+#include "RenderGraph.h"
+#include <deque>
+#include <functional>
 #include <vector>
 
+// Frames are paced with a timeline semaphore: frame N signals the
+// graphics timeline with N + 1 when its work completes, and a frame slot is
+// reused once the frame that last used it has signaled. Binary semaphores are
+// left only where the swapchain requires them (acquire and present).
 class Renderer {
 public:
-    void init(VulkanContext* context);
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
+    // Throughput lets the CPU record up to MAX_FRAMES_IN_FLIGHT frames ahead of the
+    // GPU. LowLatency waits for the previous frame before input is read, so what is
+    // drawn reflects the newest input at some cost in GPU idle time.
+    enum class Pacing { Throughput, LowLatency };
+
+    void init(VulkanContext* context, GLFWwindow* window);
     void cleanup();
 
+    // beginFrame() waits for the frame slot and opens its command buffer; the frame's
+    // work is recorded through a RenderGraph whose last pass draws the UI between
+    // beginUIPass() and endUIPass(). endFrame() submits and presents. A swap chain
+    // that acquire or present reports out of date is recreated, with its framebuffers.
     void beginFrame();
+    void beginUIPass();
+    void endUIPass();
     void endFrame();
 
+    // This frame's swapchain image; the graph leaves it ready to present.
+    RenderGraph::ResourceId importSwapChainImage(RenderGraph& graph);
+
     VkRenderPass renderPass() { return _renderPass; }
     VkCommandBuffer currentCommandBuffer();
+    uint32_t currentFrame() const { return _currentFrame; }
+    uint64_t frameNumber() const { return _frameNumber; }
+
+    // Call before polling input; blocks for as long as the pacing mode asks.
+    void pace();
+    void setPacing(Pacing pacing) { _pacing = pacing; }
+    Pacing pacing() const { return _pacing; }
+
+    // Frame N is complete once this reaches N + 1.
+    VkSemaphore graphicsTimeline() const { return _graphicsTimeline; }
+
+    // Destroys something frames in flight may still use. Retired during frame N, it
+    // was last recorded by N at the latest, so `destroy` runs in the beginFrame() of
+    // N + MAX_FRAMES_IN_FLIGHT, once that frame's slot has been waited for; cleanup()
+    // runs whatever is left.
+    void retire(std::function<void()> destroy);
 
 private:
     VulkanContext* _vkContext;
+    GLFWwindow* _window;
     VkRenderPass _renderPass;
     std::vector<VkFramebuffer> _swapChainFramebuffers;
     VkCommandPool _commandPool;
@@ -23,13 +63,26 @@ private:
 
     std::vector<VkSemaphore> _imageAvailableSemaphores;
     std::vector<VkSemaphore> _renderFinishedSemaphores;
-    std::vector<VkFence> _inFlightFences;
+    VkSemaphore _graphicsTimeline;
     uint32_t _currentFrame = 0;
     uint32_t _imageIndex = 0;
+    uint64_t _frameNumber = 0;
+    Pacing _pacing = Pacing::Throughput;
+
+    struct Retired {
+        uint64_t frameNumber;
+        std::function<void()> destroy;
+    };
+    std::deque<Retired> _retired;
 
     void createRenderPass();
     void createFramebuffers();
+    void destroyFramebuffers();
+    void recreateSwapChain();
     void createCommandPool();
     void createCommandBuffers();
     void createSyncObjects();
+    VkSemaphore createTimeline();
+    void waitTimeline(VkSemaphore timeline, uint64_t value);
+    void releaseRetired(bool all);
 };
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using Entity = uint32_t;
+
+// Entity 0 is the scene root. It is never drawn, so it doubles as the
+// "nothing" value in the entity-id buffer.
+constexpr Entity ROOT_ENTITY = 0;
+constexpr Entity NULL_ENTITY = 0;
+
+enum class EntityType : uint8_t {
+    Empty,
+    Camera,
+    Light,
+    Mesh,
+    Count
+};
+
+const char* entityTypeName(EntityType type);
+
+// Structure-of-arrays scene tree. Children are kept as an intrusive sibling list
+// so adding an entity is O(1) and walking a subtree touches no allocations.
+class Scene {
+public:
+    // Observers get told about structural edits so derived views (outline, search index)
+    // can update incrementally instead of rescanning the whole scene.
+    class Listener {
+    public:
+        virtual ~Listener() = default;
+        virtual void onEntityCreated(const Scene& scene, Entity entity) = 0;
+        virtual void onEntityRenamed(const Scene& scene, Entity entity, const std::string& oldName) = 0;
+    };
+
+    Scene();
+
+    Entity createEntity(std::string name, EntityType type, Entity parent = ROOT_ENTITY);
+    void renameEntity(Entity entity, std::string name);
+    void reserve(size_t count);
+
+    void addListener(Listener* listener) { _listeners.push_back(listener); }
+
+    size_t entityCount() const { return _names.size(); }
+    bool isValid(Entity entity) const { return entity != ROOT_ENTITY && entity < _names.size(); }
+
+    const std::string& name(Entity entity) const { return _names[entity]; }
+    EntityType type(Entity entity) const { return _types[entity]; }
+    Entity parent(Entity entity) const { return _parents[entity]; }
+    Entity firstChild(Entity entity) const { return _firstChildren[entity]; }
+    Entity nextSibling(Entity entity) const { return _nextSiblings[entity]; }
+    bool hasChildren(Entity entity) const { return _firstChildren[entity] != NULL_ENTITY; }
+
+private:
+    std::vector<std::string> _names;
+    std::vector<EntityType> _types;
+    std::vector<Entity> _parents;
+    std::vector<Entity> _firstChildren;
+    std::vector<Entity> _lastChildren;
+    std::vector<Entity> _nextSiblings;
+
+    std::vector<Listener*> _listeners;
+};
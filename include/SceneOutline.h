@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Scene.h"
+#include <vector>
+
+// Flattened, expand/collapse-aware view of the scene tree for the Hierarchy panel.
+// Rows are kept up to date incrementally so the panel can clip to the visible range
+// and never walks the whole tree per frame.
+class SceneOutline : public Scene::Listener {
+public:
+    struct Row {
+        Entity entity;
+        uint32_t depth;
+    };
+
+    static constexpr uint32_t HIDDEN_ROW = UINT32_MAX;
+
+    void init(Scene* scene);
+
+    // Applies entities created since the last call. Small batches are spliced in place,
+    // large ones (bulk imports) fall back to a single linear rebuild.
+    void sync();
+
+    const std::vector<Row>& rows() const { return _rows; }
+    uint32_t rowOf(Entity entity) const { return _rowOf[entity]; }
+    bool isExpanded(Entity entity) const { return _expanded[entity] != 0; }
+    void setExpanded(Entity entity, bool expanded);
+
+    void onEntityCreated(const Scene& scene, Entity entity) override;
+    void onEntityRenamed(const Scene&, Entity, const std::string&) override {}
+
+private:
+    static constexpr size_t REBUILD_THRESHOLD = 256;
+
+    Scene* _scene = nullptr;
+    std::vector<Row> _rows;
+    std::vector<uint32_t> _rowOf;
+    std::vector<uint8_t> _expanded;
+    std::vector<Entity> _pending;
+
+    void rebuild();
+    void collectVisibleDescendants(Entity entity, uint32_t depth, std::vector<Row>& out) const;
+    size_t subtreeEndRow(Entity entity) const;
+    void insertRows(size_t at, const std::vector<Row>& rows);
+    void eraseRows(size_t begin, size_t end);
+    void reindexFrom(size_t row);
+};
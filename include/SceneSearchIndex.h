@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Scene.h"
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Case-insensitive substring search over entity names, backed by an inverted index
+// of trigrams plus per-type posting lists. Posting lists stay sorted by entity id:
+// queries of three or more characters are trigram list intersections followed by a
+// verify pass over the (usually tiny) candidate set; shorter ones scan the names once
+// and are refined from that result as the query grows.
+class SceneSearchIndex : public Scene::Listener {
+public:
+    void init(Scene* scene);
+
+    // Results are cached: typing more characters only refines the previous result set.
+    const std::vector<Entity>& search(const std::string& text, std::optional<EntityType> type);
+
+    void onEntityCreated(const Scene& scene, Entity entity) override;
+    void onEntityRenamed(const Scene& scene, Entity entity, const std::string& oldName) override;
+
+private:
+    Scene* _scene = nullptr;
+    std::unordered_map<uint32_t, std::vector<Entity>> _trigrams;
+    std::vector<Entity> _byType[static_cast<size_t>(EntityType::Count)];
+    uint64_t _generation = 0;
+
+    std::string _lastQuery;
+    std::optional<EntityType> _lastType;
+    uint64_t _lastGeneration = UINT64_MAX;
+    std::vector<Entity> _results;
+
+    void indexName(Entity entity, const std::string& name);
+    void unindexName(Entity entity, const std::string& name);
+    void candidatesFromTrigrams(const std::string& query, std::vector<Entity>& out) const;
+    bool matches(Entity entity, const std::string& query, std::optional<EntityType> type) const;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "Scene.h"
+#include <cstdint>
+#include <vector>
+
+// Set of selected entities as a sparse set: a dense list of members plus an
+// entity-indexed slot array pointing into it. add/remove/contains are O(1),
+// clear() only forgets the dense list, and iterating touches only members, so
+// selections of millions of entities cost nothing when they are not edited.
+class Selection {
+public:
+    bool contains(Entity entity) const {
+        return entity < _slots.size() && _slots[entity] < _entities.size() && _entities[_slots[entity]] == entity;
+    }
+
+    // Adding also makes `entity` the primary one, whether or not it was selected.
+    void add(Entity entity);
+    void remove(Entity entity);
+    void toggle(Entity entity);
+    // Replaces the selection with `entity`, or empties it for NULL_ENTITY.
+    void select(Entity entity);
+    void clear();
+
+    // In selection order, except that remove() moves the last member into the gap.
+    const std::vector<Entity>& entities() const { return _entities; }
+    size_t size() const { return _entities.size(); }
+    bool empty() const { return _entities.empty(); }
+
+    // The most recently added member still selected: the one the gizmo and the
+    // Properties panel show and the others follow. NULL_ENTITY when empty.
+    Entity primary() const { return _primary; }
+
+    // Changes whenever membership does.
+    uint64_t generation() const { return _generation; }
+
+private:
+    std::vector<Entity> _entities;
+    std::vector<uint32_t> _slots;  // entity -> index into _entities, stale for non-members
+    Entity _primary = NULL_ENTITY;
+    uint64_t _generation = 0;
+};
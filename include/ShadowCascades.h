@@ -0,0 +1,55 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "Camera.h"
+#include <cstdint>
+
+// Fits directional-light shadow cascades to the camera frustum and decides when
+// the cached static shadow maps are stale. Each cascade is rendered around a
+// texel-snapped anchor with some slack beyond the frustum slice's bounding sphere;
+// the anchor (and therefore the light matrix) only moves once the camera has
+// drifted past that slack, so a static map stays valid across many frames.
+class ShadowCascades {
+public:
+    static constexpr uint32_t CASCADE_COUNT = 4;
+
+    struct Cascade {
+        glm::mat4 viewProjection{ 1.0f };
+        float splitDepth = 0.0f;    // view-space distance where this cascade ends
+        float halfExtent = 0.0f;    // world units covered on each side of the anchor
+        glm::vec3 anchor{ 0.0f };   // light-space centre the cached map was rendered around
+        bool staticDirty = true;
+    };
+
+    void setResolution(uint32_t resolution);
+    void setLightDirection(const glm::vec3& direction);
+    void setMaxDistance(float distance) { _maxDistance = distance; }
+    void setSplitLambda(float lambda) { _splitLambda = lambda; }
+
+    const glm::vec3& lightDirection() const { return _lightDirection; }
+    const Cascade& cascade(uint32_t index) const { return _cascades[index]; }
+
+    // Refits the cascades; any cascade whose anchor moves is marked static-dirty.
+    void update(const Camera& camera);
+
+    // A static caster moved inside [min, max]: only cascades that can see the box are re-rendered.
+    void invalidateStatic(const glm::vec3& min, const glm::vec3& max);
+    void invalidateAll();
+    void markStaticRendered(uint32_t index) { _cascades[index].staticDirty = false; }
+
+private:
+    // Fraction of the bounding radius added around each cascade before it has to move.
+    static constexpr float CACHE_MARGIN = 0.25f;
+    // Casters this far towards the light from a cascade still land in its map.
+    static constexpr float CASTER_DISTANCE = 50.0f;
+
+    Cascade _cascades[CASCADE_COUNT];
+    glm::vec3 _lightDirection = glm::normalize(glm::vec3(-1.0f, -1.0f, -1.0f));
+    glm::mat4 _lightView{ 1.0f };
+    uint32_t _resolution = 2048;
+    float _maxDistance = 100.0f;
+    float _splitLambda = 0.75f;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "VulkanContext.h"
+#include "Renderer.h"
+#include "ShadowCascades.h"
+#include "RenderGraph.h"
+#include <functional>
+#include <vector>
+
+// Cascaded shadow maps for the directional light, split into two atlases that
+// share the same cascade matrices:
+//  - the static atlas is persistent and a cascade tile is only re-rendered when
+//    ShadowCascades marks it dirty (a static caster moved or the cascade re-anchored);
+//  - the dynamic atlas holds casters that move every frame and is redrawn each frame,
+//    but only while something dynamic exists.
+// The mesh shader takes the minimum visibility of both, which composites the
+// dynamic casters over the cached static shadows without copying the atlas.
+class ShadowRenderer {
+public:
+    static constexpr VkFormat DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+    static constexpr uint32_t CASCADE_RESOLUTION = 2048;
+    static constexpr uint32_t ATLAS_SIZE = CASCADE_RESOLUTION * 2;  // 2x2 cascade tiles
+    static constexpr uint32_t CASTER_VERTEX_STRIDE = sizeof(float) * 9;  // mesh.vert: position, color, normal
+
+    // Records caster draws into one cascade tile. The shadow pipeline and the
+    // light matrix are already bound; callers bind their set 0 (transforms and draw
+    // list, laid out as in mesh.vert), their vertex buffer (position at location 0,
+    // CASTER_VERTEX_STRIDE) and draw instances. Returns whether anything was drawn.
+    using DrawCasters = std::function<bool(VkCommandBuffer, VkPipelineLayout, const glm::mat4& lightViewProjection)>;
+
+    struct Casters {
+        DrawCasters drawStatic;
+        DrawCasters drawDynamic;  // empty when nothing in the scene is moving
+        std::vector<RenderGraph::Use> uses;  // buffers the draws read, added to both passes
+    };
+
+    // Both atlases, imported into the frame's graph; passes that sample them
+    // declare SampledFragment reads.
+    struct Atlases {
+        RenderGraph::ResourceId staticAtlas;
+        RenderGraph::ResourceId dynamicAtlas;
+    };
+
+    void init(VulkanContext* context);
+    void cleanup();
+
+    // Refits the cascades to the camera and adds a pass for each atlas that actually
+    // needs drawing this frame.
+    Atlases addPasses(RenderGraph& graph, uint32_t frameIndex, const Camera& camera, const Casters& casters);
+
+    ShadowCascades& cascades() { return _cascades; }
+
+    // Set 1 of the mesh pipeline: cascade data (binding 0), static and dynamic atlases (1, 2).
+    VkDescriptorSetLayout descriptorSetLayout() const { return _setLayout; }
+    VkDescriptorSet descriptorSet(uint32_t frameIndex) const { return _frames[frameIndex].descriptorSet; }
+
+    uint32_t staticCascadesUpdated() const { return _staticCascadesUpdated; }
+    uint32_t dynamicCascadesUpdated() const { return _dynamicCascadesUpdated; }
+    uint64_t totalStaticUpdates() const { return _totalStaticUpdates; }
+
+private:
+    struct Atlas {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        bool initialized = false;  // a pass has recorded into it, so it holds depth
+    };
+
+    // Matches the ShadowData block in mesh.frag (std140).
+    struct ShadowUniforms {
+        glm::mat4 cascadeMatrices[ShadowCascades::CASCADE_COUNT];
+        glm::vec4 splitDepths;
+        glm::vec4 lightDirection;
+        glm::vec4 atlasTexelSize;
+    };
+
+    struct FrameData {
+        VkBuffer uniformBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory uniformMemory = VK_NULL_HANDLE;
+        ShadowUniforms* mapped = nullptr;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    };
+
+    VulkanContext* _vkContext;
+    ShadowCascades _cascades;
+
+    VkRenderPass _clearPass;
+    VkRenderPass _loadPass;
+    VkDescriptorSetLayout _casterSetLayout;
+    VkPipelineLayout _pipelineLayout;
+    VkPipeline _pipeline;
+    VkSampler _sampler;
+    VkDescriptorSetLayout _setLayout;
+    VkDescriptorPool _descriptorPool;
+
+    Atlas _staticAtlas;
+    Atlas _dynamicAtlas;
+    bool _dynamicTileUsed[ShadowCascades::CASCADE_COUNT] = {};
+    FrameData _frames[Renderer::MAX_FRAMES_IN_FLIGHT];
+
+    uint32_t _staticCascadesUpdated = 0;
+    uint32_t _dynamicCascadesUpdated = 0;
+    uint64_t _totalStaticUpdates = 0;
+
+    void createRenderPasses();
+    void createAtlas(Atlas& atlas);
+    void destroyAtlas(Atlas& atlas);
+    void createPipeline();
+    void createSampler();
+    void createDescriptors();
+
+    static glm::mat4 tileMatrix(uint32_t cascade);
+    RenderGraph::ResourceId importAtlas(RenderGraph& graph, const char* name, const Atlas& atlas);
+    void beginAtlas(VkCommandBuffer commandBuffer, const Atlas& atlas, bool clear);
+    void beginTile(VkCommandBuffer commandBuffer, uint32_t cascade, bool clear);
+    void addStaticPass(RenderGraph& graph, RenderGraph::ResourceId atlas, const Casters& casters);
+    void addDynamicPass(RenderGraph& graph, RenderGraph::ResourceId atlas, const Casters& casters);
+    void writeUniforms(uint32_t frameIndex);
+};
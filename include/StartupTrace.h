@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Wall-clock timings of the startup stages, recorded from any thread.
+// `--startup-trace` prints them once the first frame has been drawn.
+class StartupTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Times its own lifetime as one stage.
+    class Stage {
+    public:
+        Stage(StartupTrace& trace, const char* name) : _trace(trace), _name(name), _start(Clock::now()) {}
+        ~Stage() { _trace.record(_name, _start, Clock::now()); }
+
+        Stage(const Stage&) = delete;
+        Stage& operator=(const Stage&) = delete;
+
+    private:
+        StartupTrace& _trace;
+        const char* _name;
+        Clock::time_point _start;
+    };
+
+    // The constructing thread is reported as "main"; its construction is time zero.
+    StartupTrace();
+
+    void setEnabled(bool enabled) { _enabled = enabled; }
+    bool enabled() const { return _enabled; }
+
+    void record(const char* name, Clock::time_point start, Clock::time_point end);
+
+    // Stages sorted by start time, then the total up to the latest end.
+    void print(std::ostream& out) const;
+
+private:
+    struct Entry {
+        std::string name;
+        std::thread::id thread;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    Clock::time_point _origin;
+    std::thread::id _mainThread;
+    bool _enabled = false;
+
+    mutable std::mutex _mutex;
+    std::vector<Entry> _entries;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "VulkanContext.h"
+#include "Renderer.h"
+#include "JobSystem.h"
+#include "AssetDatabase.h"
+#include "RenderGraph.h"
+#include <bitset>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Asset thumbnails, rendered on JobSystem workers (images are decoded and
+// downsampled, OBJ meshes go through a small CPU rasterizer) and stored in a
+// paged on-disk atlas: each page file holds SLOTS_PER_PAGE tiles back to back.
+// Entries are keyed by content hash, so a moved or renamed asset keeps its
+// thumbnail and an edited one gets a fresh one. Pages that are on screen are
+// mirrored into GPU atlas images, least recently used first out.
+class ThumbnailCache {
+public:
+    static constexpr uint32_t THUMBNAIL_SIZE = 128;
+    static constexpr uint32_t PAGE_TILES = 16;  // per side
+    static constexpr uint32_t SLOTS_PER_PAGE = PAGE_TILES * PAGE_TILES;
+    static constexpr uint32_t PAGE_SIZE = THUMBNAIL_SIZE * PAGE_TILES;
+    static constexpr VkDeviceSize SLOT_BYTES = THUMBNAIL_SIZE * THUMBNAIL_SIZE * 4;
+    static constexpr uint32_t MAX_RESIDENT_PAGES = 8;
+    static constexpr uint32_t MAX_JOBS_IN_FLIGHT = 32;
+    static constexpr uint32_t UPLOADS_PER_FRAME = 16;
+
+    struct Thumbnail {
+        VkDescriptorSet texture;  // ImGui texture id
+        float u0, v0, u1, v1;
+    };
+
+    static bool canGenerate(AssetType type) { return type == AssetType::Texture || type == AssetType::Mesh; }
+
+    void init(VulkanContext* context, Renderer* renderer, JobSystem* jobs, VkDescriptorPool imguiPool, const std::string& directory);
+    void cleanup();
+
+    // After Renderer::beginFrame(): stages finished thumbnails in the frame slot's
+    // upload buffer.
+    void update(uint32_t frameIndex, uint64_t frameNumber);
+
+    // Adds a "thumbnails" pass copying what update() staged into the atlas pages.
+    // Returns the pages written, which the pass drawing them must read
+    // (SampledFragment); the rest stay in SHADER_READ_ONLY_OPTIMAL throughout.
+    std::vector<RenderGraph::ResourceId> addPass(RenderGraph& graph, uint32_t frameIndex);
+
+    // Returns true with the tile if it is on the GPU; otherwise schedules loading or
+    // generating it (when there is room in the job budget) and returns false.
+    bool request(const AssetRecord& asset, const std::string& absolutePath, Thumbnail& thumbnail);
+
+private:
+    static constexpr uint32_t INDEX_MAGIC = 0x48544556;  // "VETH"
+    static constexpr uint32_t INDEX_VERSION = 1;
+    static constexpr uint32_t NO_THUMBNAIL = UINT32_MAX;
+
+    struct Entry {
+        uint32_t location = NO_THUMBNAIL;  // page * SLOTS_PER_PAGE + slot
+        bool onDisk = false;
+        bool pending = false;
+        bool failed = false;
+    };
+
+    struct Completed {
+        uint64_t hash;
+        uint32_t location;
+        bool generated;              // false: read back from disk
+        std::vector<uint8_t> pixels; // empty on failure
+    };
+
+    struct GpuPage {
+        VkImage image = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDescriptorSet descriptor = VK_NULL_HANDLE;
+        std::bitset<SLOTS_PER_PAGE> loaded;
+        uint64_t lastUsedFrame = 0;
+        bool initialized = false;
+    };
+
+    struct Upload {
+        uint32_t page;
+        uint32_t slot;
+        VkDeviceSize offset;  // in the upload buffer
+    };
+
+    struct UploadBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        void* mapped = nullptr;
+    };
+
+    VulkanContext* _vkContext;
+    Renderer* _renderer;
+    JobSystem* _jobs;
+    VkDescriptorPool _imguiPool;
+    VkSampler _sampler;
+    std::string _directory;
+
+    std::unordered_map<uint64_t, Entry> _entries;
+    std::vector<uint32_t> _freeLocations;
+    uint32_t _nextLocation = 0;
+    uint32_t _jobsInFlight = 0;
+
+    std::unordered_map<uint32_t, GpuPage> _pages;
+    UploadBuffer _uploadBuffers[Renderer::MAX_FRAMES_IN_FLIGHT];
+    std::vector<Upload> _uploads;  // staged by update(), copied by addPass()
+    uint64_t _frameNumber = 0;
+
+    std::mutex _completedMutex;
+    std::deque<Completed> _completed;
+    std::mutex _diskMutex;
+
+    GpuPage* residentPage(uint32_t page);
+    void createPage(GpuPage& page);
+    void destroyPage(GpuPage& page);
+    uint32_t allocateLocation();
+
+    std::string pagePath(uint32_t page) const;
+    bool writeSlot(uint32_t location, const std::vector<uint8_t>& pixels);
+    bool readSlot(uint32_t location, std::vector<uint8_t>& pixels);
+    void loadIndex();
+    void saveIndex() const;
+};
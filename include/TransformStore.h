@@ -0,0 +1,89 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "Scene.h"
+#include "Selection.h"
+#include "JobSystem.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// World transform of every entity, indexed by entity id (new entities start at
+// identity). Matrices live in fixed-size pages held by shared_ptr: snapshot() copies
+// only the page pointers, and a page a snapshot still holds is cloned the next time
+// it is written, so a background writer sees a consistent scene while edits go on.
+// Writes are tracked per block of BLOCK_SIZE entities for the GPU copy to follow.
+class TransformStore : public Scene::Listener {
+public:
+    static constexpr uint32_t PAGE_SIZE = 4096;  // entities per page (256 KB)
+    static constexpr uint32_t BLOCK_SIZE = 64;   // entities per dirty bit
+
+    struct Page {
+        glm::mat4 matrices[PAGE_SIZE];
+    };
+
+    struct Snapshot {
+        uint32_t count = 0;  // entities, the root included
+        uint64_t generation = 0;
+        std::vector<std::shared_ptr<const Page>> pages;
+    };
+
+    // Entities [first, first + count).
+    struct Range {
+        Entity first;
+        uint32_t count;
+    };
+
+    void init(Scene* scene);
+
+    uint32_t count() const { return _count; }
+    const glm::mat4& get(Entity entity) const { return _pages[entity / PAGE_SIZE]->matrices[entity % PAGE_SIZE]; }
+    void set(Entity entity, const glm::mat4& matrix);
+
+    // matrix = delta * matrix for every selected entity, as one SIMD pass split
+    // across `jobs` and the calling thread.
+    void applyDelta(const Selection& selection, const glm::mat4& delta, JobSystem& jobs);
+
+    // World-space bounds of the unit cube `matrix` places: its center plus half the
+    // summed absolute axes.
+    static void cubeBounds(const glm::mat4& matrix, glm::vec3& min, glm::vec3& max) {
+        glm::vec3 center(matrix[3]);
+        glm::vec3 extent = 0.5f * (glm::abs(glm::vec3(matrix[0])) + glm::abs(glm::vec3(matrix[1])) + glm::abs(glm::vec3(matrix[2])));
+        min = center - extent;
+        max = center + extent;
+    }
+
+    // cubeBounds() of every selected entity, merged; false if nothing is selected.
+    bool bounds(const Selection& selection, JobSystem& jobs, glm::vec3& min, glm::vec3& max) const;
+
+    // Bumped by every write.
+    uint64_t generation() const { return _generation; }
+    Snapshot snapshot() const;
+
+    // Blocks written since the last call, merged into ranges and clamped to count().
+    void takeDirty(std::vector<Range>& ranges);
+    void markAllDirty();
+    void copy(Range range, glm::mat4* out) const;
+
+    void onEntityCreated(const Scene& scene, Entity entity) override;
+    void onEntityRenamed(const Scene&, Entity, const std::string&) override {}
+
+private:
+    std::vector<std::shared_ptr<Page>> _pages;
+    uint32_t _count = 0;
+    uint64_t _generation = 0;
+    std::vector<uint64_t> _dirty;  // one bit per block
+
+    // Which pages and blocks the selection touches, rebuilt when its membership changes.
+    const Selection* _footprintSelection = nullptr;
+    uint64_t _footprintGeneration = UINT64_MAX;
+    std::vector<uint32_t> _footprintPages;
+    std::vector<uint64_t> _footprintBlocks;
+
+    Page& writablePage(uint32_t page);
+    void markDirty(Entity entity) { _dirty[entity / BLOCK_SIZE / 64] |= 1ull << (entity / BLOCK_SIZE % 64); }
+    void updateFootprint(const Selection& selection);
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include "VulkanContext.h"
+#include "Renderer.h"
+#include "DynamicResolution.h"
+#include "RenderGraph.h"
+#include <functional>
+#include <optional>
+#include <utility>
+
+// Offscreen target behind the Viewport panel. The scene is rendered at a dynamic
+// fraction of the panel size into color / entity-id / depth attachments, then
+// upscaled with a Catmull-Rom filter into a panel-sized image that ImGui displays.
+// All four are render graph transients: the graph does their layout transitions,
+// and the display image shares memory with attachments that are dead by then.
+class ViewportRenderer {
+public:
+    static constexpr VkFormat COLOR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+    static constexpr VkFormat ENTITY_ID_FORMAT = VK_FORMAT_R32_UINT;
+    static constexpr VkFormat DEPTH_FORMAT = VK_FORMAT_D32_SFLOAT;
+
+    void init(VulkanContext* context, VkDescriptorPool imguiPool, bool enableEntityIds = true);
+    void cleanup();
+
+    // Call right after Renderer::beginFrame(): the slot's last frame has completed, so GPU
+    // timings and pick copies recorded in that slot can be read without waiting.
+    void beginFrame(uint32_t frameIndex);
+
+    // Scene work the caller records, inside or between the viewport's passes, and the
+    // graph resources it uses there.
+    struct SceneCallbacks {
+        std::function<void(VkCommandBuffer)> drawEarly;   // inside the scene pass
+        // When set, the scene pass is split in two and this runs in between, with
+        // depth readable from compute through the given view.
+        std::function<void(VkCommandBuffer, VkImageView)> depthPyramid;
+        std::function<void(VkCommandBuffer)> drawLate;    // inside the second half
+        std::function<void(VkCommandBuffer)> overlay;     // last, inside the scene pass
+        std::vector<RenderGraph::Use> drawUses;           // read by both scene halves
+        std::vector<RenderGraph::Use> depthPyramidUses;   // must declare what it writes
+    };
+
+    // Adds the scene pass (or its two halves around `depthPyramid`), the pick copy
+    // when one is pending, and the upscale pass. Returns the display image, which
+    // the pass drawing displayTexture() must read; NO_RESOURCE (and nothing added)
+    // while the panel is collapsed.
+    RenderGraph::ResourceId addPasses(RenderGraph& graph, const SceneCallbacks& callbacks);
+
+    // Panel size in pixels; the targets follow from the next beginFrame().
+    void setPanelSize(uint32_t width, uint32_t height);
+
+    bool hasTarget() const { return _extent.width > 0 && _extent.height > 0; }
+    // Written by the upscale pass, so VK_NULL_HANDLE until this frame slot has run one.
+    VkDescriptorSet displayTexture() const { return _displaySets[_frameIndex]; }
+    VkRenderPass scenePass() const { return _scenePass; }
+    VkExtent2D renderExtent() const { return _renderExtent; }
+    bool entityIdsEnabled() const { return _entityIdsEnabled; }
+    float gpuTimeMs() const { return _gpuTimeMs; }
+    DynamicResolution& resolution() { return _resolution; }
+
+    // (u, v) in [0, 1] across the panel. Only the texel under the cursor is copied
+    // back; the result arrives MAX_FRAMES_IN_FLIGHT frames later. Entity id 0 means "nothing".
+    void requestPick(float u, float v);
+    std::optional<uint32_t> takePickResult();
+
+private:
+    struct PickReadback {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint32_t* mapped = nullptr;
+        bool pending = false;
+    };
+
+    struct UpscalePushConstants {
+        float uvScale[2];
+        float texelSize[2];
+    };
+
+    VulkanContext* _vkContext;
+    VkDescriptorPool _imguiPool;
+    bool _entityIdsEnabled = true;
+
+    enum class ScenePart { Whole, BeforeDepthPyramid, AfterDepthPyramid };
+
+    VkRenderPass _scenePass;
+    VkRenderPass _scenePassBeforePyramid;
+    VkRenderPass _scenePassAfterPyramid;
+    VkRenderPass _upscalePass;
+    VkDescriptorSetLayout _upscaleSetLayout;
+    VkPipelineLayout _upscalePipelineLayout;
+    VkPipeline _upscalePipeline;
+    VkDescriptorPool _descriptorPool;
+    VkSampler _sampler;
+
+    VkQueryPool _queryPool = VK_NULL_HANDLE;
+    float _timestampPeriod = 0.0f;
+    uint64_t _timestampMask = 0;
+    bool _timestampsWritten[Renderer::MAX_FRAMES_IN_FLIGHT] = {};
+    float _gpuTimeMs = 0.0f;
+    DynamicResolution _resolution;
+
+    VkExtent2D _extent{ 0, 0 };
+    VkExtent2D _requestedExtent{ 0, 0 };
+    VkExtent2D _renderExtent{ 0, 0 };
+    uint32_t _frameIndex = 0;
+    // Per frame slot, rewritten each frame with the graph's current image views.
+    VkDescriptorSet _upscaleSets[Renderer::MAX_FRAMES_IN_FLIGHT] = {};
+    VkDescriptorSet _displaySets[Renderer::MAX_FRAMES_IN_FLIGHT] = {};
+
+    PickReadback _pickReadbacks[Renderer::MAX_FRAMES_IN_FLIGHT];
+    std::optional<std::pair<float, float>> _pickRequest;
+    std::optional<uint32_t> _pickResult;
+
+    void createRenderPasses();
+    VkRenderPass createScenePass(ScenePart part);
+    void createUpscalePipeline();
+    void createSampler();
+    void createDescriptorPool();
+    void createDescriptorSets();
+    void createQueryPool();
+    void createPickReadbacks();
+
+    void collectTimings();
+    void collectPickResult();
+    void beginScenePass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer);
+    void recordPickCopy(VkCommandBuffer commandBuffer, VkImage entityId);
+    void recordUpscale(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkImageView color, VkImageView display);
+};
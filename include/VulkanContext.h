@@ -8,24 +8,52 @@
 #include <vector>
 #include <string>
 #include <optional>
+#include <mutex>
+#include <unordered_map>
 
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
 
-    bool isComplete() {
+    bool isComplete() const {
         return graphicsFamily.has_value() && presentFamily.has_value();
     }
 };
 
+// What the surface allows right now: its extent, transform and present modes change
+// with the window, so these are queried each time the swap chain is created.
 struct SwapChainSupportDetails {
     VkSurfaceCapabilitiesKHR capabilities;
-    std::vector<VkSurfaceFormatKHR> formats;
     std::vector<VkPresentModeKHR> presentModes;
 };
 
+// Everything the editor asks about a physical device, queried once per device
+// while picking one and kept for the selected device afterwards.
+struct DeviceCapabilities {
+    VkPhysicalDeviceProperties properties{};
+    VkPhysicalDeviceFeatures features{};
+    VkPhysicalDeviceMemoryProperties memory{};
+    std::vector<VkQueueFamilyProperties> queueFamilies;
+    std::vector<VkExtensionProperties> extensions;
+    QueueFamilyIndices queueIndices;
+    std::vector<VkSurfaceFormatKHR> surfaceFormats;  // fixed for the surface's lifetime
+    bool swapChainAdequate = false;                  // formats and present modes offered when picked
+    bool extensionsSupported = false;  // everything the editor requires
+    bool memoryBudget = false;         // VK_EXT_memory_budget
+    bool timelineSemaphore = false;    // Vulkan 1.2 device with the feature
+    VkDeviceSize deviceLocalBytes = 0;
+
+    bool hasExtension(const char* name) const;
+
+    uint32_t timestampValidBits() const {
+        return queueIndices.graphicsFamily ? queueFamilies[*queueIndices.graphicsFamily].timestampValidBits : 0;
+    }
+};
+
 class VulkanContext {
 public:
+    // Without a window (tests) there is no surface or swap chain, and the graphics
+    // queue stands in for the present queue.
     void init(GLFWwindow* window);
     void cleanup();
 
@@ -38,40 +66,75 @@ public:
     VkSwapchainKHR swapChain() { return _swapChain; }
     VkExtent2D swapChainExtent() { return _swapChainExtent; }
     VkFormat swapChainImageFormat() { return _swapChainImageFormat; }
-    std::vector<VkImageView> swapChainImageViews() { return _swapChainImageViews; }
-    uint32_t graphicsFamilyIndex() { return findQueueFamilies(_physicalDevice).graphicsFamily.value(); }
+    const std::vector<VkImage>& swapChainImages() const { return _swapChainImages; }
+    const std::vector<VkImageView>& swapChainImageViews() const { return _swapChainImageViews; }
+    const DeviceCapabilities& capabilities() const { return _capabilities; }
+    uint32_t graphicsFamilyIndex() const { return _capabilities.queueIndices.graphicsFamily.value(); }
+    bool multiDrawIndirect() const { return _capabilities.features.multiDrawIndirect == VK_TRUE; }
+    bool drawIndirectFirstInstance() const { return _capabilities.features.drawIndirectFirstInstance == VK_TRUE; }
+    VkPipelineCache pipelineCache() const { return _pipelineCache; }
 
+    // Device-local heaps, summed. With VK_EXT_memory_budget the budget is what the OS
+    // currently grants this process and usage includes other allocations; without it,
+    // returns false and leaves both untouched.
+    bool deviceLocalBudget(VkDeviceSize& budget, VkDeviceSize& usage) const;
+
+    // After the surface changed (resize, VK_ERROR_OUT_OF_DATE_KHR). Waits for the
+    // device to go idle and, while the window is minimized, for it to be restored;
+    // the old image views are destroyed, so framebuffers on them must go first.
     void recreateSwapChain(GLFWwindow* window);
 
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+    void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory);
+    void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory);
+    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+    VkShaderModule createShaderModule(const std::string& path);
+
+    // Reads every .spv file in `directory` so createShaderModule() skips the disk.
+    // Safe to call from a worker thread before or during init().
+    void preloadShaders(const std::string& directory);
+
+    // Seeds the pipeline cache with data from a previous run; data from another
+    // driver or GPU is dropped. Call after init().
+    void createPipelineCache(const std::vector<char>& initialData);
+    std::vector<char> pipelineCacheData() const;
+
 private:
     VkInstance _instance;
     VkDebugUtilsMessengerEXT _debugMessenger;
-    VkSurfaceKHR _surface;
+    VkSurfaceKHR _surface = VK_NULL_HANDLE;
 
     VkPhysicalDevice _physicalDevice = VK_NULL_HANDLE;
+    DeviceCapabilities _capabilities;
     VkDevice _device;
+    VkPipelineCache _pipelineCache = VK_NULL_HANDLE;
+
+    std::mutex _shaderCodeMutex;
+    std::unordered_map<std::string, std::vector<char>> _shaderCode;
 
     VkQueue _graphicsQueue;
     VkQueue _presentQueue;
 
-    VkSwapchainKHR _swapChain;
+    VkSwapchainKHR _swapChain = VK_NULL_HANDLE;
     std::vector<VkImage> _swapChainImages;
     VkFormat _swapChainImageFormat;
     VkExtent2D _swapChainExtent;
     std::vector<VkImageView> _swapChainImageViews;
 
-    void createInstance();
+    void createInstance(bool presentable);
     void setupDebugMessenger();
     void createSurface(GLFWwindow* window);
     void pickPhysicalDevice();
     void createLogicalDevice();
     void createSwapChain(GLFWwindow* window);
     void createImageViews();
+    void destroyImageViews();
 
-    bool isDeviceSuitable(VkPhysicalDevice device);
-    QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
-    bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    DeviceCapabilities queryCapabilities(VkPhysicalDevice device);
+    static uint64_t scoreDevice(const DeviceCapabilities& capabilities);
+    QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, const std::vector<VkQueueFamilyProperties>& queueFamilies);
     SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
+    std::vector<VkSurfaceFormatKHR> querySurfaceFormats(VkPhysicalDevice device);
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow* window);
@@ -0,0 +1,65 @@
+#pragma once
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include "TransformStore.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The world split into square cells on the XZ plane. A cell records the bounds
+// of its contents and what it costs in CPU and GPU memory while loaded; which
+// cells actually are loaded is up to WorldStreamer.
+class WorldPartition {
+public:
+    struct Cell {
+        glm::ivec2 coord{ 0 };
+        glm::vec3 boundsMin{ 0.0f };
+        glm::vec3 boundsMax{ 0.0f };
+        uint64_t cpuBytes = 0;
+        uint64_t gpuBytes = 0;
+        std::string payload;  // what the streaming loader reads; empty for generated worlds
+    };
+
+    // fromScene() payloads are packed arrays of these.
+    struct SceneEntry {
+        Entity entity;
+        float position[3];
+    };
+
+    explicit WorldPartition(float cellSize = 64.0f) : _cellSize(cellSize) {}
+
+    // Replaces any cell already at the same coordinate. Returns its index.
+    uint32_t addCell(const Cell& cell);
+
+    float cellSize() const { return _cellSize; }
+    uint32_t cellCount() const { return static_cast<uint32_t>(_cells.size()); }
+    const Cell& cell(uint32_t index) const { return _cells[index]; }
+    uint64_t totalBytes() const { return _totalBytes; }
+
+    // Cells whose footprint comes within `radius` of `center` on XZ. Cost is
+    // proportional to the area covered, not to the size of the world.
+    void cellsNear(const glm::vec3& center, float radius, std::vector<uint32_t>& out) const;
+
+    // Square world of `cellsPerSide`^2 cells with pseudo-random (but seeded)
+    // heights and sizes averaging `averageBytes`, split 3:1 between GPU and CPU.
+    static WorldPartition synthetic(uint32_t cellsPerSide, float cellSize, uint64_t averageBytes, uint64_t seed);
+
+    // Every mesh entity of `scene`, in the cell its position falls in. A cell's
+    // bounds enclose its entities' unit cubes; it costs its payload in CPU memory
+    // and one instance matrix per entity in GPU memory.
+    static WorldPartition fromScene(const Scene& scene, const TransformStore& transforms, float cellSize = 64.0f);
+
+private:
+    float _cellSize;
+    std::vector<Cell> _cells;
+    std::unordered_map<uint64_t, uint32_t> _byCoord;
+    uint64_t _totalBytes = 0;
+
+    static uint64_t key(glm::ivec2 coord) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(coord.x)) << 32) | static_cast<uint32_t>(coord.y);
+    }
+};
@@ -0,0 +1,180 @@
+#pragma once
+
+#include "VulkanContext.h"
+#include "Renderer.h"
+#include "JobSystem.h"
+#include "WorldPartition.h"
+#include "Camera.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Pages WorldPartition cells in and out around the camera without letting the
+// loaded set exceed a CPU and a GPU memory budget. A cell's bytes are reserved
+// when its load starts, so in-flight loads can never overshoot; when the
+// budget is full, lower-priority residents are evicted to make room for
+// higher-priority cells. Priority is distance to the cell's bounds, scaled up
+// for cells outside the view frustum.
+//
+// Loads run on JobSystem workers; only commit (upload) and release run on the
+// main thread, and commits are capped by bytes per frame so that crossing into
+// a dense area spreads over several frames instead of stalling one.
+//
+// The GPU budget comes from VK_EXT_memory_budget when the device has it
+// (the headroom left by everything else, times deviceBudgetFraction) and from
+// Settings::gpuBudget otherwise.
+class WorldStreamer {
+public:
+    struct Settings {
+        float loadRadius = 256.0f;
+        float unloadRadius = 320.0f;          // > loadRadius, so cells on the edge don't flicker
+        float offscreenPenalty = 2.0f;        // distance multiplier outside the frustum
+        uint32_t maxConcurrentLoads = 4;
+        uint64_t commitBytesPerFrame = 64ull << 20;
+        uint64_t cpuBudget = 4ull << 30;
+        uint64_t gpuBudget = 1ull << 30;      // without VK_EXT_memory_budget
+        float deviceBudgetFraction = 0.5f;
+    };
+
+    // load runs on a worker and returns false on failure (the cell is not
+    // retried). commit and release run on the main thread; release undoes load,
+    // and commit if it ran, and must defer freeing GPU resources that frames in
+    // flight may still use.
+    struct Callbacks {
+        std::function<bool(uint32_t cell, const WorldPartition::Cell&)> load;
+        std::function<void(uint32_t cell)> commit;
+        std::function<void(uint32_t cell)> release;
+    };
+
+    struct Stats {
+        uint32_t resident = 0;
+        uint32_t loading = 0;          // includes loaded cells waiting for a commit slot
+        uint64_t cpuBytes = 0;         // reserved, loading or loaded
+        uint64_t gpuBytes = 0;         // reserved, plus released bytes frames in flight may still use
+        uint64_t cpuBudget = 0;
+        uint64_t gpuBudget = 0;
+        uint64_t committedBytes = 0;   // this frame
+        uint32_t committedCells = 0;   // this frame
+        uint64_t loadsStarted = 0;
+        uint64_t evictions = 0;
+        bool deviceBudget = false;
+    };
+
+    struct CameraSample {
+        glm::vec3 eye;
+        glm::vec3 target;
+    };
+
+    struct ReplayFrame {
+        uint32_t resident;
+        uint32_t loading;
+        uint64_t cpuBytes;
+        uint64_t gpuBytes;
+        uint64_t committedBytes;
+        uint32_t committedCells;
+        uint64_t loadsStarted;
+        uint64_t evictions;
+        uint64_t residentHash;   // order-independent hash of the resident set
+    };
+
+    WorldStreamer() = default;
+    WorldStreamer(const WorldStreamer&) = delete;
+    WorldStreamer& operator=(const WorldStreamer&) = delete;
+
+    void init(VulkanContext* context, JobSystem* jobs);
+    void cleanup();
+
+    // Waits for loads still running and releases everything loaded from the
+    // previous world. A null world stops streaming.
+    void setWorld(std::shared_ptr<const WorldPartition> world, const Callbacks& callbacks);
+    bool active() const { return _world != nullptr; }
+
+    Settings& settings() { return _settings; }
+    const Stats& stats() const { return _stats; }
+
+    // Once per frame on the main thread.
+    void update(const Camera& camera, uint64_t frameNumber);
+
+    // Drives a streamer along `path` with loads completing exactly
+    // `loadLatencyFrames` after they start instead of on workers, so the same
+    // inputs always give the same frames.
+    static std::vector<ReplayFrame> replay(std::shared_ptr<const WorldPartition> world, const Settings& settings,
+                                           const std::vector<CameraSample>& path, uint32_t loadLatencyFrames);
+
+    // A low pass over `world` that sweeps across most of it in `frames` frames.
+    static std::vector<CameraSample> flythrough(const WorldPartition& world, uint32_t frames);
+
+private:
+    enum class CellState : uint8_t { Unloaded, Loading, Loaded, Resident };
+
+    struct CellRuntime {
+        CellState state = CellState::Unloaded;
+        bool cancelled = false;   // left range while loading; dropped when the load finishes
+        bool failed = false;
+        float priority = 0.0f;
+    };
+
+    struct Completion {
+        uint32_t cell;
+        bool succeeded;
+    };
+
+    // Shared with the load jobs so they never point into the streamer itself.
+    struct CompletionQueue {
+        std::mutex mutex;
+        std::condition_variable pushed;
+        std::deque<Completion> completed;
+    };
+
+    struct SimulatedLoad {
+        uint64_t readyFrame;
+        uint32_t cell;
+    };
+
+    struct PendingFree {
+        uint64_t bytes;
+        uint64_t releaseFrame;
+    };
+
+    VulkanContext* _vkContext = nullptr;
+    JobSystem* _jobs = nullptr;
+    Settings _settings;
+    Stats _stats;
+
+    std::shared_ptr<const WorldPartition> _world;
+    Callbacks _callbacks;
+    std::shared_ptr<CompletionQueue> _completions;
+    std::vector<CellRuntime> _cells;
+    std::vector<uint32_t> _active;        // every cell not Unloaded
+    std::deque<uint32_t> _commitQueue;    // Loaded, in completion order
+    std::vector<PendingFree> _pendingFree;
+    std::vector<uint32_t> _candidates;
+    uint32_t _loadsInFlight = 0;
+    uint64_t _cpuUsed = 0;
+    uint64_t _gpuUsed = 0;
+    uint64_t _gpuPendingFree = 0;
+    uint64_t _gpuCommitted = 0;           // Resident cells only: what the device actually holds
+    uint64_t _frameNumber = 0;
+
+    uint64_t _deviceGpuBudget = 0;
+    uint64_t _budgetQueriedFrame = UINT64_MAX;
+
+    // Replay only: no workers, loads complete after a fixed number of frames.
+    bool _simulated = false;
+    uint32_t _simulatedLatency = 0;
+    std::vector<SimulatedLoad> _simulatedLoads;
+
+    static constexpr uint64_t BUDGET_QUERY_INTERVAL = 16;  // frames
+
+    void refreshBudgets();
+    void drainCompletions();
+    void startLoad(uint32_t cell);
+    void evict(uint32_t cell);
+    bool makeRoom(uint64_t cpuBytes, uint64_t gpuBytes, float priority);
+    void commitLoaded();
+    void releaseAll();
+    float priority(const WorldPartition::Cell& cell, const glm::vec3& eye, const glm::vec4 (&planes)[4]) const;
+};
@@ -0,0 +1,28 @@
+#version 450
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewProj;
+} pc;
+
+// One instance per box; the 24 line-list vertices are generated from gl_VertexIndex.
+layout(location = 0) in vec3 inMin;
+layout(location = 1) in vec4 inColor;
+layout(location = 2) in vec3 inMax;
+
+layout(location = 0) out vec4 fragColor;
+
+// Corner index bits: x = 1, y = 2, z = 4.
+const int edgeCorners[24] = int[24](
+    0, 1, 2, 3, 4, 5, 6, 7,
+    0, 2, 1, 3, 4, 6, 5, 7,
+    0, 4, 1, 5, 2, 6, 3, 7
+);
+
+void main() {
+    int corner = edgeCorners[gl_VertexIndex];
+    vec3 position = vec3((corner & 1) != 0 ? inMax.x : inMin.x,
+                         (corner & 2) != 0 ? inMax.y : inMin.y,
+                         (corner & 4) != 0 ? inMax.z : inMin.z);
+    gl_Position = pc.viewProj * vec4(position, 1.0);
+    fragColor = inColor;
+}
@@ -1,21 +1,50 @@
 #version 450
 
+layout(set = 1, binding = 0) uniform ShadowData {
+    mat4 cascadeMatrices[4];   // world -> atlas UV + depth, one per cascade
+    vec4 splitDepths;          // view-space distance where each cascade ends
+    vec4 lightDirection;       // towards the light
+    vec4 atlasTexelSize;
+} shadow;
+layout(set = 1, binding = 1) uniform sampler2DShadow staticShadowAtlas;
+layout(set = 1, binding = 2) uniform sampler2DShadow dynamicShadowAtlas;
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragNormal;
 layout(location = 2) in vec3 fragPos;
+layout(location = 3) flat in uint fragEntityId;
+layout(location = 4) in float fragViewDepth;
 
 layout(location = 0) out vec4 outColor;
+layout(location = 1) out uint outEntityId;
 
-const vec3 lightPos = vec3(10.0, 10.0, 10.0);
 const vec3 lightColor = vec3(1.0, 1.0, 1.0);
 const vec3 ambientColor = vec3(0.2, 0.2, 0.2);
 
+float shadowVisibility() {
+    if (fragViewDepth > shadow.splitDepths[3]) return 1.0;
+    int cascade = 0;
+    for (int i = 0; i < 3; i++) {
+        if (fragViewDepth > shadow.splitDepths[i]) cascade = i + 1;
+    }
+
+    vec4 coord = shadow.cascadeMatrices[cascade] * vec4(fragPos, 1.0);
+    // Keep the 2x2 PCF footprint inside this cascade's quarter of the atlas.
+    vec2 tileMin = vec2(cascade & 1, cascade >> 1) * 0.5 + shadow.atlasTexelSize.xy;
+    vec2 tileMax = tileMin + 0.5 - 2.0 * shadow.atlasTexelSize.xy;
+    coord.xy = clamp(coord.xy, tileMin, tileMax);
+
+    // Static and dynamic casters live in separate atlases; lit only if neither occludes.
+    return min(texture(staticShadowAtlas, coord.xyz), texture(dynamicShadowAtlas, coord.xyz));
+}
+
 void main() {
     vec3 norm = normalize(fragNormal);
-    vec3 lightDir = normalize(lightPos - fragPos);
+    vec3 lightDir = normalize(shadow.lightDirection.xyz);
     float diff = max(dot(norm, lightDir), 0.0);
-    vec3 diffuse = diff * lightColor;
+    vec3 diffuse = diff * lightColor * shadowVisibility();
     
     vec3 result = (ambientColor + diffuse) * fragColor;
     outColor = vec4(result, 1.0);
+    outEntityId = fragEntityId;
 }
@@ -1,10 +1,18 @@
 #version 450
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
+// World transform of every entity, indexed by entity id (InstanceBuffer).
+layout(set = 0, binding = 0) readonly buffer Transforms {
+    mat4 transforms[];
+};
+// Entity drawn by each instance (MeshRenderer's draw list).
+layout(set = 0, binding = 1) readonly buffer DrawList {
+    uint entities[];
+};
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewProjection;
     mat4 view;
-    mat4 proj;
-} ubo;
+} pc;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
@@ -13,10 +21,18 @@ layout(location = 2) in vec3 inNormal;
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragNormal;
 layout(location = 2) out vec3 fragPos;
+layout(location = 3) flat out uint fragEntityId;
+layout(location = 4) out float fragViewDepth;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    uint entity = entities[gl_InstanceIndex];
+    mat4 model = transforms[entity];
+    vec4 worldPos = model * vec4(inPosition, 1.0);
+
+    gl_Position = pc.viewProjection * worldPos;
     fragColor = inColor;
-    fragNormal = mat3(transpose(inverse(ubo.model))) * inNormal;
-    fragPos = vec3(ubo.model * vec4(inPosition, 1.0));
+    fragNormal = mat3(transpose(inverse(model))) * inNormal;
+    fragPos = worldPos.xyz;
+    fragViewDepth = -(pc.view * worldPos).z;
+    fragEntityId = entity;
 }
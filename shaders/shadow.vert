@@ -0,0 +1,20 @@
+#version 450
+
+// Same bindings as mesh.vert's set 0, so the caster's sets bind here unchanged.
+layout(set = 0, binding = 0) readonly buffer Transforms {
+    mat4 transforms[];
+};
+layout(set = 0, binding = 1) readonly buffer DrawList {
+    uint entities[];
+};
+
+layout(push_constant) uniform PushConstants {
+    mat4 lightViewProjection;
+} pc;
+
+layout(location = 0) in vec3 inPosition;
+
+void main() {
+    mat4 model = transforms[entities[gl_InstanceIndex]];
+    gl_Position = pc.lightViewProjection * model * vec4(inPosition, 1.0);
+}
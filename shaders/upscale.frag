@@ -0,0 +1,54 @@
+#version 450
+
+layout(binding = 0) uniform sampler2D sceneColor;
+
+layout(push_constant) uniform PushConstants {
+    vec2 uvScale;      // rendered region / allocated size
+    vec2 texelSize;    // 1 / allocated size
+} pc;
+
+layout(location = 0) in vec2 fragUV;
+
+layout(location = 0) out vec4 outColor;
+
+vec4 sampleClamped(vec2 uv) {
+    // Texels outside the rendered region hold stale data from larger scales.
+    vec2 lo = 0.5 * pc.texelSize;
+    vec2 hi = pc.uvScale - 0.5 * pc.texelSize;
+    return textureLod(sceneColor, clamp(uv, lo, hi), 0.0);
+}
+
+// Catmull-Rom bicubic using 9 bilinear taps instead of 16 point samples.
+void main() {
+    vec2 texSize = 1.0 / pc.texelSize;
+    vec2 samplePos = fragUV * pc.uvScale * texSize;
+    vec2 texPos1 = floor(samplePos - 0.5) + 0.5;
+    vec2 f = samplePos - texPos1;
+
+    vec2 w0 = f * (-0.5 + f * (1.0 - 0.5 * f));
+    vec2 w1 = 1.0 + f * f * (-2.5 + 1.5 * f);
+    vec2 w2 = f * (0.5 + f * (2.0 - 1.5 * f));
+    vec2 w3 = f * f * (-0.5 + 0.5 * f);
+
+    vec2 w12 = w1 + w2;
+    vec2 offset12 = w2 / w12;
+
+    vec2 texPos0 = (texPos1 - 1.0) * pc.texelSize;
+    vec2 texPos3 = (texPos1 + 2.0) * pc.texelSize;
+    vec2 texPos12 = (texPos1 + offset12) * pc.texelSize;
+
+    vec4 result = vec4(0.0);
+    result += sampleClamped(vec2(texPos0.x, texPos0.y)) * w0.x * w0.y;
+    result += sampleClamped(vec2(texPos12.x, texPos0.y)) * w12.x * w0.y;
+    result += sampleClamped(vec2(texPos3.x, texPos0.y)) * w3.x * w0.y;
+
+    result += sampleClamped(vec2(texPos0.x, texPos12.y)) * w0.x * w12.y;
+    result += sampleClamped(vec2(texPos12.x, texPos12.y)) * w12.x * w12.y;
+    result += sampleClamped(vec2(texPos3.x, texPos12.y)) * w3.x * w12.y;
+
+    result += sampleClamped(vec2(texPos0.x, texPos3.y)) * w0.x * w3.y;
+    result += sampleClamped(vec2(texPos12.x, texPos3.y)) * w12.x * w3.y;
+    result += sampleClamped(vec2(texPos3.x, texPos3.y)) * w3.x * w3.y;
+
+    outColor = vec4(max(result.rgb, 0.0), 1.0);
+}
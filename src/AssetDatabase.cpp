@@ -0,0 +1,474 @@
+#include "AssetDatabase.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string toLower(std::string text) {
+    for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+std::string extensionOf(const std::string& path) {
+    std::string extension = fs::path(path).extension().string();
+    return toLower(extension.empty() ? extension : extension.substr(1));
+}
+
+uint64_t hashFile(const fs::path& file) {
+    uint64_t hash = 14695981039346656037ull;
+    std::ifstream stream(file, std::ios::binary);
+    if (!stream.is_open()) return 0;
+    char buffer[64 * 1024];
+    while (stream) {
+        stream.read(buffer, sizeof(buffer));
+        for (std::streamsize i = 0; i < stream.gcount(); i++) {
+            hash = (hash ^ static_cast<uint8_t>(buffer[i])) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+// References in the text formats we know about: OBJ material libraries, MTL texture
+// maps, glTF buffer/image URIs and #include in shader sources. Returned as written.
+std::vector<std::string> findReferences(const fs::path& file, const std::string& extension) {
+    std::vector<std::string> references;
+    bool obj = extension == "obj", mtl = extension == "mtl", gltf = extension == "gltf";
+    bool shader = extension == "vert" || extension == "frag" || extension == "comp" || extension == "glsl";
+    if (!obj && !mtl && !gltf && !shader) return references;
+
+    std::ifstream stream(file);
+    std::string line;
+    while (std::getline(stream, line)) {
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+        if (obj && keyword == "mtllib") {
+            std::string name;
+            while (tokens >> name) references.push_back(name);
+        } else if (mtl && (keyword.rfind("map_", 0) == 0 || keyword == "bump" || keyword == "disp" || keyword == "norm")) {
+            // Options such as "-bm 0.5" come first; the file name is the last token.
+            std::string token, last;
+            while (tokens >> token) last = token;
+            if (!last.empty()) references.push_back(last);
+        } else if (shader && keyword == "#include") {
+            size_t open = line.find_first_of("\"<"), close = line.find_last_of("\">");
+            if (open != std::string::npos && close > open) references.push_back(line.substr(open + 1, close - open - 1));
+        } else if (gltf) {
+            for (size_t key = line.find("\"uri\""); key != std::string::npos; key = line.find("\"uri\"", key + 5)) {
+                size_t open = line.find('"', line.find(':', key) + 1);
+                size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+                if (close == std::string::npos) break;
+                std::string uri = line.substr(open + 1, close - open - 1);
+                if (uri.rfind("data:", 0) != 0) references.push_back(uri);
+            }
+        }
+    }
+    return references;
+}
+
+bool writeFileReplacing(const std::string& path, const std::vector<char>& data) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(data.data(), data.size())) return false;
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    if (error) {
+        fs::remove(path, error);
+        fs::rename(temporary, path, error);
+    }
+    return !error;
+}
+
+class IndexReader {
+public:
+    explicit IndexReader(const std::vector<char>& data) : _data(data) {}
+
+    template <typename T>
+    bool read(T& value) {
+        if (_offset + sizeof(T) > _data.size()) return false;
+        std::memcpy(&value, _data.data() + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return true;
+    }
+
+    bool read(std::string& text) {
+        uint16_t length;
+        if (!read(length) || _offset + length > _data.size()) return false;
+        text.assign(_data.data() + _offset, length);
+        _offset += length;
+        return true;
+    }
+
+private:
+    const std::vector<char>& _data;
+    size_t _offset = 0;
+};
+
+template <typename T>
+void writeValue(std::vector<char>& out, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void writeString(std::vector<char>& out, const std::string& text) {
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(text.size(), UINT16_MAX));
+    writeValue(out, length);
+    out.insert(out.end(), text.begin(), text.begin() + length);
+}
+
+} // namespace
+
+const char* AssetDatabase::typeName(AssetType type) {
+    switch (type) {
+    case AssetType::Texture: return "Texture";
+    case AssetType::Mesh: return "Mesh";
+    case AssetType::Material: return "Material";
+    case AssetType::Shader: return "Shader";
+    case AssetType::Audio: return "Audio";
+    default: return "File";
+    }
+}
+
+AssetType AssetDatabase::typeFromPath(const std::string& path) {
+    static const std::unordered_map<std::string, AssetType> types = {
+        { "png", AssetType::Texture }, { "jpg", AssetType::Texture }, { "jpeg", AssetType::Texture },
+        { "tga", AssetType::Texture }, { "bmp", AssetType::Texture }, { "psd", AssetType::Texture },
+        { "gif", AssetType::Texture }, { "hdr", AssetType::Texture }, { "ktx", AssetType::Texture },
+        { "dds", AssetType::Texture },
+        { "obj", AssetType::Mesh }, { "gltf", AssetType::Mesh }, { "glb", AssetType::Mesh }, { "fbx", AssetType::Mesh },
+        { "mtl", AssetType::Material }, { "mat", AssetType::Material },
+        { "vert", AssetType::Shader }, { "frag", AssetType::Shader }, { "comp", AssetType::Shader },
+        { "glsl", AssetType::Shader }, { "hlsl", AssetType::Shader }, { "spv", AssetType::Shader },
+        { "wav", AssetType::Audio }, { "ogg", AssetType::Audio }, { "mp3", AssetType::Audio }, { "flac", AssetType::Audio }
+    };
+    auto it = types.find(extensionOf(path));
+    return it != types.end() ? it->second : AssetType::Unknown;
+}
+
+void AssetDatabase::open(const std::string& root, JobSystem* jobs) {
+    _jobs = jobs;
+    std::error_code error;
+    if (!fs::is_directory(root, error)) return;
+
+    _root = fs::path(root).generic_string();
+    while (_root.size() > 1 && _root.back() == '/') _root.pop_back();
+    fs::create_directories(metadataDirectory(_root), error);
+    if (!loadIndex()) {
+        _records.clear();
+        _byPath.clear();
+    }
+    _open = true;
+    _generation++;
+}
+
+void AssetDatabase::startWatching() {
+    if (!_open) return;
+    // Watch first so nothing that changes during the reconcile walk is missed.
+    _watcher.start(_root);
+    reconcile();
+}
+
+void AssetDatabase::close() {
+    _closing = true;
+    _watcher.stop();
+    if (_open && _dirty) {
+        saveIndex(true);
+    } else if (_save.valid()) {
+        _save.wait();
+    }
+}
+
+std::optional<AssetId> AssetDatabase::find(const std::string& path) const {
+    auto it = _byPath.find(path);
+    if (it == _byPath.end()) return std::nullopt;
+    return it->second;
+}
+
+bool AssetDatabase::isMetadata(const std::string& path) const {
+    return path == ".editor" || path.rfind(".editor/", 0) == 0;
+}
+
+void AssetDatabase::update() {
+    if (!_open) return;
+
+    std::vector<std::string> changes;
+    if (!_watcher.poll(changes)) {
+        reconcile();
+        changes.clear();
+    }
+    if (!changes.empty()) {
+        std::sort(changes.begin(), changes.end());
+        changes.erase(std::unique(changes.begin(), changes.end()), changes.end());
+        changes.erase(std::remove_if(changes.begin(), changes.end(), [this](const std::string& path) { return isMetadata(path); }), changes.end());
+        for (size_t start = 0; start < changes.size(); start += SCAN_BATCH) {
+            size_t end = std::min(start + SCAN_BATCH, changes.size());
+            scanFiles(std::vector<std::string>(changes.begin() + start, changes.begin() + end));
+        }
+    }
+
+    std::vector<ScanResult> results;
+    {
+        std::lock_guard<std::mutex> lock(_resultsMutex);
+        results.swap(_results);
+    }
+    for (auto& result : results) apply(result);
+    if (!results.empty()) {
+        _generation++;
+        _dirty = true;
+    }
+
+    // Saved as soon as the index settles, so a crash does not cost the next launch a rehash.
+    if (_dirty && _pendingScans == 0) saveIndex(false);
+}
+
+void AssetDatabase::reconcile() {
+    // Snapshot on the main thread; the walk compares against it without touching _records.
+    auto known = std::make_shared<std::unordered_map<std::string, std::pair<uint64_t, int64_t>>>();
+    known->reserve(_byPath.size());
+    for (const auto& [path, id] : _byPath) {
+        known->emplace(path, std::make_pair(_records[id].size, _records[id].modifiedTime));
+    }
+
+    _pendingScans++;
+    _jobs->submit([this, known] {
+        fs::path root(_root);
+        std::vector<std::string> batch;
+        std::error_code error;
+        auto it = fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied, error);
+        for (; !error && it != fs::recursive_directory_iterator() && !_closing; it.increment(error)) {
+            std::error_code statError;
+            if (it->is_directory(statError)) {
+                if (it.depth() == 0 && it->path().filename() == ".editor") it.disable_recursion_pending();
+                continue;
+            }
+            if (!it->is_regular_file(statError)) continue;
+
+            std::string path = it->path().lexically_relative(root).generic_string();
+            uint64_t size = it->file_size(statError);
+            int64_t modified = it->last_write_time(statError).time_since_epoch().count();
+            auto found = known->find(path);
+            if (found != known->end()) {
+                bool unchanged = !statError && found->second == std::make_pair(size, modified);
+                known->erase(found);
+                if (unchanged) continue;
+            }
+
+            batch.push_back(std::move(path));
+            if (batch.size() == SCAN_BATCH) {
+                scanFiles(std::move(batch));
+                batch.clear();
+            }
+        }
+        if (!batch.empty()) scanFiles(std::move(batch));
+
+        // Indexed files the walk did not find were deleted while the editor was closed.
+        // An interrupted walk proves nothing, so it removes nothing.
+        if (!error && !_closing) {
+            std::lock_guard<std::mutex> lock(_resultsMutex);
+            for (auto& [path, state] : *known) _results.push_back({ path, false, {} });
+        }
+        _pendingScans--;
+    });
+}
+
+void AssetDatabase::scanFiles(std::vector<std::string> paths) {
+    _pendingScans += static_cast<uint32_t>(paths.size());
+    _jobs->submit([this, paths = std::move(paths)] {
+        std::vector<ScanResult> results;
+        for (const auto& path : paths) {
+            fs::path file = fs::path(_root) / path;
+            std::error_code error;
+            if (_closing) {
+                // Skip the work but keep the counter balanced.
+            } else if (fs::is_directory(file, error)) {
+                // A folder was created, moved in or renamed: index everything under it.
+                for (auto it = fs::recursive_directory_iterator(file, fs::directory_options::skip_permission_denied, error);
+                     !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+                    std::error_code statError;
+                    if (it->is_regular_file(statError)) {
+                        results.push_back(scanFile(it->path().lexically_relative(_root).generic_string()));
+                    }
+                }
+            } else {
+                results.push_back(scanFile(path));
+            }
+            _pendingScans--;
+        }
+        std::lock_guard<std::mutex> lock(_resultsMutex);
+        std::move(results.begin(), results.end(), std::back_inserter(_results));
+    });
+}
+
+AssetDatabase::ScanResult AssetDatabase::scanFile(const std::string& path) const {
+    ScanResult result;
+    result.path = path;
+
+    fs::path file = fs::path(_root) / path;
+    std::error_code error;
+    if (!fs::is_regular_file(file, error)) return result;  // deleted (or a folder that was)
+
+    // Size and mtime are taken before hashing, so a write that lands mid-hash
+    // leaves a stale mtime behind and is picked up again.
+    AssetRecord& record = result.record;
+    record.path = path;
+    record.size = fs::file_size(file, error);
+    record.modifiedTime = fs::last_write_time(file, error).time_since_epoch().count();
+    record.type = typeFromPath(path);
+    record.contentHash = hashFile(file);
+
+    fs::path folder = fs::path(path).parent_path();
+    for (const auto& reference : findReferences(file, extensionOf(path))) {
+        std::string dependency = (folder / fs::path(reference)).lexically_normal().generic_string();
+        if (dependency.rfind("..", 0) != 0) record.dependencies.push_back(std::move(dependency));
+    }
+    result.exists = true;
+    return result;
+}
+
+void AssetDatabase::apply(ScanResult& result) {
+    if (!result.exists) {
+        remove(result.path);
+        return;
+    }
+
+    AssetId id;
+    auto it = _byPath.find(result.path);
+    if (it != _byPath.end()) {
+        id = it->second;
+    } else {
+        if (!_freeIds.empty()) {
+            id = _freeIds.back();
+            _freeIds.pop_back();
+        } else {
+            id = static_cast<AssetId>(_records.size());
+            _records.emplace_back();
+        }
+        _byPath.emplace(result.path, id);
+    }
+    _records[id] = std::move(result.record);
+    _records[id].alive = true;
+}
+
+void AssetDatabase::remove(const std::string& path) {
+    auto release = [this](AssetId id) {
+        _records[id] = AssetRecord{};
+        _freeIds.push_back(id);
+    };
+
+    auto it = _byPath.find(path);
+    if (it != _byPath.end()) {
+        release(it->second);
+        _byPath.erase(it);
+        return;
+    }
+    // Not a file we know, so possibly a deleted folder.
+    std::string prefix = path + "/";
+    for (auto child = _byPath.begin(); child != _byPath.end();) {
+        if (child->first.compare(0, prefix.size(), prefix) == 0) {
+            release(child->second);
+            child = _byPath.erase(child);
+        } else {
+            ++child;
+        }
+    }
+}
+
+void AssetDatabase::list(const std::string& folder, const std::string& filter, std::optional<AssetType> type,
+                         std::vector<std::string>& folders, std::vector<AssetId>& assets) const {
+    folders.clear();
+    assets.clear();
+    std::string prefix = folder.empty() ? folder : folder + "/";
+    std::string needle = toLower(filter);
+    std::set<std::string> children;
+
+    for (const auto& [path, id] : _byPath) {
+        if (path.compare(0, prefix.size(), prefix) != 0) continue;
+        size_t slash = path.find('/', prefix.size());
+        if (needle.empty() && slash != std::string::npos) {
+            children.insert(path.substr(prefix.size(), slash - prefix.size()));
+            continue;
+        }
+        if (type && _records[id].type != *type) continue;
+        if (!needle.empty() && toLower(path.substr(path.find_last_of('/') + 1)).find(needle) == std::string::npos) continue;
+        assets.push_back(id);
+    }
+
+    folders.assign(children.begin(), children.end());
+    std::sort(assets.begin(), assets.end(), [this](AssetId a, AssetId b) { return _records[a].path < _records[b].path; });
+}
+
+bool AssetDatabase::loadIndex() {
+    std::ifstream file(indexPath(), std::ios::ate | std::ios::binary);
+    if (!file.is_open()) return false;
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+
+    IndexReader reader(data);
+    uint32_t magic, version, count;
+    if (!reader.read(magic) || !reader.read(version) || !reader.read(count)) return false;
+    if (magic != INDEX_MAGIC || version != INDEX_VERSION) return false;
+
+    _records.resize(count);
+    _byPath.reserve(count);
+    for (uint32_t id = 0; id < count; id++) {
+        AssetRecord& record = _records[id];
+        uint8_t type;
+        uint16_t dependencyCount;
+        if (!reader.read(record.path) || !reader.read(record.size) || !reader.read(record.modifiedTime) ||
+            !reader.read(record.contentHash) || !reader.read(type) || !reader.read(dependencyCount)) {
+            return false;
+        }
+        record.type = type < static_cast<uint8_t>(AssetType::Count) ? static_cast<AssetType>(type) : AssetType::Unknown;
+        record.dependencies.resize(dependencyCount);
+        for (auto& dependency : record.dependencies) {
+            if (!reader.read(dependency)) return false;
+        }
+        record.alive = true;
+        _byPath.emplace(record.path, id);
+    }
+    return true;
+}
+
+std::vector<char> AssetDatabase::serializeIndex() const {
+    std::vector<char> out;
+    out.reserve(_byPath.size() * 64);
+    writeValue(out, INDEX_MAGIC);
+    writeValue(out, INDEX_VERSION);
+    writeValue(out, static_cast<uint32_t>(_byPath.size()));
+    for (const auto& record : _records) {
+        if (!record.alive) continue;
+        writeString(out, record.path);
+        writeValue(out, record.size);
+        writeValue(out, record.modifiedTime);
+        writeValue(out, record.contentHash);
+        writeValue(out, static_cast<uint8_t>(record.type));
+        uint16_t dependencyCount = static_cast<uint16_t>(std::min<size_t>(record.dependencies.size(), UINT16_MAX));
+        writeValue(out, dependencyCount);
+        for (uint16_t i = 0; i < dependencyCount; i++) writeString(out, record.dependencies[i]);
+    }
+    return out;
+}
+
+void AssetDatabase::saveIndex(bool wait) {
+    if (_save.valid()) {
+        if (!wait && _save.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;  // retried next frame
+        _save.get();
+    }
+    _dirty = false;
+    std::vector<char> data = serializeIndex();
+    if (wait) {
+        writeFileReplacing(indexPath(), data);
+    } else {
+        _save = _jobs->submit([path = indexPath(), data = std::move(data)] { writeFileReplacing(path, data); });
+    }
+}
@@ -0,0 +1,80 @@
+#include "Autosave.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+// "VETR", then a version, the entity count and one column-major mat4 per entity.
+static constexpr uint32_t AUTOSAVE_MAGIC = 0x52544556;
+static constexpr uint32_t AUTOSAVE_VERSION = 1;
+
+void Autosave::init(JobSystem* jobs, std::string path, const TransformStore& transforms) {
+    _jobs = jobs;
+    _path = std::move(path);
+    // The scene as opened needs no saving.
+    _savedGeneration = transforms.generation();
+    _lastAttempt = Clock::now();
+}
+
+void Autosave::cleanup() {
+    if (_save.valid()) finishSave();
+}
+
+void Autosave::finishSave() {
+    _stats = _save.get();
+    if (_stats.failed) return;  // the edits stay unsaved and are retried next interval
+    _savedGeneration = _savingGeneration;
+    _lastSave = Clock::now();
+    _hasSaved = true;
+}
+
+void Autosave::update(const TransformStore& transforms, bool editing) {
+    if (!enabled()) return;
+    if (_save.valid()) {
+        if (_save.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        finishSave();
+    }
+    if (editing || transforms.generation() == _savedGeneration) return;
+    if (Clock::now() - _lastAttempt < INTERVAL) return;
+
+    _lastAttempt = Clock::now();
+    _savingGeneration = transforms.generation();
+    _save = _jobs->submit([path = _path, snapshot = transforms.snapshot()] { return write(path, snapshot); });
+}
+
+double Autosave::secondsSinceSave() const {
+    if (!_hasSaved) return -1.0;
+    return std::chrono::duration<double>(Clock::now() - _lastSave).count();
+}
+
+Autosave::Stats Autosave::write(const std::string& path, const TransformStore::Snapshot& snapshot) {
+    auto start = Clock::now();
+    Stats stats;
+    std::error_code error;
+    fs::create_directories(fs::path(path).parent_path(), error);
+
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        uint32_t header[3] = { AUTOSAVE_MAGIC, AUTOSAVE_VERSION, snapshot.count };
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (uint32_t first = 0; first < snapshot.count; first += TransformStore::PAGE_SIZE) {
+            uint32_t count = std::min(TransformStore::PAGE_SIZE, snapshot.count - first);
+            file.write(reinterpret_cast<const char*>(snapshot.pages[first / TransformStore::PAGE_SIZE]->matrices), count * sizeof(glm::mat4));
+        }
+        stats.failed = !file;
+    }
+    if (!stats.failed) {
+        fs::rename(temporary, path, error);
+        if (error) {
+            fs::remove(path, error);
+            fs::rename(temporary, path, error);
+        }
+        stats.failed = static_cast<bool>(error);
+    }
+
+    stats.bytes = sizeof(uint32_t) * 3 + static_cast<uint64_t>(snapshot.count) * sizeof(glm::mat4);
+    stats.writeMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return stats;
+}
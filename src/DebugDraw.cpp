@@ -0,0 +1,293 @@
+#include "DebugDraw.h"
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+
+uint32_t DebugDraw::rgba(float r, float g, float b, float a) {
+    auto channel = [](float value) { return static_cast<uint32_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f)); };
+    return channel(r) | (channel(g) << 8) | (channel(b) << 16) | (channel(a) << 24);
+}
+
+void DebugDraw::init(VulkanContext* context, VkRenderPass scenePass, bool hasEntityIdAttachment) {
+    _vkContext = context;
+    createPipelines(scenePass, hasEntityIdAttachment);
+    createBuffers();
+    beginFrame(0);
+}
+
+void DebugDraw::cleanup() {
+    VkDevice device = _vkContext->device();
+    for (auto& frame : _frames) {
+        vkUnmapMemory(device, frame.memory);
+        vkDestroyBuffer(device, frame.buffer, nullptr);
+        vkFreeMemory(device, frame.memory, nullptr);
+    }
+    vkDestroyPipeline(device, _boxPipeline, nullptr);
+    vkDestroyPipeline(device, _trianglePipeline, nullptr);
+    vkDestroyPipeline(device, _linePipeline, nullptr);
+    vkDestroyPipelineLayout(device, _pipelineLayout, nullptr);
+}
+
+void DebugDraw::createBuffers() {
+    // Host-visible and coherent: submissions write straight into memory the GPU reads,
+    // so there is no staging copy and no flush call per frame.
+    for (auto& frame : _frames) {
+        _vkContext->createBuffer(FRAME_BUFFER_SIZE, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            frame.buffer, frame.memory);
+        vkMapMemory(_vkContext->device(), frame.memory, 0, FRAME_BUFFER_SIZE, 0, reinterpret_cast<void**>(&frame.mapped));
+    }
+}
+
+void DebugDraw::createPipelines(VkRenderPass scenePass, bool hasEntityIdAttachment) {
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.size = sizeof(glm::mat4);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(_vkContext->device(), &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create debug draw pipeline layout!");
+    }
+
+    VkVertexInputBindingDescription vertexBinding{};
+    vertexBinding.binding = 0;
+    vertexBinding.stride = sizeof(Vertex);
+    vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription vertexAttributes[2]{};
+    vertexAttributes[0] = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) };
+    vertexAttributes[1] = { 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(Vertex, color) };
+
+    VkVertexInputBindingDescription boxBinding{};
+    boxBinding.binding = 0;
+    boxBinding.stride = sizeof(BoxInstance);
+    boxBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+
+    VkVertexInputAttributeDescription boxAttributes[3]{};
+    boxAttributes[0] = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(BoxInstance, min) };
+    boxAttributes[1] = { 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(BoxInstance, color) };
+    boxAttributes[2] = { 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(BoxInstance, max) };
+
+    _linePipeline = createPipeline(scenePass, hasEntityIdAttachment, VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
+        "shaders/debug.vert.spv", vertexBinding, vertexAttributes, 2);
+    _trianglePipeline = createPipeline(scenePass, hasEntityIdAttachment, VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+        "shaders/debug.vert.spv", vertexBinding, vertexAttributes, 2);
+    _boxPipeline = createPipeline(scenePass, hasEntityIdAttachment, VK_PRIMITIVE_TOPOLOGY_LINE_LIST,
+        "shaders/debug_box.vert.spv", boxBinding, boxAttributes, 3);
+}
+
+VkPipeline DebugDraw::createPipeline(VkRenderPass scenePass, bool hasEntityIdAttachment, VkPrimitiveTopology topology,
+                                     const char* vertexShader, const VkVertexInputBindingDescription& binding,
+                                     const VkVertexInputAttributeDescription* attributes, uint32_t attributeCount) {
+    VkDevice device = _vkContext->device();
+    VkShaderModule vertModule = _vkContext->createShaderModule(vertexShader);
+    VkShaderModule fragModule = _vkContext->createShaderModule("shaders/debug.frag.spv");
+
+    VkPipelineShaderStageCreateInfo shaderStages[2]{};
+    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = vertModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = fragModule;
+    shaderStages[1].pName = "main";
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &binding;
+    vertexInputInfo.vertexAttributeDescriptionCount = attributeCount;
+    vertexInputInfo.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = topology;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // Debug geometry is depth-tested against the scene but never occludes it.
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_FALSE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    VkPipelineColorBlendAttachmentState blendAttachments[2]{};
+    blendAttachments[0].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blendAttachments[0].blendEnable = VK_TRUE;
+    blendAttachments[0].srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blendAttachments[0].dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendAttachments[0].colorBlendOp = VK_BLEND_OP_ADD;
+    blendAttachments[0].srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    blendAttachments[0].dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    blendAttachments[0].alphaBlendOp = VK_BLEND_OP_ADD;
+    // Leave the entity-id attachment untouched so debug lines are never picked.
+    blendAttachments[1].colorWriteMask = 0;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.attachmentCount = hasEntityIdAttachment ? 2 : 1;
+    colorBlending.pAttachments = blendAttachments;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = _pipelineLayout;
+    pipelineInfo.renderPass = scenePass;
+    pipelineInfo.subpass = 0;
+
+    VkPipeline pipeline;
+    VkResult result = vkCreateGraphicsPipelines(device, _vkContext->pipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+    vkDestroyShaderModule(device, fragModule, nullptr);
+    vkDestroyShaderModule(device, vertModule, nullptr);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create debug draw pipeline!");
+    }
+    return pipeline;
+}
+
+void DebugDraw::beginFrame(uint32_t frameIndex) {
+    _frameIndex = frameIndex;
+    uint8_t* mapped = _frames[frameIndex].mapped;
+    _lineVertices = reinterpret_cast<Vertex*>(mapped + LINE_OFFSET);
+    _triangleVertices = reinterpret_cast<Vertex*>(mapped + TRIANGLE_OFFSET);
+    _boxes = reinterpret_cast<BoxInstance*>(mapped + BOX_OFFSET);
+    _lineVertexCount.store(0, std::memory_order_relaxed);
+    _triangleVertexCount.store(0, std::memory_order_relaxed);
+    _boxCount.store(0, std::memory_order_relaxed);
+    _dropped.store(0, std::memory_order_relaxed);
+}
+
+void DebugDraw::flush(VkCommandBuffer commandBuffer, const glm::mat4& viewProjection) {
+    VkBuffer buffer = _frames[_frameIndex].buffer;
+    uint32_t lineVertices = std::min(_lineVertexCount.load(), MAX_LINE_VERTICES);
+    uint32_t triangleVertices = std::min(_triangleVertexCount.load(), MAX_TRIANGLE_VERTICES);
+    uint32_t boxes = std::min(_boxCount.load(), MAX_BOXES);
+
+    vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &viewProjection);
+
+    if (triangleVertices > 0) {
+        VkDeviceSize offset = TRIANGLE_OFFSET;
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _trianglePipeline);
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+        vkCmdDraw(commandBuffer, triangleVertices, 1, 0, 0);
+    }
+    if (lineVertices > 0) {
+        VkDeviceSize offset = LINE_OFFSET;
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _linePipeline);
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+        vkCmdDraw(commandBuffer, lineVertices, 1, 0, 0);
+    }
+    if (boxes > 0) {
+        VkDeviceSize offset = BOX_OFFSET;
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _boxPipeline);
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &buffer, &offset);
+        vkCmdDraw(commandBuffer, 24, boxes, 0, 0);
+    }
+}
+
+void DebugDraw::line(const glm::vec3& a, const glm::vec3& b, uint32_t color) {
+    uint32_t index = _lineVertexCount.fetch_add(2, std::memory_order_relaxed);
+    if (index + 2 > MAX_LINE_VERTICES) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _lineVertices[index] = { a, color };
+    _lineVertices[index + 1] = { b, color };
+}
+
+void DebugDraw::triangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, uint32_t color) {
+    uint32_t index = _triangleVertexCount.fetch_add(3, std::memory_order_relaxed);
+    if (index + 3 > MAX_TRIANGLE_VERTICES) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _triangleVertices[index] = { a, color };
+    _triangleVertices[index + 1] = { b, color };
+    _triangleVertices[index + 2] = { c, color };
+}
+
+void DebugDraw::point(const glm::vec3& position, float size, uint32_t color) {
+    // Drawn as a three-axis cross so points share the line draw instead of needing their own.
+    float half = size * 0.5f;
+    line(position - glm::vec3(half, 0.0f, 0.0f), position + glm::vec3(half, 0.0f, 0.0f), color);
+    line(position - glm::vec3(0.0f, half, 0.0f), position + glm::vec3(0.0f, half, 0.0f), color);
+    line(position - glm::vec3(0.0f, 0.0f, half), position + glm::vec3(0.0f, 0.0f, half), color);
+}
+
+void DebugDraw::aabb(const glm::vec3& min, const glm::vec3& max, uint32_t color) {
+    // 32 bytes per box instead of 24 line vertices; the edges are expanded in the vertex shader.
+    uint32_t index = _boxCount.fetch_add(1, std::memory_order_relaxed);
+    if (index >= MAX_BOXES) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    _boxes[index] = { min, color, max, 0.0f };
+}
+
+void DebugDraw::box(const glm::mat4& transform, uint32_t color) {
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 local((i & 1) ? 0.5f : -0.5f, (i & 2) ? 0.5f : -0.5f, (i & 4) ? 0.5f : -0.5f, 1.0f);
+        glm::vec4 world = transform * local;
+        corners[i] = glm::vec3(world) / world.w;
+    }
+    static const int edges[12][2] = {
+        {0, 1}, {2, 3}, {4, 5}, {6, 7},
+        {0, 2}, {1, 3}, {4, 6}, {5, 7},
+        {0, 4}, {1, 5}, {2, 6}, {3, 7}
+    };
+    for (const auto& edge : edges) line(corners[edge[0]], corners[edge[1]], color);
+}
+
+void DebugDraw::frustum(const glm::mat4& viewProjection, uint32_t color) {
+    // Unproject the NDC cube (Vulkan depth range 0..1) and draw it as a box.
+    box(glm::inverse(viewProjection) * glm::mat4(
+        glm::vec4(2.0f, 0.0f, 0.0f, 0.0f),
+        glm::vec4(0.0f, 2.0f, 0.0f, 0.0f),
+        glm::vec4(0.0f, 0.0f, 1.0f, 0.0f),
+        glm::vec4(0.0f, 0.0f, 0.5f, 1.0f)), color);
+}
+
+void DebugDraw::grid(float halfExtent, float spacing, uint32_t color, uint32_t axisColor) {
+    int lineCount = static_cast<int>(halfExtent / spacing);
+    for (int i = -lineCount; i <= lineCount; i++) {
+        float offset = i * spacing;
+        uint32_t lineColor = i == 0 ? axisColor : color;
+        line(glm::vec3(offset, 0.0f, -halfExtent), glm::vec3(offset, 0.0f, halfExtent), lineColor);
+        line(glm::vec3(-halfExtent, 0.0f, offset), glm::vec3(halfExtent, 0.0f, offset), lineColor);
+    }
+}
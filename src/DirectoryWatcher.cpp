@@ -0,0 +1,311 @@
+#include "DirectoryWatcher.h"
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <CoreServices/CoreServices.h>
+#include <dispatch/dispatch.h>
+#endif
+
+namespace fs = std::filesystem;
+
+void DirectoryWatcher::start(const std::string& root) {
+    stop();
+    _root = root;
+#ifdef _WIN32
+    _stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (_stopEvent == nullptr) {
+        throw std::runtime_error("failed to create directory watcher event!");
+    }
+#elif defined(__linux__)
+    _stopEvent = eventfd(0, EFD_CLOEXEC);
+    if (_stopEvent < 0) {
+        throw std::runtime_error("failed to create directory watcher event!");
+    }
+#endif
+    _running = true;
+    _thread = std::thread(&DirectoryWatcher::watch, this);
+}
+
+void DirectoryWatcher::stop() {
+    if (!_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _stopped.notify_all();
+#ifdef _WIN32
+    SetEvent(_stopEvent);
+#elif defined(__linux__)
+    uint64_t one = 1;
+    ssize_t written = write(_stopEvent, &one, sizeof(one));
+    (void)written;
+#endif
+    _thread.join();
+#ifdef _WIN32
+    CloseHandle(_stopEvent);
+    _stopEvent = nullptr;
+#elif defined(__linux__)
+    close(_stopEvent);
+    _stopEvent = -1;
+#endif
+}
+
+bool DirectoryWatcher::poll(std::vector<std::string>& changedPaths) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    changedPaths.insert(changedPaths.end(), std::make_move_iterator(_changes.begin()), std::make_move_iterator(_changes.end()));
+    _changes.clear();
+    bool complete = !_overflowed;
+    _overflowed = false;
+    return complete;
+}
+
+void DirectoryWatcher::push(std::string path) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _changes.push_back(std::move(path));
+}
+
+#ifdef _WIN32
+
+void DirectoryWatcher::watch() {
+    HANDLE directory = CreateFileW(fs::path(_root).wstring().c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (directory == INVALID_HANDLE_VALUE) return;
+
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    std::vector<DWORD> buffer(16 * 1024);  // 64 KiB, DWORD-aligned as the API requires
+    const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                         FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE;
+
+    while (_running) {
+        ResetEvent(overlapped.hEvent);
+        if (!ReadDirectoryChangesW(directory, buffer.data(), static_cast<DWORD>(buffer.size() * sizeof(DWORD)), TRUE, filter, nullptr, &overlapped, nullptr)) break;
+
+        HANDLE handles[2] = { overlapped.hEvent, static_cast<HANDLE>(_stopEvent) };
+        DWORD signaled = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        DWORD bytes = 0;
+        if (signaled != WAIT_OBJECT_0) {
+            CancelIo(directory);
+            GetOverlappedResult(directory, &overlapped, &bytes, TRUE);
+            break;
+        }
+        if (!GetOverlappedResult(directory, &overlapped, &bytes, FALSE)) break;
+
+        // Zero bytes means the change buffer overflowed and events were dropped.
+        if (bytes == 0) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _overflowed = true;
+            continue;
+        }
+
+        const char* entry = reinterpret_cast<const char*>(buffer.data());
+        for (;;) {
+            const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(entry);
+            std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+            push(fs::path(name).generic_string());
+            if (info->NextEntryOffset == 0) break;
+            entry += info->NextEntryOffset;
+        }
+    }
+
+    CloseHandle(overlapped.hEvent);
+    CloseHandle(directory);
+}
+
+#else
+
+void DirectoryWatcher::watch() {
+    if (!watchNative()) pollTree();
+}
+
+#if defined(__linux__)
+
+bool DirectoryWatcher::watchNative() {
+    int inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify < 0) return false;
+
+    // inotify is not recursive: every directory gets its own watch, keyed back to its
+    // path relative to the root. Re-adding a moved directory returns its old
+    // descriptor, which then maps to the new path.
+    const uint32_t mask = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+    std::unordered_map<int, std::string> directories;
+    auto addWatches = [&](const std::string& relative) {
+        fs::path directory = relative.empty() ? fs::path(_root) : fs::path(_root) / relative;
+        int descriptor = inotify_add_watch(inotify, directory.c_str(), mask);
+        if (descriptor < 0) return errno != ENOSPC;  // gone already is fine; out of watches is not
+        directories[descriptor] = relative;
+        std::error_code error;
+        for (auto it = fs::recursive_directory_iterator(directory, fs::directory_options::skip_permission_denied, error);
+             !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+            std::error_code statError;
+            if (!it->is_directory(statError) || it->is_symlink(statError)) continue;
+            descriptor = inotify_add_watch(inotify, it->path().c_str(), mask);
+            if (descriptor < 0) {
+                if (errno == ENOSPC) return false;
+                continue;
+            }
+            directories[descriptor] = it->path().lexically_relative(_root).generic_string();
+        }
+        return true;
+    };
+
+    bool watching = addWatches("");
+    alignas(inotify_event) char buffer[64 * 1024];
+    pollfd descriptors[2] = { { inotify, POLLIN, 0 }, { _stopEvent, POLLIN, 0 } };
+    while (watching && _running) {
+        if (::poll(descriptors, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            watching = false;
+            break;
+        }
+        if (descriptors[1].revents != 0) break;
+
+        ssize_t bytes;
+        while (watching && (bytes = read(inotify, buffer, sizeof(buffer))) > 0) {
+            for (const char* entry = buffer; entry < buffer + bytes;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(entry);
+                entry += sizeof(inotify_event) + event->len;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    _overflowed = true;
+                    continue;
+                }
+                if (event->mask & IN_IGNORED) {
+                    directories.erase(event->wd);
+                    continue;
+                }
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0) continue;
+
+                std::string path = directory->second.empty() ? std::string(event->name) : directory->second + '/' + event->name;
+                // Files can land in a new directory before its watch does; the directory
+                // is reported whole, so those are picked up by the caller's scan of it.
+                if ((event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) watching = addWatches(path);
+                push(std::move(path));
+            }
+        }
+    }
+
+    close(inotify);
+    if (!watching) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _overflowed = true;
+    }
+    return watching;
+}
+
+#elif defined(__APPLE__)
+
+bool DirectoryWatcher::watchNative() {
+    // FSEvents reports resolved paths (/private/var for /var), so the root is resolved too.
+    std::error_code error;
+    fs::path root = fs::canonical(_root, error);
+    if (error) return false;
+
+    struct Context {
+        DirectoryWatcher* watcher;
+        fs::path root;
+    } context{ this, root };
+    auto callback = [](ConstFSEventStreamRef, void* info, size_t count, void* eventPaths,
+                       const FSEventStreamEventFlags flags[], const FSEventStreamEventId[]) {
+        auto* context = static_cast<Context*>(info);
+        char** paths = static_cast<char**>(eventPaths);
+        const FSEventStreamEventFlags dropped = kFSEventStreamEventFlagMustScanSubDirs |
+            kFSEventStreamEventFlagUserDropped | kFSEventStreamEventFlagKernelDropped;
+        for (size_t i = 0; i < count; i++) {
+            if (flags[i] & dropped) {
+                std::lock_guard<std::mutex> lock(context->watcher->_mutex);
+                context->watcher->_overflowed = true;
+                continue;
+            }
+            std::string path = fs::path(paths[i]).lexically_relative(context->root).generic_string();
+            if (!path.empty() && path != ".") context->watcher->push(std::move(path));
+        }
+    };
+
+    FSEventStreamContext streamContext{ 0, &context, nullptr, nullptr, nullptr };
+    CFStringRef rootString = CFStringCreateWithCString(nullptr, root.c_str(), kCFStringEncodingUTF8);
+    CFArrayRef paths = CFArrayCreate(nullptr, reinterpret_cast<const void**>(&rootString), 1, &kCFTypeArrayCallBacks);
+    FSEventStreamRef stream = FSEventStreamCreate(nullptr, callback, &streamContext, paths, kFSEventStreamEventIdSinceNow,
+        0.1, kFSEventStreamCreateFlagFileEvents | kFSEventStreamCreateFlagNoDefer);
+    CFRelease(paths);
+    CFRelease(rootString);
+    if (stream == nullptr) return false;
+
+    dispatch_queue_t queue = dispatch_queue_create("DirectoryWatcher", DISPATCH_QUEUE_SERIAL);
+    FSEventStreamSetDispatchQueue(stream, queue);
+    bool started = FSEventStreamStart(stream);
+    if (started) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stopped.wait(lock, [this] { return !_running; });
+        }
+        FSEventStreamStop(stream);
+    }
+    FSEventStreamInvalidate(stream);
+    FSEventStreamRelease(stream);
+    // Drains a callback still running on the queue before `context` goes away.
+    dispatch_sync_f(queue, nullptr, [](void*) {});
+    dispatch_release(queue);
+    return started;
+}
+
+#else
+
+bool DirectoryWatcher::watchNative() {
+    return false;
+}
+
+#endif
+
+void DirectoryWatcher::pollTree() {
+    struct FileState {
+        uintmax_t size;
+        fs::file_time_type modified;
+    };
+    std::unordered_map<std::string, FileState> known;
+    bool firstPass = true;
+
+    while (_running) {
+        std::unordered_map<std::string, FileState> current;
+        std::error_code error;
+        for (auto it = fs::recursive_directory_iterator(_root, fs::directory_options::skip_permission_denied, error);
+             !error && it != fs::recursive_directory_iterator(); it.increment(error)) {
+            if (!it->is_regular_file(error)) continue;
+            FileState state{ it->file_size(error), it->last_write_time(error) };
+            if (error) continue;
+            std::string path = it->path().lexically_relative(_root).generic_string();
+            if (!firstPass) {
+                auto previous = known.find(path);
+                if (previous == known.end() || previous->second.size != state.size || previous->second.modified != state.modified) {
+                    push(path);
+                }
+            }
+            current.emplace(std::move(path), state);
+        }
+        if (!firstPass) {
+            for (const auto& [path, state] : known) {
+                if (current.find(path) == current.end()) push(path);
+            }
+        }
+        known = std::move(current);
+        firstPass = false;
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        _stopped.wait_for(lock, POLL_INTERVAL, [this] { return !_running; });
+    }
+}
+
+#endif
@@ -0,0 +1,39 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+void DynamicResolution::setScaleRange(float minScale, float maxScale) {
+    _minScale = minScale;
+    _maxScale = std::max(minScale, maxScale);
+    _scale = std::clamp(_scale, _minScale, _maxScale);
+}
+
+void DynamicResolution::update(float gpuMs) {
+    if (gpuMs <= 0.0f) return;
+    _smoothedMs = _smoothedMs == 0.0f ? gpuMs : _smoothedMs + (gpuMs - _smoothedMs) * 0.1f;
+
+    if (!_enabled) {
+        _scale = _maxScale;
+        return;
+    }
+    // Give the GPU a few frames at the new size before judging it again.
+    if (_cooldown > 0) {
+        _cooldown--;
+        return;
+    }
+
+    float desired = _scale * std::sqrt(_targetMs / _smoothedMs);
+    float next = _scale;
+    if (_smoothedMs > _targetMs) {
+        next = std::floor(desired / SCALE_STEP) * SCALE_STEP;
+    } else if (_smoothedMs < _targetMs * 0.85f) {
+        next = std::min(desired, _scale + MAX_SCALE_UP_PER_STEP);
+        next = std::floor(next / SCALE_STEP) * SCALE_STEP;
+    }
+    next = std::clamp(next, _minScale, _maxScale);
+
+    if (next != _scale) {
+        _scale = next;
+        _cooldown = SETTLE_FRAMES;
+    }
+}
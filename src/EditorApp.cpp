@@ -1,17 +1,140 @@
 #include "EditorApp.h"
 #include "Renderer.h"
+#include "ViewportRenderer.h"
+#include "RenderGraph.h"
+#include "RenderGraphExecutor.h"
+#include "InstanceBuffer.h"
+#include "DebugDraw.h"
+#include "ShadowRenderer.h"
+#include "MeshRenderer.h"
+#include "OcclusionCuller.h"
+#include "ThumbnailCache.h"
+#include "WorldStreamer.h"
 #include "Camera.h"
 #include <ImGuizmo.h>
 #include <stdexcept>
 #include <array>
+#include <atomic>
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
 #include <glm/gtc/type_ptr.hpp>
 
 Renderer _renderer;
+RenderGraph _frameGraph;
+RenderGraphExecutor _graphExecutor;
+InstanceBuffer _instances;
+ViewportRenderer _viewport;
+DebugDraw _debugDraw;
+ShadowRenderer _shadows;
+MeshRenderer _meshes;
+OcclusionCuller _culler;
+ThumbnailCache _thumbnails;
+WorldStreamer _streamer;
+// Loaded data of each cell of the streamed world; committed once streamed in.
+struct StreamedCell {
+    std::vector<WorldPartition::SceneEntry> entries;
+    bool committed = false;
+};
+std::vector<StreamedCell> _streamedCells;
+uint32_t _streamedEntities = 0;                 // in committed cells
+uint64_t _streamedGeneration = UINT64_MAX;      // of _transforms when the world was built
 Camera _camera;
-glm::mat4 _modelMatrix = glm::mat4(1.0f) {
-    initWindow();
-    initVulkan();
-    initImGui();
+bool _transformEditing = false;
+glm::vec3 _editStartMin, _editStartMax;
+uint64_t _staticShadowsGeneration = UINT64_MAX;  // of _transforms, as far as the static shadow cache knows
+// World AABBs of the selected meshes, rebuilt when the selection or a transform
+// changes. Past SELECTION_BOX_LIMIT meshes only their union is drawn.
+struct SelectionBox {
+    Entity entity;
+    glm::vec3 min, max;
+};
+constexpr size_t SELECTION_BOX_LIMIT = 4096;
+std::vector<SelectionBox> _selectionBoxes;
+uint32_t _selectionMeshes = 0;
+glm::vec3 _selectionMin, _selectionMax;          // union of the selected meshes' bounds
+uint64_t _selectionBoxesGeneration = UINT64_MAX;  // of _selection
+uint64_t _selectionBoxesTransforms = UINT64_MAX;  // of _transforms
+uint64_t _culledDrawList = UINT64_MAX;            // MeshRenderer::drawListVersion() the culler's objects follow
+uint64_t _culledTransforms = UINT64_MAX;          // of _transforms
+bool _showShadowCascades = false;
+bool _pickToggles = false;  // the pending Viewport pick was a Ctrl-click
+
+static const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+static const char* SHADER_DIRECTORY = "shaders";
+
+// Empty when the file does not exist yet.
+static std::vector<char> readBinaryFile(const char* path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) return {};
+    std::vector<char> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(data.data(), data.size());
+    return data;
+}
+
+void EditorApp::run(const LaunchOptions& options) {
+    _options = options;
+    _startupTrace.setEnabled(options.startupTrace);
+
+    // Stages that only need files or CPU memory run on workers while this
+    // thread creates the window and the device (GLFW must stay on the main thread).
+    auto pipelineCacheData = _jobs.submit([this] {
+        StartupTrace::Stage stage(_startupTrace, "Pipeline cache load");
+        return readBinaryFile(PIPELINE_CACHE_PATH);
+    });
+    auto shaders = _jobs.submit([this] {
+        StartupTrace::Stage stage(_startupTrace, "Shader loading");
+        _vkContext.preloadShaders(SHADER_DIRECTORY);
+    });
+    // Reads the saved index only; bringing it up to date happens in the background later.
+    auto assetIndex = _jobs.submit([this] {
+        StartupTrace::Stage stage(_startupTrace, "Asset index");
+        _assets.open(_options.projectRoot, &_jobs);
+    });
+
+    {
+        StartupTrace::Stage stage(_startupTrace, "Window");
+        initWindow();
+    }
+    initImGuiContext();
+    ImFontAtlas* fontAtlas = ImGui::GetIO().Fonts;
+    auto fonts = _jobs.submit([this, fontAtlas] {
+        // The atlas is not touched on the main thread until this job is joined.
+        StartupTrace::Stage stage(_startupTrace, "Font atlas build");
+        unsigned char* pixels;
+        int width, height;
+        fontAtlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+    });
+
+    {
+        StartupTrace::Stage stage(_startupTrace, "Vulkan device");
+        _vkContext.init(_window);
+        _vkContext.createPipelineCache(pipelineCacheData.get());
+    }
+    shaders.get();
+    {
+        StartupTrace::Stage stage(_startupTrace, "Renderers");
+        initVulkan();
+    }
+    fonts.get();
+    {
+        StartupTrace::Stage stage(_startupTrace, "ImGui backend");
+        initImGui();
+    }
+    {
+        StartupTrace::Stage stage(_startupTrace, "Scene");
+        initScene();
+    }
+    assetIndex.get();
+    _assets.startWatching();
+    // Kept with the project's metadata; without a project there is nowhere to put it.
+    _autosave.init(&_jobs, _assets.isOpen() ? AssetDatabase::metadataDirectory(_options.projectRoot) + "/autosave.bin" : std::string(), _transforms);
     mainLoop();
     cleanup();
 }
@@ -23,8 +146,7 @@ void EditorApp::initWindow() {
 }
 
 void EditorApp::initVulkan() {
-    _vkContext.init(_window);
-    _renderer.init(&_vkContext);
+    _renderer.init(&_vkContext, _window);
 
     // Create Descriptor Pool for ImGui
     VkDescriptorPoolSize pool_sizes[] = {
@@ -49,9 +171,19 @@ void EditorApp::initVulkan() {
     if (vkCreateDescriptorPool(_vkContext.device(), &pool_info, nullptr, &_imguiPool) != VK_SUCCESS) {
         throw std::runtime_error("failed to create descriptor pool!");
     }
+
+    _graphExecutor.init(&_vkContext, &_renderer);
+    _instances.init(&_vkContext, &_renderer);
+    _viewport.init(&_vkContext, _imguiPool);
+    _debugDraw.init(&_vkContext, _viewport.scenePass(), _viewport.entityIdsEnabled());
+    _shadows.init(&_vkContext);
+    _meshes.init(&_vkContext, &_scene, _viewport.scenePass(), _viewport.entityIdsEnabled(), _shadows.descriptorSetLayout());
+    _culler.init(&_vkContext);
+    _thumbnails.init(&_vkContext, &_renderer, &_jobs, _imguiPool, AssetDatabase::metadataDirectory(_options.projectRoot) + "/thumbnails");
+    _streamer.init(&_vkContext, &_jobs);
 }
 
-void EditorApp::initImGui() {
+void EditorApp::initImGuiContext() {
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
@@ -68,7 +200,9 @@ void EditorApp::initImGui() {
     style.ScrollbarRounding = 0.0f;
     style.Colors[ImGuiCol_Text] = ImVec4(0.90f, 0.90f, 0.90f, 1.00f);
     style.Colors[ImGuiCol_WindowBg] = ImVec4(0.09f, 0.09f, 0.09f, 1.00f);
+}
 
+void EditorApp::initImGui() {
     ImGui_ImplGlfw_InitForVulkan(_window, true);
     ImGui_ImplVulkan_InitInfo init_info = {};
     init_info.Instance = _vkContext.instance();
@@ -76,7 +210,7 @@ void EditorApp::initImGui() {
     init_info.Device = _vkContext.device();
     init_info.QueueFamily = _vkContext.graphicsFamilyIndex();
     init_info.Queue = _vkContext.graphicsQueue();
-    init_info.PipelineCache = VK_NULL_HANDLE;
+    init_info.PipelineCache = _vkContext.pipelineCache();
     init_info.DescriptorPool = _imguiPool;
     init_info.Subpass = 0;
     init_info.MinImageCount = 2;
@@ -94,15 +228,141 @@ void EditorApp::initImGui() {
 }
 
 void EditorApp::mainLoop() {
+    if (!glfwWindowShouldClose(_window)) {
+        {
+            StartupTrace::Stage stage(_startupTrace, "First frame");
+            glfwPollEvents();
+            drawFrame();
+        }
+        if (_startupTrace.enabled()) _startupTrace.print(std::cout);
+    }
     while (!glfwWindowShouldClose(_window)) {
+        _renderer.pace();
         glfwPollEvents();
         drawFrame();
     }
     vkDeviceWaitIdle(_vkContext.device());
 }
 
+// The streamed world is the scene's mesh entities, partitioned by position. It is
+// rebuilt when the transforms have changed, but not in the middle of an edit, so a
+// drag costs one rebuild when it ends rather than one per frame.
+void EditorApp::updateStreamingWorld() {
+    if (_transformEditing || _transforms.generation() == _streamedGeneration) return;
+    _streamedGeneration = _transforms.generation();
+    auto world = std::make_shared<const WorldPartition>(WorldPartition::fromScene(_scene, _transforms));
+
+    // setWorld() has every load finished before it releases the old world's cells
+    // and starts none itself, so _streamedCells is only resized while nothing reads it.
+    WorldStreamer::Callbacks callbacks;
+    callbacks.load = [](uint32_t cell, const WorldPartition::Cell& data) {
+        if (data.payload.size() % sizeof(WorldPartition::SceneEntry) != 0) return false;
+        std::vector<WorldPartition::SceneEntry>& entries = _streamedCells[cell].entries;
+        entries.resize(data.payload.size() / sizeof(WorldPartition::SceneEntry));
+        std::memcpy(entries.data(), data.payload.data(), data.payload.size());
+        return true;
+    };
+    callbacks.commit = [](uint32_t cell) {
+        _streamedCells[cell].committed = true;
+        _streamedEntities += static_cast<uint32_t>(_streamedCells[cell].entries.size());
+    };
+    callbacks.release = [](uint32_t cell) {
+        if (_streamedCells[cell].committed) _streamedEntities -= static_cast<uint32_t>(_streamedCells[cell].entries.size());
+        _streamedCells[cell] = {};
+    };
+    _streamer.setWorld(world, callbacks);
+    _streamedCells.assign(world->cellCount(), {});
+}
+
+// Culling object i is instance i of the mesh draw list, bounded by its cube. A new
+// draw list starts visibility over; moved transforms only refit the bounds, so a drag
+// keeps what was visible. Past MAX_OBJECTS meshes, or on a device that cannot start
+// indirect draws at an instance, the culler is emptied and the scene pass draws
+// every mesh in its one instanced draw.
+void EditorApp::updateCullingObjects() {
+    bool drawListChanged = _meshes.drawListVersion() != _culledDrawList;
+    if (!drawListChanged && _transforms.generation() == _culledTransforms) return;
+    _culledDrawList = _meshes.drawListVersion();
+    _culledTransforms = _transforms.generation();
+
+    const std::vector<Entity>& drawList = _meshes.drawList();
+    bool cullable = drawList.size() <= OcclusionCuller::MAX_OBJECTS && _vkContext.drawIndirectFirstInstance();
+    std::vector<OcclusionCuller::Bounds> bounds(cullable ? drawList.size() : 0);
+    for (size_t i = 0; i < bounds.size(); i++) {
+        glm::vec3 min, max;
+        TransformStore::cubeBounds(_transforms.get(drawList[i]), min, max);
+        bounds[i] = { glm::vec4(min, 0.0f), glm::vec4(max, 0.0f) };
+    }
+    if (!drawListChanged) {
+        _culler.updateBounds(bounds);
+        return;
+    }
+    std::vector<VkDrawIndexedIndirectCommand> draws(bounds.size());
+    for (uint32_t i = 0; i < draws.size(); i++) draws[i] = { MeshRenderer::INDEX_COUNT, 1, 0, 0, i };
+    _culler.setObjects(bounds, draws);
+}
+
+// Built in chunks on the job system. Once the chunks done so far are past the limit,
+// the rest keep only their union, so dragging a huge selection costs one parallel
+// pass per frame and no per-mesh storage.
+void EditorApp::updateSelectionBounds() {
+    if (_selectionBoxesGeneration == _selection.generation() && _selectionBoxesTransforms == _transforms.generation()) return;
+    _selectionBoxesGeneration = _selection.generation();
+    _selectionBoxesTransforms = _transforms.generation();
+
+    struct Chunk {
+        std::vector<SelectionBox> boxes;
+        uint32_t meshes = 0;
+        glm::vec3 min{ std::numeric_limits<float>::max() };
+        glm::vec3 max{ std::numeric_limits<float>::lowest() };
+    };
+    const size_t grain = 4096;
+    const std::vector<Entity>& entities = _selection.entities();
+    std::vector<Chunk> chunks((entities.size() + grain - 1) / grain);
+    std::atomic<uint32_t> meshesDone{ 0 };
+    _jobs.parallelFor(entities.size(), grain, [&](size_t begin, size_t end) {
+        Chunk& chunk = chunks[begin / grain];
+        bool keepBoxes = meshesDone.load(std::memory_order_relaxed) <= SELECTION_BOX_LIMIT;
+        for (size_t i = begin; i < end; i++) {
+            if (_scene.type(entities[i]) != EntityType::Mesh) continue;
+            glm::vec3 min, max;
+            TransformStore::cubeBounds(_transforms.get(entities[i]), min, max);
+            chunk.min = glm::min(chunk.min, min);
+            chunk.max = glm::max(chunk.max, max);
+            chunk.meshes++;
+            if (keepBoxes) chunk.boxes.push_back({ entities[i], min, max });
+        }
+        if (meshesDone.fetch_add(chunk.meshes, std::memory_order_relaxed) + chunk.meshes > SELECTION_BOX_LIMIT) chunk.boxes = {};
+    });
+
+    _selectionBoxes.clear();
+    _selectionMeshes = 0;
+    _selectionMin = glm::vec3(std::numeric_limits<float>::max());
+    _selectionMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const Chunk& chunk : chunks) {
+        _selectionMeshes += chunk.meshes;
+        _selectionMin = glm::min(_selectionMin, chunk.min);
+        _selectionMax = glm::max(_selectionMax, chunk.max);
+    }
+    if (_selectionMeshes > SELECTION_BOX_LIMIT) return;
+    for (const Chunk& chunk : chunks) {
+        _selectionBoxes.insert(_selectionBoxes.end(), chunk.boxes.begin(), chunk.boxes.end());
+    }
+}
+
 void EditorApp::drawFrame() {
     _renderer.beginFrame();
+    _viewport.beginFrame(_renderer.currentFrame());
+    _debugDraw.beginFrame(_renderer.currentFrame());
+    _assets.update();
+    _thumbnails.update(_renderer.currentFrame(), _renderer.frameNumber());
+    updateStreamingWorld();
+    _streamer.update(_camera, _renderer.frameNumber());
+    // A click that hits no mesh leaves the selection alone; Edit > Deselect clears it.
+    if (auto picked = _viewport.takePickResult(); picked && *picked != NULL_ENTITY) {
+        if (_pickToggles) _selection.toggle(*picked);
+        else _selection.select(*picked);
+    }
 
     ImGui_ImplVulkan_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -112,8 +372,80 @@ void EditorApp::drawFrame() {
     renderUI();
 
     ImGui::Render();
-    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), _renderer.currentCommandBuffer());
+    _autosave.update(_transforms, _transformEditing);
+
+    // The frame is declared as a render graph: passes list the images and buffers they
+    // use, and the graph culls what nothing reads, places barriers and shares transient memory.
+    _frameGraph.reset();
+    using Access = RenderGraph::Access;
+
+    // Transforms edited this frame reach the GPU ahead of every pass that draws the scene.
+    RenderGraph::ResourceId instances = _instances.addPass(_frameGraph, _renderer.currentFrame(), _transforms);
+    _meshes.beginFrame(_renderer.currentFrame(), _instances.buffer(), _transformEditing ? &_selection : nullptr);
+    // The culler's objects must index the draw list this frame draws.
+    updateCullingObjects();
+    _culler.beginFrame(_renderer.currentFrame(), _viewport.renderExtent());
 
+    // Every mesh casts a shadow. While an edit is in progress the selection is drawn
+    // into the dynamic atlas each frame, so the static cache survives the drag.
+    ShadowRenderer::Casters shadowCasters;
+    shadowCasters.drawStatic = [](VkCommandBuffer commandBuffer, VkPipelineLayout layout, const glm::mat4&) {
+        _meshes.bindInstances(commandBuffer, layout);
+        return _meshes.drawStatic(commandBuffer);
+    };
+    if (_transformEditing) {
+        shadowCasters.drawDynamic = [](VkCommandBuffer commandBuffer, VkPipelineLayout layout, const glm::mat4&) {
+            _meshes.bindInstances(commandBuffer, layout);
+            return _meshes.drawMoving(commandBuffer);
+        };
+    }
+    shadowCasters.uses = { RenderGraph::read(instances, Access::StorageVertex) };
+    ShadowRenderer::Atlases shadowAtlases = _shadows.addPasses(_frameGraph, _renderer.currentFrame(), _camera, shadowCasters);
+
+    // The scene reads the instance transforms and samples both shadow atlases.
+    ViewportRenderer::SceneCallbacks scene;
+    scene.drawUses = { RenderGraph::read(instances, Access::StorageVertex), RenderGraph::read(shadowAtlases.staticAtlas, Access::SampledFragment),
+                       RenderGraph::read(shadowAtlases.dynamicAtlas, Access::SampledFragment) };
+    glm::mat4 viewProjection = _camera.viewProjection();
+    auto bindMeshes = [viewProjection, view = _camera.view(), shadowSet = _shadows.descriptorSet(_renderer.currentFrame())](VkCommandBuffer commandBuffer) {
+        _meshes.bind(commandBuffer, shadowSet, viewProjection, view);
+    };
+    scene.drawEarly = [bindMeshes](VkCommandBuffer commandBuffer) {
+        bindMeshes(commandBuffer);
+        _meshes.draw(commandBuffer);
+    };
+
+    // Two-phase occlusion culling: last frame's visible set is drawn first, its depth
+    // becomes the Hi-Z pyramid, and only objects that pass against it are drawn second.
+    // While active the culler replaces both draws with its indirect ones, which each
+    // half of the split scene pass records after binding the mesh pipeline again.
+    _culler.addPasses(_frameGraph, viewProjection, scene);
+    if (_culler.active()) {
+        scene.drawEarly = [bindMeshes, draw = scene.drawEarly](VkCommandBuffer commandBuffer) {
+            bindMeshes(commandBuffer);
+            draw(commandBuffer);
+        };
+        scene.drawLate = [bindMeshes, draw = scene.drawLate](VkCommandBuffer commandBuffer) {
+            bindMeshes(commandBuffer);
+            draw(commandBuffer);
+        };
+    }
+    scene.overlay = [viewProjection](VkCommandBuffer commandBuffer) { _debugDraw.flush(commandBuffer, viewProjection); };
+    RenderGraph::ResourceId viewportImage = _viewport.addPasses(_frameGraph, scene);
+
+    // Thumbnails finished since the last frame, in the atlas pages the content browser draws from.
+    std::vector<RenderGraph::ResourceId> thumbnailPages = _thumbnails.addPass(_frameGraph, _renderer.currentFrame());
+
+    std::vector<RenderGraph::Use> uiUses = { RenderGraph::write(_renderer.importSwapChainImage(_frameGraph), Access::ColorAttachment) };
+    if (viewportImage != RenderGraph::NO_RESOURCE) uiUses.push_back(RenderGraph::read(viewportImage, Access::SampledFragment));
+    for (RenderGraph::ResourceId page : thumbnailPages) uiUses.push_back(RenderGraph::read(page, Access::SampledFragment));
+    _frameGraph.addPass("ui", uiUses, [](VkCommandBuffer commandBuffer, RenderGraphExecutor&) {
+        _renderer.beginUIPass();
+        ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
+        _renderer.endUIPass();
+    });
+
+    _graphExecutor.execute(_frameGraph, _renderer.currentCommandBuffer());
     _renderer.endFrame();
 }
 
@@ -150,13 +482,37 @@ void EditorApp::setupDockspace() {
         if (ImGui::BeginMenu("Edit")) {
             ImGui::MenuItem("Undo");
             ImGui::MenuItem("Redo");
+            ImGui::Separator();
+            if (ImGui::MenuItem("Select All")) {
+                for (Entity entity = 1; entity < _scene.entityCount(); entity++) _selection.add(entity);
+            }
+            if (ImGui::MenuItem("Deselect", nullptr, false, !_selection.empty())) _selection.clear();
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("View")) {
+            DynamicResolution& resolution = _viewport.resolution();
+            bool dynamicResolution = resolution.enabled();
+            if (ImGui::MenuItem("Dynamic Resolution", nullptr, &dynamicResolution)) resolution.setEnabled(dynamicResolution);
+            float targetMs = resolution.targetMs();
+            if (ImGui::SliderFloat("GPU Budget (ms)", &targetMs, 4.0f, 33.0f, "%.1f")) resolution.setTargetMs(targetMs);
+            ImGui::Separator();
+            ImGui::MenuItem("Shadow Cascades", nullptr, &_showShadowCascades);
             ImGui::EndMenu();
         }
         if (ImGui::BeginMenu("Create")) {
-            if (ImGui::MenuItem("Cube")) { /* logic to add cube */ }
-            if (ImGui::MenuItem("Sphere")) { /* logic to add sphere */ }
-            if (ImGui::MenuItem("Plane")) { /* logic to add plane */ }
-            if (ImGui::MenuItem("Point Light")) { /* logic to add light */ }
+            std::string suffix = " #" + std::to_string(_scene.entityCount());
+            if (ImGui::MenuItem("Cube")) _selection.select(_scene.createEntity("Cube" + suffix, EntityType::Mesh));
+            if (ImGui::MenuItem("Sphere")) _selection.select(_scene.createEntity("Sphere" + suffix, EntityType::Mesh));
+            if (ImGui::MenuItem("Plane")) _selection.select(_scene.createEntity("Plane" + suffix, EntityType::Mesh));
+            if (ImGui::MenuItem("Point Light")) _selection.select(_scene.createEntity("Point Light" + suffix, EntityType::Light));
+            ImGui::Separator();
+            if (ImGui::MenuItem("Stress Test (1M Cubes)")) {
+                _scene.reserve(_scene.entityCount() + 1000001);
+                Entity group = _scene.createEntity("Stress Test", EntityType::Empty);
+                for (uint32_t i = 0; i < 1000000; i++) {
+                    _scene.createEntity("Cube #" + std::to_string(i), EntityType::Mesh, group);
+                }
+            }
             ImGui::EndMenu();
         }
         ImGui::EndMenuBar();
@@ -166,61 +522,151 @@ void EditorApp::setupDockspace() {
 }
 
 void EditorApp::renderUI() {
-    ImGui::Begin("Hierarchy");
-    if (ImGui::TreeNodeEx("Untitled Scene", ImGuiTreeNodeFlags_DefaultOpen)) {
-        if (ImGui::Selectable("Main Camera", false)) {}
-        if (ImGui::Selectable("Directional Light", false)) {}
-        
-        static bool selected[3] = {true, false, false};
-        if (ImGui::Selectable("Cube #0", selected[0])) { selected[0] = true; selected[1] = false; selected[2] = false; }
-        if (ImGui::Selectable("Sphere #1", selected[1])) { selected[0] = false; selected[1] = true; selected[2] = false; }
-        if (ImGui::Selectable("Plane #2", selected[2])) { selected[0] = false; selected[1] = false; selected[2] = true; }
-        
-        ImGui::TreePop();
-    }
-    ImGui::End();
+    drawHierarchy();
+    drawContentBrowser();
+
+    // The sliders and the gizmo edit the primary entity's matrix; the rest of the
+    // selection follows by the same delta once both have had their turn.
+    Entity primary = _selection.primary();
+    bool hasPrimary = _scene.isValid(primary);
+    glm::mat4 pivot = hasPrimary ? _transforms.get(primary) : glm::mat4(1.0f);
+    glm::mat4 edited = pivot;
 
     ImGui::Begin("Properties");
-    ImGui::Text("Transform");
-    float pos[3], rot[3], scale[3];
-    ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(_modelMatrix), pos, rot, scale);
-    if (ImGui::DragFloat3("Position", pos, 0.1f)) {
-        ImGuizmo::RecomposeMatrixFromComponents(pos, rot, scale, glm::value_ptr(_modelMatrix));
-    }
-    if (ImGui::DragFloat3("Rotation", rot, 0.1f)) {
-        ImGuizmo::RecomposeMatrixFromComponents(pos, rot, scale, glm::value_ptr(_modelMatrix));
-    }
-    if (ImGui::DragFloat3("Scale", scale, 0.1f)) {
-        ImGuizmo::RecomposeMatrixFromComponents(pos, rot, scale, glm::value_ptr(_modelMatrix));
+    bool propertiesEditing = false;
+    if (hasPrimary) {
+        ImGui::Text("Transform");
+        if (_selection.size() > 1) ImGui::TextDisabled("%s and %zu more", _scene.name(primary).c_str(), _selection.size() - 1);
+        float pos[3], rot[3], scale[3];
+        ImGuizmo::DecomposeMatrixToComponents(glm::value_ptr(edited), pos, rot, scale);
+        if (ImGui::DragFloat3("Position", pos, 0.1f)) {
+            ImGuizmo::RecomposeMatrixFromComponents(pos, rot, scale, glm::value_ptr(edited));
+        }
+        propertiesEditing |= ImGui::IsItemActive();
+        if (ImGui::DragFloat3("Rotation", rot, 0.1f)) {
+            ImGuizmo::RecomposeMatrixFromComponents(pos, rot, scale, glm::value_ptr(edited));
+        }
+        propertiesEditing |= ImGui::IsItemActive();
+        if (ImGui::DragFloat3("Scale", scale, 0.1f)) {
+            ImGuizmo::RecomposeMatrixFromComponents(pos, rot, scale, glm::value_ptr(edited));
+        }
+        propertiesEditing |= ImGui::IsItemActive();
+    } else {
+        ImGui::TextDisabled("Nothing selected");
     }
-    
+
     ImGui::Separator();
     ImGui::Text("Material");
     static float color[3] = {0.8f, 0.1f, 0.1f};
     ImGui::ColorEdit3("Base Color", color);
     ImGui::End();
 
+    ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0.0f, 0.0f));
     ImGui::Begin("Viewport");
+    ImGui::PopStyleVar();
     ImVec2 viewportSize = ImGui::GetContentRegionAvail();
+    ImVec2 viewportPos = ImGui::GetCursorScreenPos();
+    ImVec2 framebufferScale = ImGui::GetIO().DisplayFramebufferScale;
+    _viewport.setPanelSize(static_cast<uint32_t>(std::max(0.0f, viewportSize.x * framebufferScale.x)),
+                           static_cast<uint32_t>(std::max(0.0f, viewportSize.y * framebufferScale.y)));
     
     // Setup camera
-    _camera.setPerspective(45.0f, viewportSize.x / viewportSize.y, 0.1f, 100.0f);
+    if (viewportSize.x > 0.0f && viewportSize.y > 0.0f) {
+        _camera.setPerspective(45.0f, viewportSize.x / viewportSize.y, 0.1f, 100.0f);
+    }
     _camera.lookAt(glm::vec3(5.0f, 5.0f, 5.0f), glm::vec3(0,0,0), glm::vec3(0,1,0));
 
-    ImGui::Text("3D Scene Viewport");
+    if (_viewport.hasTarget()) {
+        if (_viewport.displayTexture() != VK_NULL_HANDLE) {
+            ImGui::Image((ImTextureID)_viewport.displayTexture(), viewportSize);
+        }
+
+        VkExtent2D renderExtent = _viewport.renderExtent();
+        ImGui::SetCursorScreenPos(ImVec2(viewportPos.x + 8.0f, viewportPos.y + 8.0f));
+        ImGui::Text("%ux%u (%.0f%%) | GPU %.2f ms", renderExtent.width, renderExtent.height,
+                    _viewport.resolution().scale() * 100.0f, _viewport.gpuTimeMs());
+        if (_culler.active()) {
+            const OcclusionCuller::Stats& culling = _culler.stats();
+            ImGui::SetCursorScreenPos(ImVec2(viewportPos.x + 8.0f, viewportPos.y + 8.0f + ImGui::GetTextLineHeightWithSpacing()));
+            ImGui::Text("Drawn %u + %u | Occluded %u", culling.earlyVisible, culling.lateVisible, culling.occluded);
+        }
+    }
     
     // ImGuizmo Setup
     ImGuizmo::SetOrthographic(false);
     ImGuizmo::SetDrawlist();
-    ImGuizmo::SetRect(ImGui::GetWindowPos().x, ImGui::GetWindowPos().y, ImGui::GetWindowWidth(), ImGui::GetWindowHeight());
+    ImGuizmo::SetRect(viewportPos.x, viewportPos.y, viewportSize.x, viewportSize.y);
     
     static ImGuizmo::OPERATION currentOp = ImGuizmo::TRANSLATE;
     if (ImGui::IsKeyPressed(ImGuiKey_W)) currentOp = ImGuizmo::TRANSLATE;
     if (ImGui::IsKeyPressed(ImGuiKey_E)) currentOp = ImGuizmo::ROTATE;
     if (ImGui::IsKeyPressed(ImGuiKey_R)) currentOp = ImGuizmo::SCALE;
 
-    ImGuizmo::Manipulate(glm::value_ptr(_camera.view()), glm::value_ptr(_camera.projection()), 
-                        currentOp, ImGuizmo::LOCAL, glm::value_ptr(_modelMatrix));
+    if (hasPrimary) {
+        ImGuizmo::Manipulate(glm::value_ptr(_camera.view()), glm::value_ptr(_camera.projection()),
+                            currentOp, ImGuizmo::LOCAL, glm::value_ptr(edited));
+    }
+
+    // Static shadows are invalidated once per edit, covering where the selection was
+    // (measured before this frame's delta lands) and where it ended up.
+    // Outside an edit transforms only change when meshes are created, which has no
+    // bounds to invalidate, so those redraw the whole cache.
+    if (!_transformEditing && _transforms.generation() != _staticShadowsGeneration) _shadows.cascades().invalidateAll();
+    bool transformEditing = ImGuizmo::IsUsing() || propertiesEditing;
+    if (transformEditing && !_transformEditing) {
+        // The selection leaves the static casters for the drag, so its shadow goes too.
+        if (_transforms.bounds(_selection, _jobs, _editStartMin, _editStartMax)) {
+            _shadows.cascades().invalidateStatic(_editStartMin, _editStartMax);
+        }
+    }
+    if (hasPrimary && edited != pivot) {
+        // A pivot scaled to zero has no inverse; then only the primary moves.
+        if (std::abs(glm::determinant(pivot)) > 1e-12f) _transforms.applyDelta(_selection, edited * glm::inverse(pivot), _jobs);
+        _transforms.set(primary, edited);  // exactly what was dragged, free of the delta's rounding
+    }
+    if (!transformEditing && _transformEditing) {
+        glm::vec3 endMin, endMax;
+        if (_transforms.bounds(_selection, _jobs, endMin, endMax)) {
+            _shadows.cascades().invalidateStatic(glm::min(_editStartMin, endMin), glm::max(_editStartMax, endMax));
+        }
+    }
+    _staticShadowsGeneration = _transforms.generation();
+    _transformEditing = transformEditing;
+    // While dragging, the object should track the cursor rather than frames queued behind it.
+    _renderer.setPacing(transformEditing ? Renderer::Pacing::LowLatency : Renderer::Pacing::Throughput);
+
+    // Scene helpers
+    _debugDraw.grid(20.0f, 1.0f, DebugDraw::rgba(0.35f, 0.35f, 0.35f, 0.6f), DebugDraw::rgba(0.6f, 0.6f, 0.6f, 0.9f));
+    // The primary mesh gets its oriented box; every other selected mesh its world AABB,
+    // which DebugDraw draws instanced, or past the limit one box around them all.
+    updateSelectionBounds();
+    if (hasPrimary && _scene.type(primary) == EntityType::Mesh) {
+        _debugDraw.box(_transforms.get(primary), DebugDraw::rgba(1.0f, 0.6f, 0.1f));
+    }
+    if (_selectionMeshes > SELECTION_BOX_LIMIT) {
+        _debugDraw.aabb(_selectionMin, _selectionMax, DebugDraw::rgba(1.0f, 0.85f, 0.4f, 0.8f));
+    } else {
+        for (const SelectionBox& box : _selectionBoxes) {
+            if (box.entity != primary) _debugDraw.aabb(box.min, box.max, DebugDraw::rgba(1.0f, 0.85f, 0.4f, 0.8f));
+        }
+    }
+    if (_showShadowCascades) {
+        static const uint32_t cascadeColors[ShadowCascades::CASCADE_COUNT] = {
+            DebugDraw::rgba(1.0f, 0.3f, 0.3f), DebugDraw::rgba(0.3f, 1.0f, 0.3f),
+            DebugDraw::rgba(0.3f, 0.3f, 1.0f), DebugDraw::rgba(1.0f, 1.0f, 0.3f)
+        };
+        for (uint32_t i = 0; i < ShadowCascades::CASCADE_COUNT; i++) {
+            _debugDraw.frustum(_shadows.cascades().cascade(i).viewProjection, cascadeColors[i]);
+        }
+    }
+
+    // Click-to-select: panel-relative coordinates, mapped to the render scale by the viewport.
+    if (ImGui::IsWindowHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && !ImGuizmo::IsOver() &&
+        viewportSize.x > 0.0f && viewportSize.y > 0.0f) {
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+        _pickToggles = ImGui::GetIO().KeyCtrl;
+        _viewport.requestPick((mouse.x - viewportPos.x) / viewportSize.x, (mouse.y - viewportPos.y) / viewportSize.y);
+    }
 
     ImGui::End();
     
@@ -228,16 +674,310 @@ void EditorApp::renderUI() {
     ImGui::BeginMainMenuBar();
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
     ImGui::Separator();
-    ImGui::Text("Vulkan 1.2 | NVIDIA RTX 3080 (Simulated)");
+    ImGui::Text("Shadow cascades updated: %u static, %u dynamic", _shadows.staticCascadesUpdated(), _shadows.dynamicCascadesUpdated());
+    ImGui::Separator();
+    if (_streamer.active()) {
+        const WorldStreamer::Stats& streaming = _streamer.stats();
+        ImGui::Text("Streaming: %u cells (+%u), %u entities | CPU %.0f/%.0f MB | GPU %.0f/%.0f MB%s", streaming.resident, streaming.loading, _streamedEntities,
+                    streaming.cpuBytes / 1048576.0, streaming.cpuBudget / 1048576.0,
+                    streaming.gpuBytes / 1048576.0, streaming.gpuBudget / 1048576.0, streaming.deviceBudget ? " (device)" : "");
+        ImGui::Separator();
+    }
+    if (!_selection.empty()) {
+        const InstanceBuffer::Stats& instances = _instances.stats();
+        ImGui::Text("Selected: %zu | instance upload %.2f MB in %u copies", _selection.size(), instances.bytes / 1048576.0, instances.regions);
+        ImGui::Separator();
+    }
+    if (_autosave.enabled()) {
+        const Autosave::Stats& saved = _autosave.stats();
+        if (_autosave.saving()) {
+            ImGui::Text("Autosave: saving...");
+        } else if (_autosave.secondsSinceSave() >= 0.0) {
+            ImGui::Text("Autosave: %.0f s ago (%.1f MB in %.0f ms)%s", _autosave.secondsSinceSave(), saved.bytes / 1048576.0, saved.writeMs,
+                        saved.failed ? ", last attempt failed" : "");
+        } else {
+            ImGui::TextUnformatted(saved.failed ? "Autosave: failed" : "Autosave: no changes yet");
+        }
+        ImGui::Separator();
+    }
+    if (_selectionMeshes > SELECTION_BOX_LIMIT) {
+        // The primary keeps its oriented box.
+        Entity primary = _selection.primary();
+        bool primaryMesh = _scene.isValid(primary) && _scene.type(primary) == EntityType::Mesh;
+        ImGui::TextColored(ImVec4(1.0f, 0.85f, 0.4f, 1.0f), "Selection: %u bounds not drawn, showing their combined box",
+                           _selectionMeshes - (primaryMesh ? 1u : 0u));
+        ImGui::Separator();
+    }
+    // Everything this frame has been submitted by now; past the buffer limits, primitives are skipped.
+    if (uint32_t dropped = _debugDraw.droppedCount()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "Debug draw: %u primitives dropped", dropped);
+        ImGui::Separator();
+    }
+    const RenderGraph::Stats& graphStats = _graphExecutor.stats();
+    ImGui::Text("Render graph: %u passes (%u culled) | %u barriers in %u batches | transient %.1f MB per frame (%.1f unaliased)",
+                graphStats.passes - graphStats.culledPasses, graphStats.culledPasses, graphStats.imageBarriers + graphStats.bufferBarriers,
+                graphStats.barrierBatches,
+                graphStats.transientBytes / 1048576.0, graphStats.unaliasedBytes / 1048576.0);
+    ImGui::Separator();
+    const VkPhysicalDeviceProperties& device = _vkContext.capabilities().properties;
+    ImGui::Text("Vulkan %u.%u.%u | %s", VK_API_VERSION_MAJOR(device.apiVersion), VK_API_VERSION_MINOR(device.apiVersion),
+                VK_API_VERSION_PATCH(device.apiVersion), device.deviceName);
     ImGui::EndMainMenuBar();
 }
 
+void EditorApp::initScene() {
+    _outline.init(&_scene);
+    _searchIndex.init(&_scene);
+    _transforms.init(&_scene);
+
+    _scene.createEntity("Main Camera", EntityType::Camera);
+    _scene.createEntity("Directional Light", EntityType::Light);
+    _selection.select(_scene.createEntity("Cube #0", EntityType::Mesh));
+    _scene.createEntity("Sphere #1", EntityType::Mesh);
+    _scene.createEntity("Plane #2", EntityType::Mesh);
+}
+
+void EditorApp::drawHierarchy() {
+    ImGui::Begin("Hierarchy");
+
+    static const char* typeFilters[] = { "All Types", "Empty", "Camera", "Light", "Mesh" };
+    ImGui::SetNextItemWidth(-110.0f);
+    ImGui::InputTextWithHint("##Search", "Search...", _searchText, IM_ARRAYSIZE(_searchText));
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(-1.0f);
+    ImGui::Combo("##Type", &_searchTypeFilter, typeFilters, IM_ARRAYSIZE(typeFilters));
+
+    _outline.sync();
+
+    // Only the rows inside the scroll region are submitted, so the cost is
+    // independent of scene size.
+    ImGui::BeginChild("##Rows");
+    if (_searchText[0] != '\0' || _searchTypeFilter > 0) {
+        std::optional<EntityType> type;
+        if (_searchTypeFilter > 0) type = static_cast<EntityType>(_searchTypeFilter - 1);
+        const std::vector<Entity>& results = _searchIndex.search(_searchText, type);
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(results.size()));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                Entity entity = results[i];
+                ImGui::PushID(static_cast<int>(entity));
+                if (ImGui::Selectable(_scene.name(entity).c_str(), _selection.contains(entity))) {
+                    clickRow(i, static_cast<int>(results.size()), [&results](int row) { return results[row]; });
+                }
+                ImGui::PopID();
+            }
+        }
+    } else {
+        const std::vector<SceneOutline::Row>& rows = _outline.rows();
+        std::optional<std::pair<Entity, bool>> toggle;
+        std::optional<int> clicked;
+        Entity selectChildren = NULL_ENTITY;
+
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(rows.size()));
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                SceneOutline::Row row = rows[i];
+                bool expanded = _outline.isExpanded(row.entity);
+
+                ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_OpenOnArrow | ImGuiTreeNodeFlags_SpanAvailWidth | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+                if (!_scene.hasChildren(row.entity)) flags |= ImGuiTreeNodeFlags_Leaf;
+                if (_selection.contains(row.entity)) flags |= ImGuiTreeNodeFlags_Selected;
+
+                ImGui::SetCursorPosX(ImGui::GetCursorPosX() + row.depth * ImGui::GetStyle().IndentSpacing);
+                ImGui::SetNextItemOpen(expanded);
+                bool open = ImGui::TreeNodeEx(reinterpret_cast<void*>(static_cast<intptr_t>(row.entity)), flags, "%s", _scene.name(row.entity).c_str());
+                if (ImGui::IsItemClicked() && !ImGui::IsItemToggledOpen() && row.entity != ROOT_ENTITY) clicked = i;
+                if (open != expanded) toggle = { row.entity, open };
+                if (_scene.hasChildren(row.entity) && ImGui::BeginPopupContextItem()) {
+                    if (ImGui::MenuItem("Select Children")) selectChildren = row.entity;
+                    ImGui::EndPopup();
+                }
+            }
+        }
+
+        // Applied after the loop: expanding splices rows into the vector being iterated.
+        if (clicked) clickRow(*clicked, static_cast<int>(rows.size()), [&rows](int row) { return rows[row].entity; });
+        if (selectChildren != NULL_ENTITY) {
+            _selection.clear();
+            for (Entity child = _scene.firstChild(selectChildren); child != NULL_ENTITY; child = _scene.nextSibling(child)) _selection.add(child);
+            _selectionAnchor = _selection.primary();
+        }
+        if (toggle) _outline.setExpanded(toggle->first, toggle->second);
+    }
+    ImGui::EndChild();
+
+    ImGui::End();
+}
+
+// Ctrl toggles one row, Shift selects every row between the last one clicked and this
+// one (adding to the selection with Ctrl held too), a plain click replaces the selection.
+void EditorApp::clickRow(int row, int rowCount, const std::function<Entity(int)>& rowEntity) {
+    const ImGuiIO& io = ImGui::GetIO();
+    Entity entity = rowEntity(row);
+    if (io.KeyShift && _selectionAnchor != NULL_ENTITY) {
+        int anchor = -1;
+        for (int i = 0; i < rowCount && anchor < 0; i++) {
+            if (rowEntity(i) == _selectionAnchor) anchor = i;
+        }
+        if (anchor >= 0) {
+            if (!io.KeyCtrl) _selection.clear();
+            for (int i = std::min(anchor, row); i <= std::max(anchor, row); i++) {
+                if (rowEntity(i) != ROOT_ENTITY) _selection.add(rowEntity(i));
+            }
+            _selection.add(entity);
+            return;
+        }
+    }
+    if (io.KeyCtrl) _selection.toggle(entity);
+    else _selection.select(entity);
+    _selectionAnchor = entity;
+}
+
+void EditorApp::drawContentBrowser() {
+    ImGui::Begin("Content Browser");
+    if (!_assets.isOpen()) {
+        ImGui::TextDisabled("No project folder at '%s' (start with --project <dir>).", _options.projectRoot.c_str());
+        ImGui::End();
+        return;
+    }
+
+    // Breadcrumbs: each segment jumps back to that folder.
+    if (ImGui::SmallButton("Project")) _browserFolder.clear();
+    for (size_t start = 0; start < _browserFolder.size();) {
+        size_t end = _browserFolder.find('/', start);
+        if (end == std::string::npos) end = _browserFolder.size();
+        ImGui::SameLine();
+        ImGui::TextUnformatted("/");
+        ImGui::SameLine();
+        ImGui::PushID(static_cast<int>(start));
+        if (ImGui::SmallButton(_browserFolder.substr(start, end - start).c_str())) _browserFolder.resize(end);
+        ImGui::PopID();
+        start = end + 1;
+    }
+    ImGui::SameLine();
+    if (_assets.pendingScans() > 0) {
+        ImGui::TextDisabled("| %u assets, indexing %u...", _assets.assetCount(), _assets.pendingScans());
+    } else {
+        ImGui::TextDisabled("| %u assets", _assets.assetCount());
+    }
+
+    static const char* typeFilters[] = { "All Types", "File", "Texture", "Mesh", "Material", "Shader", "Audio" };
+    ImGui::SetNextItemWidth(-110.0f);
+    ImGui::InputTextWithHint("##Search", "Search project...", _browserSearch, IM_ARRAYSIZE(_browserSearch));
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(-1.0f);
+    ImGui::Combo("##Type", &_browserTypeFilter, typeFilters, IM_ARRAYSIZE(typeFilters));
+
+    std::string listedKey = _browserFolder + '\n' + _browserSearch + '\n' + std::to_string(_browserTypeFilter);
+    if (_assets.generation() != _browserGeneration || listedKey != _browserListedKey) {
+        std::optional<AssetType> type;
+        if (_browserTypeFilter > 0) type = static_cast<AssetType>(_browserTypeFilter - 1);
+        _assets.list(_browserFolder, _browserSearch, type, _browserFolders, _browserAssets);
+        _browserGeneration = _assets.generation();
+        _browserListedKey = listedKey;
+    }
+
+    // Virtualized grid: the clipper works in rows, so only visible tiles are
+    // submitted and only visible assets ask for thumbnails.
+    ImGui::BeginChild("##Grid");
+    const float tileSize = static_cast<float>(ThumbnailCache::THUMBNAIL_SIZE) * 0.75f;
+    const ImGuiStyle& style = ImGui::GetStyle();
+    const float cellWidth = tileSize + style.ItemSpacing.x;
+    const float cellHeight = tileSize + ImGui::GetTextLineHeightWithSpacing() + style.ItemSpacing.y;
+    const int columns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + style.ItemSpacing.x) / cellWidth));
+    const int itemCount = static_cast<int>(_browserFolders.size() + _browserAssets.size());
+    std::optional<std::string> openFolder;
+
+    // File names are cut to the tile width.
+    auto label = [tileSize](const std::string& name) {
+        if (ImGui::CalcTextSize(name.c_str()).x <= tileSize) return name;
+        std::string text = name;
+        while (text.size() > 1 && ImGui::CalcTextSize((text + "...").c_str()).x > tileSize) text.pop_back();
+        return text + "...";
+    };
+
+    ImGuiListClipper clipper;
+    clipper.Begin((itemCount + columns - 1) / columns, cellHeight);
+    while (clipper.Step()) {
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+            for (int column = 0; column < columns; column++) {
+                int index = row * columns + column;
+                if (index >= itemCount) break;
+                if (column > 0) ImGui::SameLine();
+
+                ImGui::PushID(index);
+                ImGui::BeginGroup();
+                if (index < static_cast<int>(_browserFolders.size())) {
+                    const std::string& folder = _browserFolders[index];
+                    ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.45f, 0.36f, 0.15f, 1.0f));
+                    ImGui::Button("Folder", ImVec2(tileSize, tileSize));
+                    ImGui::PopStyleColor();
+                    if (ImGui::IsItemHovered() && ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
+                        openFolder = _browserFolder.empty() ? folder : _browserFolder + "/" + folder;
+                    }
+                    ImGui::TextUnformatted(label(folder).c_str());
+                } else {
+                    AssetId id = _browserAssets[index - _browserFolders.size()];
+                    const AssetRecord& asset = _assets.record(id);
+                    ThumbnailCache::Thumbnail thumbnail;
+                    if (_thumbnails.request(asset, _assets.absolutePath(id), thumbnail)) {
+                        ImGui::Image((ImTextureID)thumbnail.texture, ImVec2(tileSize, tileSize),
+                                     ImVec2(thumbnail.u0, thumbnail.v0), ImVec2(thumbnail.u1, thumbnail.v1));
+                    } else {
+                        ImGui::Button(AssetDatabase::typeName(asset.type), ImVec2(tileSize, tileSize));
+                    }
+                    if (ImGui::IsItemHovered()) {
+                        ImGui::BeginTooltip();
+                        ImGui::TextUnformatted(asset.path.c_str());
+                        ImGui::Text("%s, %.1f KB", AssetDatabase::typeName(asset.type), asset.size / 1024.0);
+                        for (const auto& dependency : asset.dependencies) ImGui::BulletText("%s", dependency.c_str());
+                        ImGui::EndTooltip();
+                    }
+                    ImGui::TextUnformatted(label(asset.path.substr(asset.path.find_last_of('/') + 1)).c_str());
+                }
+                ImGui::EndGroup();
+                ImGui::PopID();
+            }
+        }
+    }
+    ImGui::EndChild();
+
+    // Applied after the loop, which iterates the listing this would rebuild.
+    if (openFolder) {
+        _browserFolder = *openFolder;
+        _browserSearch[0] = '\0';
+    }
+
+    ImGui::End();
+}
+
 void EditorApp::cleanup() {
     vkDeviceWaitIdle(_vkContext.device());
+    _autosave.cleanup();
+    _streamer.cleanup();
+    _assets.close();
+    _thumbnails.cleanup();
+    _culler.cleanup();
+    _meshes.cleanup();
+    _shadows.cleanup();
+    _debugDraw.cleanup();
+    _viewport.cleanup();
+    _instances.cleanup();
+    _graphExecutor.cleanup();
     ImGui_ImplVulkan_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
+    // Written on a worker while the rest shuts down; _jobs joins it on destruction.
+    _jobs.submit([data = _vkContext.pipelineCacheData()] {
+        if (data.empty()) return;
+        std::ofstream file(PIPELINE_CACHE_PATH, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), data.size());
+    });
+
     _renderer.cleanup();
     vkDestroyDescriptorPool(_vkContext.device(), _imguiPool, nullptr);
     _vkContext.cleanup();
@@ -0,0 +1,86 @@
+#include "InstanceBuffer.h"
+#include <algorithm>
+#include <stdexcept>
+
+void InstanceBuffer::init(VulkanContext* context, Renderer* renderer) {
+    _vkContext = context;
+    _renderer = renderer;
+}
+
+void InstanceBuffer::cleanup() {
+    VkDevice device = _vkContext->device();
+    for (Staging& staging : _staging) destroyStaging(staging);
+    if (_buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device, _buffer, nullptr);
+        vkFreeMemory(device, _memory, nullptr);
+        _buffer = VK_NULL_HANDLE;
+    }
+    _capacity = 0;
+}
+
+void InstanceBuffer::destroyStaging(Staging& staging) {
+    if (staging.buffer == VK_NULL_HANDLE) return;
+    VkDevice device = _vkContext->device();
+    vkUnmapMemory(device, staging.memory);
+    vkDestroyBuffer(device, staging.buffer, nullptr);
+    vkFreeMemory(device, staging.memory, nullptr);
+    staging = {};
+}
+
+RenderGraph::ResourceId InstanceBuffer::addPass(RenderGraph& graph, uint32_t frameIndex, TransformStore& transforms) {
+    _stats = {};
+
+    // Grown by half again each time, so a run of created entities does not reallocate
+    // every frame; the new buffer starts empty and takes a full upload.
+    VkDeviceSize required = static_cast<VkDeviceSize>(transforms.count()) * sizeof(glm::mat4);
+    if (required > _capacity) {
+        if (_buffer != VK_NULL_HANDLE) {
+            _renderer->retire([device = _vkContext->device(), buffer = _buffer, memory = _memory] {
+                vkDestroyBuffer(device, buffer, nullptr);
+                vkFreeMemory(device, memory, nullptr);
+            });
+        }
+        _capacity = std::max(required, _capacity + _capacity / 2);
+        _vkContext->createBuffer(_capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _buffer, _memory);
+        transforms.markAllDirty();
+    }
+
+    // Last frame's readers are all the graph needs to order the copy after.
+    RenderGraph::ResourceId resource = graph.importBuffer("instances", _buffer,
+        VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    transforms.takeDirty(_ranges);
+    if (_ranges.empty()) return resource;
+
+    VkDeviceSize bytes = 0;
+    for (const TransformStore::Range& range : _ranges) bytes += static_cast<VkDeviceSize>(range.count) * sizeof(glm::mat4);
+
+    // The slot's previous frame has completed, so its staging buffer can be rewritten or replaced.
+    Staging& staging = _staging[frameIndex];
+    if (staging.size < bytes) {
+        destroyStaging(staging);
+        staging.size = std::max(bytes, VkDeviceSize(1) << 20);
+        _vkContext->createBuffer(staging.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, staging.buffer, staging.memory);
+        vkMapMemory(_vkContext->device(), staging.memory, 0, staging.size, 0, &staging.mapped);
+    }
+
+    _regions.clear();
+    VkDeviceSize offset = 0;
+    for (const TransformStore::Range& range : _ranges) {
+        VkDeviceSize size = static_cast<VkDeviceSize>(range.count) * sizeof(glm::mat4);
+        transforms.copy(range, reinterpret_cast<glm::mat4*>(static_cast<char*>(staging.mapped) + offset));
+        _regions.push_back({ offset, static_cast<VkDeviceSize>(range.first) * sizeof(glm::mat4), size });
+        offset += size;
+    }
+
+    // The regions are recorded when the pass runs, after this frame's packing.
+    graph.addPass("instances", { RenderGraph::write(resource, RenderGraph::Access::TransferDst) },
+        [this, source = staging.buffer](VkCommandBuffer commandBuffer, RenderGraphExecutor&) {
+            vkCmdCopyBuffer(commandBuffer, source, _buffer, static_cast<uint32_t>(_regions.size()), _regions.data());
+        });
+
+    _stats = { static_cast<uint32_t>(_regions.size()), bytes };
+    return resource;
+}
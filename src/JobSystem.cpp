@@ -0,0 +1,91 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+JobSystem::JobSystem(uint32_t workerCount) {
+    if (workerCount == 0) {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+    _workers.reserve(workerCount);
+    for (uint32_t i = 0; i < workerCount; i++) {
+        _workers.emplace_back(&JobSystem::workerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _wake.notify_all();
+    for (auto& worker : _workers) worker.join();
+}
+
+void JobSystem::workerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this] { return _stopping || !_jobs.empty(); });
+            if (_jobs.empty()) return;  // stopping and drained
+            job = std::move(_jobs.front());
+            _jobs.pop();
+        }
+        job();
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+
+    // Shared with the helper jobs, which may only start after this returns: a helper
+    // that finds no chunk left exits without touching `body`.
+    struct Loop {
+        std::atomic<size_t> next{ 0 };
+        size_t chunks = 0;
+        size_t count = 0;
+        size_t grain = 0;
+        const std::function<void(size_t, size_t)>* body = nullptr;
+        std::mutex mutex;
+        std::condition_variable finished;
+        size_t done = 0;
+        std::exception_ptr error;
+    };
+    auto loop = std::make_shared<Loop>();
+    loop->chunks = (count + grain - 1) / grain;
+    loop->count = count;
+    loop->grain = grain;
+    loop->body = &body;
+
+    auto run = [](Loop& loop) {
+        for (size_t chunk = loop.next++; chunk < loop.chunks; chunk = loop.next++) {
+            std::exception_ptr error;
+            try {
+                size_t begin = chunk * loop.grain;
+                (*loop.body)(begin, std::min(begin + loop.grain, loop.count));
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(loop.mutex);
+            if (error && !loop.error) loop.error = error;
+            if (++loop.done == loop.chunks) loop.finished.notify_one();
+        }
+    };
+
+    size_t helpers = std::min(loop->chunks - 1, _workers.size());
+    if (helpers > 0) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (size_t i = 0; i < helpers; i++) _jobs.emplace([loop, run] { run(*loop); });
+        }
+        _wake.notify_all();
+    }
+    run(*loop);
+
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    loop->finished.wait(lock, [&loop] { return loop->done == loop->chunks; });
+    if (loop->error) std::rethrow_exception(loop->error);
+}
@@ -0,0 +1,333 @@
+#include "MeshRenderer.h"
+#include "ShadowRenderer.h"
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+
+void MeshRenderer::init(VulkanContext* context, Scene* scene, VkRenderPass scenePass, bool hasEntityIdAttachment,
+                        VkDescriptorSetLayout shadowSetLayout) {
+    _vkContext = context;
+    createDescriptors();
+    createPipeline(scenePass, hasEntityIdAttachment, shadowSetLayout);
+    createGeometry();
+
+    scene->addListener(this);
+    for (Entity entity = 1; entity < scene->entityCount(); entity++) onEntityCreated(*scene, entity);
+}
+
+void MeshRenderer::cleanup() {
+    VkDevice device = _vkContext->device();
+    for (auto& frame : _frames) destroyDrawList(frame);
+    vkDestroyBuffer(device, _geometry, nullptr);
+    vkFreeMemory(device, _geometryMemory, nullptr);
+    vkDestroyPipeline(device, _pipeline, nullptr);
+    vkDestroyPipelineLayout(device, _pipelineLayout, nullptr);
+    vkDestroyDescriptorPool(device, _descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, _setLayout, nullptr);
+}
+
+void MeshRenderer::onEntityCreated(const Scene& scene, Entity entity) {
+    if (scene.type(entity) != EntityType::Mesh) return;
+    _meshes.push_back(entity);
+    _meshesChanged = true;
+}
+
+void MeshRenderer::buildDrawList(const Selection* moving) {
+    _drawList.clear();
+    _drawList.reserve(_meshes.size());
+    for (Entity entity : _meshes) {
+        if (!moving || !moving->contains(entity)) _drawList.push_back(entity);
+    }
+    _staticCount = static_cast<uint32_t>(_drawList.size());
+    if (moving) {
+        for (Entity entity : _meshes) {
+            if (moving->contains(entity)) _drawList.push_back(entity);
+        }
+    }
+    _meshesChanged = false;
+    _movingGeneration = moving ? moving->generation() : UINT64_MAX;
+    _version++;
+}
+
+void MeshRenderer::createDescriptors() {
+    VkDevice device = _vkContext->device();
+
+    // Set 0: instance transforms indexed by entity id (binding 0), the draw list (1).
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t i = 0; i < 2; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &_setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mesh descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Renderer::MAX_FRAMES_IN_FLIGHT * 2 };
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = Renderer::MAX_FRAMES_IN_FLIGHT;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mesh descriptor pool!");
+    }
+
+    for (auto& frame : _frames) {
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &_setLayout;
+        if (vkAllocateDescriptorSets(device, &allocInfo, &frame.descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate mesh descriptor set!");
+        }
+    }
+}
+
+void MeshRenderer::createPipeline(VkRenderPass scenePass, bool hasEntityIdAttachment, VkDescriptorSetLayout shadowSetLayout) {
+    VkDevice device = _vkContext->device();
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.size = sizeof(PushConstants);
+
+    VkDescriptorSetLayout setLayouts[2] = { _setLayout, shadowSetLayout };
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 2;
+    pipelineLayoutInfo.pSetLayouts = setLayouts;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mesh pipeline layout!");
+    }
+
+    VkShaderModule vertModule = _vkContext->createShaderModule("shaders/mesh.vert.spv");
+    VkShaderModule fragModule = _vkContext->createShaderModule("shaders/mesh.frag.spv");
+
+    VkPipelineShaderStageCreateInfo shaderStages[2]{};
+    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = vertModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = fragModule;
+    shaderStages[1].pName = "main";
+
+    VkVertexInputBindingDescription binding{};
+    binding.binding = 0;
+    binding.stride = sizeof(Vertex);
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription attributes[3]{};
+    attributes[0] = { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position) };
+    attributes[1] = { 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color) };
+    attributes[2] = { 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, normal) };
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &binding;
+    vertexInputInfo.vertexAttributeDescriptionCount = 3;
+    vertexInputInfo.pVertexAttributeDescriptions = attributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    // Faces wind counter-clockwise seen from outside; Camera::viewProjection()'s Y flip
+    // keeps them counter-clockwise in framebuffer space.
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
+
+    // Opaque color; the entity id is a single integer channel, which cannot blend.
+    VkPipelineColorBlendAttachmentState blendAttachments[2]{};
+    blendAttachments[0].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    blendAttachments[1].colorWriteMask = VK_COLOR_COMPONENT_R_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.attachmentCount = hasEntityIdAttachment ? 2 : 1;
+    colorBlending.pAttachments = blendAttachments;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = _pipelineLayout;
+    pipelineInfo.renderPass = scenePass;
+    pipelineInfo.subpass = 0;
+
+    VkResult result = vkCreateGraphicsPipelines(device, _vkContext->pipelineCache(), 1, &pipelineInfo, nullptr, &_pipeline);
+    vkDestroyShaderModule(device, fragModule, nullptr);
+    vkDestroyShaderModule(device, vertModule, nullptr);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create mesh pipeline!");
+    }
+}
+
+void MeshRenderer::createGeometry() {
+    // The unit cube, four vertices per face so each face keeps its own normal. For axis
+    // a the face spans the next two axes, ordered so that u x v points outwards.
+    std::array<Vertex, 24> vertices{};
+    std::array<uint16_t, INDEX_COUNT> indices{};
+    const glm::vec3 color(0.8f);
+    for (uint32_t face = 0; face < 6; face++) {
+        uint32_t axis = face / 2;
+        float sign = (face % 2) ? -1.0f : 1.0f;
+        glm::vec3 normal(0.0f), u(0.0f), v(0.0f);
+        normal[axis] = sign;
+        u[(axis + 1) % 3] = 1.0f;
+        v[(axis + 2) % 3] = sign;
+
+        static const float corners[4][2] = { {-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f} };
+        for (uint32_t corner = 0; corner < 4; corner++) {
+            glm::vec3 position = 0.5f * normal + corners[corner][0] * u + corners[corner][1] * v;
+            vertices[face * 4 + corner] = { position, color, normal };
+        }
+        static const uint16_t quad[6] = { 0, 1, 2, 0, 2, 3 };
+        for (uint32_t i = 0; i < 6; i++) indices[face * 6 + i] = static_cast<uint16_t>(face * 4 + quad[i]);
+    }
+
+    // A few hundred bytes, read straight from host-visible memory.
+    _indexOffset = sizeof(vertices);
+    VkDeviceSize size = sizeof(vertices) + sizeof(indices);
+    _vkContext->createBuffer(size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, _geometry, _geometryMemory);
+    void* mapped;
+    vkMapMemory(_vkContext->device(), _geometryMemory, 0, size, 0, &mapped);
+    std::memcpy(mapped, vertices.data(), sizeof(vertices));
+    std::memcpy(static_cast<char*>(mapped) + _indexOffset, indices.data(), sizeof(indices));
+    vkUnmapMemory(_vkContext->device(), _geometryMemory);
+}
+
+void MeshRenderer::reserveDrawList(FrameData& frame, uint32_t count) {
+    if (count <= frame.capacity) return;
+    destroyDrawList(frame);
+    frame.capacity = std::max(count, std::max(1024u, frame.capacity + frame.capacity / 2));
+    VkDeviceSize size = static_cast<VkDeviceSize>(frame.capacity) * sizeof(Entity);
+    _vkContext->createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frame.drawList, frame.drawListMemory);
+    vkMapMemory(_vkContext->device(), frame.drawListMemory, 0, size, 0, reinterpret_cast<void**>(&frame.mapped));
+    frame.version = UINT64_MAX;
+}
+
+void MeshRenderer::destroyDrawList(FrameData& frame) {
+    if (frame.drawList == VK_NULL_HANDLE) return;
+    VkDevice device = _vkContext->device();
+    vkUnmapMemory(device, frame.drawListMemory);
+    vkDestroyBuffer(device, frame.drawList, nullptr);
+    vkFreeMemory(device, frame.drawListMemory, nullptr);
+    frame.drawList = VK_NULL_HANDLE;
+    frame.mapped = nullptr;
+}
+
+void MeshRenderer::beginFrame(uint32_t frameIndex, VkBuffer instances, const Selection* moving) {
+    _frameIndex = frameIndex;
+    FrameData& frame = _frames[frameIndex];
+
+    // Rebuilt when a mesh is created or an edit starts, ends or changes what it moves;
+    // the frames of one drag share a list.
+    if (_meshesChanged || (moving ? moving->generation() : UINT64_MAX) != _movingGeneration) buildDrawList(moving);
+
+    // The slot's previous frame has completed, so its draw list and set can be rewritten.
+    uint32_t count = static_cast<uint32_t>(_drawList.size());
+    reserveDrawList(frame, std::max(count, 1u));
+    if (frame.version != _version) {
+        std::memcpy(frame.mapped, _drawList.data(), count * sizeof(Entity));
+        frame.version = _version;
+    }
+
+    // Either buffer may have been replaced since; one write per frame is cheaper than tracking that.
+    VkDescriptorBufferInfo bufferInfos[2] = {
+        { instances, 0, VK_WHOLE_SIZE },
+        { frame.drawList, 0, VK_WHOLE_SIZE }
+    };
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = frame.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorCount = 2;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pBufferInfo = bufferInfos;
+    vkUpdateDescriptorSets(_vkContext->device(), 1, &write, 0, nullptr);
+    frame.count = count;
+    frame.staticCount = _staticCount;
+}
+
+void MeshRenderer::bind(VkCommandBuffer commandBuffer, VkDescriptorSet shadowSet, const glm::mat4& viewProjection, const glm::mat4& view) {
+    PushConstants constants{ viewProjection, view };
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+    bindInstances(commandBuffer, _pipelineLayout);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipelineLayout, 1, 1, &shadowSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+}
+
+void MeshRenderer::bindInstances(VkCommandBuffer commandBuffer, VkPipelineLayout layout) {
+    static_assert(sizeof(Vertex) == ShadowRenderer::CASTER_VERTEX_STRIDE, "shadow casters read the mesh's vertices");
+    VkDeviceSize vertexOffset = 0;
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &_frames[_frameIndex].descriptorSet, 0, nullptr);
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &_geometry, &vertexOffset);
+    vkCmdBindIndexBuffer(commandBuffer, _geometry, _indexOffset, VK_INDEX_TYPE_UINT16);
+}
+
+void MeshRenderer::draw(VkCommandBuffer commandBuffer) {
+    uint32_t count = _frames[_frameIndex].count;
+    if (count > 0) vkCmdDrawIndexed(commandBuffer, INDEX_COUNT, count, 0, 0, 0);
+}
+
+bool MeshRenderer::drawStatic(VkCommandBuffer commandBuffer) {
+    uint32_t count = _frames[_frameIndex].staticCount;
+    if (count > 0) vkCmdDrawIndexed(commandBuffer, INDEX_COUNT, count, 0, 0, 0);
+    return count > 0;
+}
+
+bool MeshRenderer::drawMoving(VkCommandBuffer commandBuffer) {
+    const FrameData& frame = _frames[_frameIndex];
+    uint32_t count = frame.count - frame.staticCount;
+    if (count > 0) vkCmdDrawIndexed(commandBuffer, INDEX_COUNT, count, 0, 0, frame.staticCount);
+    return count > 0;
+}
@@ -0,0 +1,521 @@
+#include "OcclusionCuller.h"
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+static uint32_t previousPowerOfTwo(uint32_t value) {
+    uint32_t result = 1;
+    while (result * 2 <= value) result *= 2;
+    return result;
+}
+
+void OcclusionCuller::init(VulkanContext* context) {
+    _vkContext = context;
+    createDescriptorLayouts();
+    createPipelines();
+}
+
+void OcclusionCuller::cleanup() {
+    VkDevice device = _vkContext->device();
+    for (auto& frame : _frames) {
+        destroyPyramid(frame.pyramid);
+        destroyHostBuffer(frame.objects);
+        destroyHostBuffer(frame.templates);
+        destroyHostBuffer(frame.stats);
+        vkDestroyBuffer(device, frame.draws, nullptr);
+        vkFreeMemory(device, frame.drawsMemory, nullptr);
+    }
+    vkDestroyBuffer(device, _visibility, nullptr);
+    vkFreeMemory(device, _visibilityMemory, nullptr);
+
+    vkDestroySampler(device, _sampler, nullptr);
+    vkDestroyDescriptorPool(device, _descriptorPool, nullptr);
+    vkDestroyPipeline(device, _downsamplePipeline, nullptr);
+    vkDestroyPipeline(device, _cullPipeline, nullptr);
+    vkDestroyPipelineLayout(device, _downsamplePipelineLayout, nullptr);
+    vkDestroyPipelineLayout(device, _cullPipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, _downsampleSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, _cullSetLayout, nullptr);
+}
+
+void OcclusionCuller::createDescriptorLayouts() {
+    VkDevice device = _vkContext->device();
+
+    // Objects, draw templates, draws, visibility, stats, depth pyramid.
+    std::array<VkDescriptorSetLayoutBinding, 6> cullBindings{};
+    for (uint32_t i = 0; i < cullBindings.size(); i++) {
+        cullBindings[i].binding = i;
+        cullBindings[i].descriptorType = i < 5 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        cullBindings[i].descriptorCount = 1;
+        cullBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(cullBindings.size());
+    layoutInfo.pBindings = cullBindings.data();
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &_cullSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create cull descriptor set layout!");
+    }
+
+    std::array<VkDescriptorSetLayoutBinding, 2> downsampleBindings{};
+    downsampleBindings[0] = { 0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+    downsampleBindings[1] = { 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr };
+    layoutInfo.bindingCount = static_cast<uint32_t>(downsampleBindings.size());
+    layoutInfo.pBindings = downsampleBindings.data();
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &_downsampleSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid descriptor set layout!");
+    }
+
+    // One cull set per frame slot, plus one downsample set per pyramid level (at most 16).
+    constexpr uint32_t maxLevels = 16;
+    constexpr uint32_t frames = Renderer::MAX_FRAMES_IN_FLIGHT;
+    VkDescriptorPoolSize poolSizes[3] = {
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, frames * 5 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, frames * (1 + maxLevels) },
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, frames * maxLevels }
+    };
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.maxSets = frames * (1 + maxLevels);
+    poolInfo.poolSizeCount = 3;
+    poolInfo.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create cull descriptor pool!");
+    }
+
+    // Only texelFetch is used; the sampler just has to exist.
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(device, &samplerInfo, nullptr, &_sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid sampler!");
+    }
+}
+
+void OcclusionCuller::createPipelines() {
+    VkDevice device = _vkContext->device();
+
+    VkPushConstantRange cullRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullPushConstants) };
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &_cullSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &cullRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &_cullPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create cull pipeline layout!");
+    }
+
+    VkPushConstantRange downsampleRange{ VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DownsamplePushConstants) };
+    pipelineLayoutInfo.pSetLayouts = &_downsampleSetLayout;
+    pipelineLayoutInfo.pPushConstantRanges = &downsampleRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &_downsamplePipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+    }
+
+    _cullPipeline = createComputePipeline("shaders/cull.comp.spv", _cullPipelineLayout);
+    _downsamplePipeline = createComputePipeline("shaders/hiz_downsample.comp.spv", _downsamplePipelineLayout);
+}
+
+VkPipeline OcclusionCuller::createComputePipeline(const char* shader, VkPipelineLayout layout) {
+    VkDevice device = _vkContext->device();
+    VkShaderModule module = _vkContext->createShaderModule(shader);
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = module;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = layout;
+
+    VkPipeline pipeline;
+    VkResult result = vkCreateComputePipelines(device, _vkContext->pipelineCache(), 1, &pipelineInfo, nullptr, &pipeline);
+    vkDestroyShaderModule(device, module, nullptr);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create cull compute pipeline!");
+    }
+    return pipeline;
+}
+
+void OcclusionCuller::createHostBuffer(VkDeviceSize size, VkBufferUsageFlags usage, HostBuffer& buffer) {
+    _vkContext->createBuffer(size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        buffer.buffer, buffer.memory);
+    vkMapMemory(_vkContext->device(), buffer.memory, 0, size, 0, &buffer.mapped);
+}
+
+void OcclusionCuller::destroyHostBuffer(HostBuffer& buffer) {
+    if (buffer.buffer == VK_NULL_HANDLE) return;
+    VkDevice device = _vkContext->device();
+    vkUnmapMemory(device, buffer.memory);
+    vkDestroyBuffer(device, buffer.buffer, nullptr);
+    vkFreeMemory(device, buffer.memory, nullptr);
+    buffer = {};
+}
+
+void OcclusionCuller::createBuffers() {
+    VkDevice device = _vkContext->device();
+    const VkDeviceSize objectsSize = MAX_OBJECTS * sizeof(Bounds);
+    const VkDeviceSize templatesSize = MAX_OBJECTS * sizeof(VkDrawIndexedIndirectCommand);
+    const VkDeviceSize drawsSize = 2 * templatesSize;  // phase 1 commands, then phase 2
+    const VkDeviceSize statsSize = sizeof(uint32_t) * 4;
+
+    _vkContext->createBuffer(MAX_OBJECTS * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, _visibility, _visibilityMemory);
+
+    for (auto& frame : _frames) {
+        createHostBuffer(objectsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frame.objects);
+        createHostBuffer(templatesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, frame.templates);
+        createHostBuffer(statsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, frame.stats);
+        _vkContext->createBuffer(drawsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, frame.draws, frame.drawsMemory);
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &_cullSetLayout;
+        if (vkAllocateDescriptorSets(device, &allocInfo, &frame.cullSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate cull descriptor set!");
+        }
+
+        // Binding 5 (the pyramid) is written whenever the pyramid is (re)created.
+        VkDescriptorBufferInfo bufferInfos[5] = {
+            { frame.objects.buffer, 0, objectsSize },
+            { frame.templates.buffer, 0, templatesSize },
+            { frame.draws, 0, drawsSize },
+            { _visibility, 0, VK_WHOLE_SIZE },
+            { frame.stats.buffer, 0, statsSize }
+        };
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = frame.cullSet;
+        write.dstBinding = 0;
+        write.descriptorCount = 5;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = bufferInfos;
+        vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+    }
+}
+
+void OcclusionCuller::createPyramid(Pyramid& pyramid, VkExtent2D extent) {
+    VkDevice device = _vkContext->device();
+    pyramid.extent = extent;
+    pyramid.levels = 1;
+    while ((std::max(extent.width, extent.height) >> pyramid.levels) > 0) pyramid.levels++;
+
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = pyramid.levels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = PYRAMID_FORMAT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(device, &imageInfo, nullptr, &pyramid.image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device, pyramid.image, &memRequirements);
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = _vkContext->findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(device, &allocInfo, nullptr, &pyramid.memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate depth pyramid memory!");
+    }
+    vkBindImageMemory(device, pyramid.image, pyramid.memory, 0);
+
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = pyramid.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = PYRAMID_FORMAT;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, pyramid.levels, 0, 1 };
+    if (vkCreateImageView(device, &viewInfo, nullptr, &pyramid.view) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create depth pyramid view!");
+    }
+
+    pyramid.levelViews.resize(pyramid.levels);
+    for (uint32_t level = 0; level < pyramid.levels; level++) {
+        viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+        if (vkCreateImageView(device, &viewInfo, nullptr, &pyramid.levelViews[level]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create depth pyramid level view!");
+        }
+    }
+
+    std::vector<VkDescriptorSetLayout> layouts(pyramid.levels, _downsampleSetLayout);
+    VkDescriptorSetAllocateInfo setAllocInfo{};
+    setAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setAllocInfo.descriptorPool = _descriptorPool;
+    setAllocInfo.descriptorSetCount = pyramid.levels;
+    setAllocInfo.pSetLayouts = layouts.data();
+    pyramid.downsampleSets.resize(pyramid.levels);
+    if (vkAllocateDescriptorSets(device, &setAllocInfo, pyramid.downsampleSets.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate depth pyramid descriptor sets!");
+    }
+
+    // Level 0 reads the scene depth, which can change with the viewport size; its
+    // input is written in buildDepthPyramid().
+    for (uint32_t level = 0; level < pyramid.levels; level++) {
+        VkDescriptorImageInfo inputInfo{ _sampler, level > 0 ? pyramid.levelViews[level - 1] : VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL };
+        VkDescriptorImageInfo outputInfo{ VK_NULL_HANDLE, pyramid.levelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = pyramid.downsampleSets[level];
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = 1;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[0].pImageInfo = &inputInfo;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = pyramid.downsampleSets[level];
+        writes[1].dstBinding = 1;
+        writes[1].descriptorCount = 1;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageInfo = &outputInfo;
+        if (level > 0) {
+            vkUpdateDescriptorSets(device, 2, writes.data(), 0, nullptr);
+        } else {
+            vkUpdateDescriptorSets(device, 1, &writes[1], 0, nullptr);
+        }
+    }
+}
+
+void OcclusionCuller::destroyPyramid(Pyramid& pyramid) {
+    if (pyramid.image == VK_NULL_HANDLE) return;
+    VkDevice device = _vkContext->device();
+    vkFreeDescriptorSets(device, _descriptorPool, static_cast<uint32_t>(pyramid.downsampleSets.size()), pyramid.downsampleSets.data());
+    for (VkImageView view : pyramid.levelViews) vkDestroyImageView(device, view, nullptr);
+    vkDestroyImageView(device, pyramid.view, nullptr);
+    vkDestroyImage(device, pyramid.image, nullptr);
+    vkFreeMemory(device, pyramid.memory, nullptr);
+    pyramid = {};
+}
+
+void OcclusionCuller::setObjects(const std::vector<Bounds>& bounds, const std::vector<VkDrawIndexedIndirectCommand>& draws) {
+    size_t count = std::min({ bounds.size(), draws.size(), static_cast<size_t>(MAX_OBJECTS) });
+    // Nothing is in flight while the culler has never been active.
+    if (count > 0 && _visibility == VK_NULL_HANDLE) createBuffers();
+    _bounds.assign(bounds.begin(), bounds.begin() + count);
+    _draws.assign(draws.begin(), draws.begin() + count);
+    // Indices may now refer to different objects; start over with "nothing was visible".
+    _visibilityReset = true;
+    for (auto& frame : _frames) frame.objectsDirty = true;
+}
+
+void OcclusionCuller::updateBounds(const std::vector<Bounds>& bounds) {
+    std::copy_n(bounds.begin(), std::min(bounds.size(), _bounds.size()), _bounds.begin());
+    for (auto& frame : _frames) frame.objectsDirty = true;
+}
+
+void OcclusionCuller::beginFrame(uint32_t frameIndex, VkExtent2D renderExtent) {
+    _frameIndex = frameIndex;
+    _renderExtent = renderExtent;
+    FrameData& frame = _frames[frameIndex];
+
+    if (frame.statsPending) {
+        const uint32_t* counters = static_cast<const uint32_t*>(frame.stats.mapped);
+        _stats = { counters[0], counters[1], counters[2] };
+        frame.statsPending = false;
+    }
+
+    // Frames still in flight use their own slot's copy, so this one can be rewritten.
+    if (frame.objectsDirty) {
+        if (!_bounds.empty()) {
+            std::memcpy(frame.objects.mapped, _bounds.data(), _bounds.size() * sizeof(Bounds));
+            std::memcpy(frame.templates.mapped, _draws.data(), _draws.size() * sizeof(VkDrawIndexedIndirectCommand));
+        }
+        frame.objectCount = static_cast<uint32_t>(_bounds.size());
+        frame.objectsDirty = false;
+    }
+
+    // Power-of-two pyramid so every level halves exactly; level 0 is at most the render size.
+    // None while there is nothing to cull.
+    VkExtent2D pyramidExtent{ 0, 0 };
+    if (frame.objectCount > 0 && renderExtent.width > 0 && renderExtent.height > 0) {
+        pyramidExtent = { previousPowerOfTwo(renderExtent.width), previousPowerOfTwo(renderExtent.height) };
+    }
+    Pyramid& pyramid = frame.pyramid;
+    if (pyramidExtent.width != pyramid.extent.width || pyramidExtent.height != pyramid.extent.height) {
+        destroyPyramid(pyramid);
+        if (pyramidExtent.width > 0) {
+            createPyramid(pyramid, pyramidExtent);
+
+            VkDescriptorImageInfo imageInfo{ _sampler, pyramid.view, VK_IMAGE_LAYOUT_GENERAL };
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstSet = frame.cullSet;
+            write.dstBinding = 5;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            write.pImageInfo = &imageInfo;
+            vkUpdateDescriptorSets(_vkContext->device(), 1, &write, 0, nullptr);
+        }
+    }
+
+    if (!active()) _stats = {};
+}
+
+bool OcclusionCuller::active() const {
+    const FrameData& frame = _frames[_frameIndex];
+    return frame.objectCount > 0 && frame.pyramid.levels > 0;
+}
+
+void OcclusionCuller::dispatchCull(VkCommandBuffer commandBuffer, uint32_t phase) {
+    const FrameData& frame = _frames[_frameIndex];
+
+    CullPushConstants constants{};
+    constants.viewProjection = _viewProjection;
+    constants.pyramidSize[0] = static_cast<int32_t>(frame.pyramid.extent.width);
+    constants.pyramidSize[1] = static_cast<int32_t>(frame.pyramid.extent.height);
+    constants.objectCount = frame.objectCount;
+    constants.phase = phase;
+    constants.drawOffset = phase * MAX_OBJECTS;
+    constants.pyramidLevels = frame.pyramid.levels;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _cullPipelineLayout, 0, 1, &frame.cullSet, 0, nullptr);
+    vkCmdPushConstants(commandBuffer, _cullPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+    vkCmdDispatch(commandBuffer, (frame.objectCount + 63) / 64, 1, 1);
+}
+
+void OcclusionCuller::addPasses(RenderGraph& graph, const glm::mat4& viewProjection, ViewportRenderer::SceneCallbacks& scene) {
+    if (!active()) return;
+    using Access = RenderGraph::Access;
+    FrameData& frame = _frames[_frameIndex];
+    _viewProjection = viewProjection;
+
+    // Visibility carries the previous frame's late results; everything else belongs to
+    // this slot, whose last frame has completed.
+    RenderGraph::ResourceId visibility = graph.importBuffer("cull visibility", _visibility,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    RenderGraph::ResourceId draws = graph.importBuffer("cull draws", frame.draws, 0);
+    RenderGraph::ResourceId stats = graph.importBuffer("cull stats", frame.stats.buffer, 0);
+    // The cull set samples the pyramid in GENERAL, even in the first phase that ignores it.
+    RenderGraph::ImageDesc pyramidDesc{ PYRAMID_FORMAT, frame.pyramid.extent,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+    RenderGraph::ResourceId pyramid = graph.importImage("depth pyramid", pyramidDesc, frame.pyramid.image, frame.pyramid.view,
+        frame.pyramid.inGeneralLayout ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_UNDEFINED, 0, VK_IMAGE_LAYOUT_GENERAL);
+    frame.pyramid.inGeneralLayout = true;
+
+    std::vector<RenderGraph::Use> resetUses = { RenderGraph::write(stats, Access::TransferDst) };
+    bool resetVisibility = _visibilityReset;
+    if (resetVisibility) resetUses.push_back(RenderGraph::write(visibility, Access::TransferDst));
+    _visibilityReset = false;
+    graph.addPass("cull reset", resetUses, [this, resetVisibility](VkCommandBuffer commandBuffer, RenderGraphExecutor&) {
+        if (resetVisibility) vkCmdFillBuffer(commandBuffer, _visibility, 0, VK_WHOLE_SIZE, 0);
+        vkCmdFillBuffer(commandBuffer, _frames[_frameIndex].stats.buffer, 0, VK_WHOLE_SIZE, 0);
+    });
+
+    graph.addPass("cull early", { RenderGraph::readWrite(visibility, Access::StorageCompute), RenderGraph::write(draws, Access::StorageCompute),
+                                  RenderGraph::readWrite(stats, Access::StorageCompute), RenderGraph::read(pyramid, Access::StorageCompute) },
+        [this](VkCommandBuffer commandBuffer, RenderGraphExecutor&) { dispatchCull(commandBuffer, 0); });
+
+    scene.drawEarly = [this](VkCommandBuffer commandBuffer) { recordDraws(commandBuffer, 0); };
+    scene.depthPyramid = [this](VkCommandBuffer commandBuffer, VkImageView depthView) {
+        buildDepthPyramid(commandBuffer, depthView);
+        cullLate(commandBuffer);
+    };
+    scene.drawLate = [this](VkCommandBuffer commandBuffer) { recordDraws(commandBuffer, MAX_OBJECTS * sizeof(VkDrawIndexedIndirectCommand)); };
+    scene.drawUses.push_back(RenderGraph::read(draws, Access::IndirectCommand));
+    scene.depthPyramidUses = { RenderGraph::write(pyramid, Access::StorageCompute), RenderGraph::readWrite(visibility, Access::StorageCompute),
+                               RenderGraph::readWrite(draws, Access::StorageCompute), RenderGraph::readWrite(stats, Access::StorageCompute) };
+}
+
+void OcclusionCuller::buildDepthPyramid(VkCommandBuffer commandBuffer, VkImageView depthView) {
+    const Pyramid& pyramid = _frames[_frameIndex].pyramid;
+
+    // This slot's previous command buffer has completed, so its level-0 set can be rewritten.
+    VkDescriptorImageInfo depthInfo{ _sampler, depthView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = pyramid.downsampleSets[0];
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &depthInfo;
+    vkUpdateDescriptorSets(_vkContext->device(), 1, &write, 0, nullptr);
+
+    // The graph has the pyramid in GENERAL and ordered after the early cull's reads;
+    // only the dependencies between its own levels are recorded here.
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = pyramid.image;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _downsamplePipeline);
+
+    VkExtent2D inputSize = _renderExtent;
+    for (uint32_t level = 0; level < pyramid.levels; level++) {
+        VkExtent2D outputSize{ std::max(1u, pyramid.extent.width >> level), std::max(1u, pyramid.extent.height >> level) };
+
+        DownsamplePushConstants constants{};
+        constants.inputSize[0] = static_cast<int32_t>(inputSize.width);
+        constants.inputSize[1] = static_cast<int32_t>(inputSize.height);
+        constants.outputSize[0] = static_cast<int32_t>(outputSize.width);
+        constants.outputSize[1] = static_cast<int32_t>(outputSize.height);
+
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _downsamplePipelineLayout, 0, 1,
+            &pyramid.downsampleSets[level], 0, nullptr);
+        vkCmdPushConstants(commandBuffer, _downsamplePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+        vkCmdDispatch(commandBuffer, (outputSize.width + 7) / 8, (outputSize.height + 7) / 8, 1);
+
+        // The next level (and finally the late cull) reads what was just written.
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+            0, nullptr, 0, nullptr, 1, &barrier);
+
+        inputSize = outputSize;
+    }
+}
+
+void OcclusionCuller::cullLate(VkCommandBuffer commandBuffer) {
+    FrameData& frame = _frames[_frameIndex];
+    dispatchCull(commandBuffer, 1);
+
+    // The host is outside the graph, so the stats readback keeps its own barrier.
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = frame.stats.buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+        0, nullptr, 1, &barrier, 0, nullptr);
+    frame.statsPending = true;
+}
+
+void OcclusionCuller::recordDraws(VkCommandBuffer commandBuffer, VkDeviceSize offset) {
+    const FrameData& frame = _frames[_frameIndex];
+    constexpr uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    if (_vkContext->multiDrawIndirect()) {
+        vkCmdDrawIndexedIndirect(commandBuffer, frame.draws, offset, frame.objectCount, stride);
+        return;
+    }
+    for (uint32_t i = 0; i < frame.objectCount; i++) {
+        vkCmdDrawIndexedIndirect(commandBuffer, frame.draws, offset + i * stride, 1, stride);
+    }
+}
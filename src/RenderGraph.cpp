@@ -0,0 +1,423 @@
+#include "RenderGraph.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+bool lifetimesOverlap(uint32_t firstA, uint32_t lastA, uint32_t firstB, uint32_t lastB) {
+    return firstA <= lastB && firstB <= lastA;
+}
+
+double megabytes(VkDeviceSize bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+void RenderGraph::reset() {
+    _resources.clear();
+    _passes.clear();
+    _compiled.clear();
+    _finalBarriers = {};
+    _heaps.clear();
+    _stats = {};
+}
+
+RenderGraph::ResourceId RenderGraph::createImage(const std::string& name, const ImageDesc& desc) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    _resources.push_back(std::move(resource));
+    return static_cast<ResourceId>(_resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::importImage(const std::string& name, const ImageDesc& desc, VkImage image, VkImageView view,
+                                                 VkImageLayout initialLayout, VkPipelineStageFlags initialStages, VkImageLayout finalLayout) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = true;
+    resource.image = image;
+    resource.view = view;
+    resource.initialLayout = initialLayout;
+    resource.initialStages = initialStages;
+    resource.finalLayout = finalLayout;
+    _resources.push_back(std::move(resource));
+    return static_cast<ResourceId>(_resources.size() - 1);
+}
+
+RenderGraph::ResourceId RenderGraph::importBuffer(const std::string& name, VkBuffer buffer, VkPipelineStageFlags initialStages,
+                                                  VkAccessFlags initialAccess) {
+    Resource resource;
+    resource.name = name;
+    resource.imported = true;
+    resource.bufferResource = true;
+    resource.buffer = buffer;
+    resource.initialStages = initialStages;
+    resource.initialAccess = initialAccess;
+    _resources.push_back(std::move(resource));
+    return static_cast<ResourceId>(_resources.size() - 1);
+}
+
+void RenderGraph::addPass(const std::string& name, std::vector<Use> uses, Record record, bool sideEffects) {
+    _passes.push_back({ name, std::move(uses), std::move(record), sideEffects });
+}
+
+RenderGraph::AccessInfo RenderGraph::accessInfo(Access access, VkImageAspectFlags aspect) {
+    VkImageLayout sampledLayout = (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+                                                                       : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    switch (access) {
+    case Access::ColorAttachment:
+        return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                 VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true, false };
+    case Access::DepthAttachment:
+        return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                 VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                 VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true, false };
+    case Access::SampledFragment:
+        return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, 0, sampledLayout, VK_IMAGE_USAGE_SAMPLED_BIT, true, false };
+    case Access::SampledCompute:
+        return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, 0, sampledLayout, VK_IMAGE_USAGE_SAMPLED_BIT, true, false };
+    case Access::StorageCompute:
+        return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true, true };
+    case Access::StorageVertex:
+        return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0, false, true };
+    case Access::IndirectCommand:
+        return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED, 0, false, true };
+    case Access::TransferSrc:
+        return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, 0, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, true, true };
+    case Access::TransferDst:
+        return { VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true, true };
+    }
+    throw std::runtime_error("render graph: unknown access!");
+}
+
+void RenderGraph::compile(const MemoryQuery& memoryQuery) {
+    _compiled.clear();
+    _finalBarriers = {};
+    _heaps.clear();
+    _stats = {};
+    for (Resource& resource : _resources) {
+        resource.firstUse = UINT32_MAX;
+        resource.lastUse = 0;
+        resource.lastStages = 0;
+        resource.lastWriteAccess = 0;
+        resource.placement = { NO_HEAP, 0, 0 };
+    }
+
+    validate();
+
+    std::vector<bool> alive = cullPasses();
+    for (uint32_t pass = 0; pass < _passes.size(); pass++) {
+        if (alive[pass]) _compiled.push_back({ pass, {} });
+    }
+    _stats.passes = static_cast<uint32_t>(_passes.size());
+    _stats.culledPasses = _stats.passes - static_cast<uint32_t>(_compiled.size());
+
+    computeLifetimes();
+    placeTransients(memoryQuery);
+    computeBarriers();
+}
+
+void RenderGraph::validate() const {
+    for (const Pass& pass : _passes) {
+        for (const Use& use : pass.uses) {
+            if (use.resource >= _resources.size()) {
+                throw std::runtime_error("render graph: pass '" + pass.name + "' uses an unknown resource!");
+            }
+            const Resource& resource = _resources[use.resource];
+            AccessInfo info = accessInfo(use.access, resource.desc.aspect);
+            bool buffer = resource.bufferResource;
+            if (buffer ? !info.buffer : !info.image) {
+                throw std::runtime_error("render graph: pass '" + pass.name + "' uses '" + resource.name + "' through an access for " +
+                                         (buffer ? "images" : "buffers") + "!");
+            }
+            if (!buffer && (resource.desc.usage & info.usage) != info.usage) {
+                throw std::runtime_error("render graph: '" + resource.name + "' lacks the usage pass '" + pass.name + "' needs!");
+            }
+            if (use.write && info.writeAccess == 0) {
+                throw std::runtime_error("render graph: pass '" + pass.name + "' writes '" + resource.name + "' through a read-only access!");
+            }
+        }
+    }
+}
+
+// Walks the passes backwards: a pass lives if it has side effects or writes something
+// a later live pass reads. Imported images are read by whoever comes after the frame.
+std::vector<bool> RenderGraph::cullPasses() const {
+    std::vector<bool> alive(_passes.size(), false);
+    std::vector<bool> needed(_resources.size(), false);
+    for (size_t i = 0; i < _resources.size(); i++) {
+        needed[i] = _resources[i].imported;
+    }
+
+    for (size_t i = _passes.size(); i-- > 0;) {
+        const Pass& pass = _passes[i];
+        bool live = pass.sideEffects;
+        for (const Use& use : pass.uses) {
+            if (use.write && needed[use.resource]) live = true;
+        }
+        if (!live) continue;
+
+        alive[i] = true;
+        // A plain write replaces the contents, so earlier writers no longer matter.
+        for (const Use& use : pass.uses) {
+            if (use.write && !use.read) needed[use.resource] = false;
+        }
+        for (const Use& use : pass.uses) {
+            if (use.read) needed[use.resource] = true;
+        }
+    }
+    return alive;
+}
+
+void RenderGraph::computeLifetimes() {
+    for (uint32_t i = 0; i < _compiled.size(); i++) {
+        for (const Use& use : _passes[_compiled[i].pass].uses) {
+            Resource& resource = _resources[use.resource];
+            AccessInfo info = accessInfo(use.access, resource.desc.aspect);
+            resource.firstUse = std::min(resource.firstUse, i);
+            resource.lastUse = std::max(resource.lastUse, i);
+            resource.lastStages |= info.stages;
+            if (use.write) resource.lastWriteAccess |= info.writeAccess;
+        }
+    }
+}
+
+// First fit, largest first: each image goes to the lowest aligned offset in its memory
+// type's heap that no image with an overlapping lifetime occupies.
+void RenderGraph::placeTransients(const MemoryQuery& memoryQuery) {
+    struct Candidate {
+        ResourceId resource;
+        MemoryRequirements requirements;
+    };
+    std::vector<Candidate> candidates;
+    for (ResourceId id = 0; id < _resources.size(); id++) {
+        const Resource& resource = _resources[id];
+        if (resource.imported || resource.firstUse == UINT32_MAX) continue;
+        candidates.push_back({ id, memoryQuery(resource.desc) });
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) {
+        return a.requirements.size > b.requirements.size;
+    });
+
+    struct Range {
+        VkDeviceSize begin;
+        VkDeviceSize end;
+    };
+    std::vector<ResourceId> placed;
+    std::vector<Range> taken;
+    for (const Candidate& candidate : candidates) {
+        Resource& resource = _resources[candidate.resource];
+        const MemoryRequirements& requirements = candidate.requirements;
+
+        uint32_t heap = 0;
+        while (heap < _heaps.size() && _heaps[heap].memoryTypeIndex != requirements.memoryTypeIndex) heap++;
+        if (heap == _heaps.size()) _heaps.push_back({ requirements.memoryTypeIndex, 0 });
+
+        taken.clear();
+        for (ResourceId other : placed) {
+            const Resource& o = _resources[other];
+            if (o.placement.heap != heap) continue;
+            if (!lifetimesOverlap(resource.firstUse, resource.lastUse, o.firstUse, o.lastUse)) continue;
+            taken.push_back({ o.placement.offset, o.placement.offset + o.placement.size });
+        }
+        std::sort(taken.begin(), taken.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+        VkDeviceSize offset = 0;
+        for (const Range& range : taken) {
+            if (alignUp(offset, requirements.alignment) + requirements.size <= range.begin) break;
+            offset = std::max(offset, range.end);
+        }
+        offset = alignUp(offset, requirements.alignment);
+
+        resource.placement = { heap, offset, requirements.size };
+        _heaps[heap].size = std::max(_heaps[heap].size, offset + requirements.size);
+        _stats.unaliasedBytes += requirements.size;
+        placed.push_back(candidate.resource);
+    }
+    for (const Heap& heap : _heaps) {
+        _stats.transientBytes += heap.size;
+    }
+}
+
+RenderGraph::MemoryLayout RenderGraph::memoryLayout() const {
+    MemoryLayout layout;
+    layout.heaps = _heaps;
+    for (ResourceId id = 0; id < _resources.size(); id++) {
+        if (allocated(id)) layout.images.push_back({ id, _resources[id].desc, _resources[id].placement });
+    }
+    return layout;
+}
+
+bool RenderGraph::MemoryLayout::operator==(const MemoryLayout& other) const {
+    if (heaps.size() != other.heaps.size() || images.size() != other.images.size()) return false;
+    for (size_t i = 0; i < heaps.size(); i++) {
+        if (heaps[i].memoryTypeIndex != other.heaps[i].memoryTypeIndex || heaps[i].size != other.heaps[i].size) return false;
+    }
+    for (size_t i = 0; i < images.size(); i++) {
+        const TransientImage& a = images[i];
+        const TransientImage& b = other.images[i];
+        if (a.resource != b.resource || a.desc.format != b.desc.format || a.desc.usage != b.desc.usage ||
+            a.desc.aspect != b.desc.aspect || a.desc.extent.width != b.desc.extent.width ||
+            a.desc.extent.height != b.desc.extent.height || a.placement.heap != b.placement.heap ||
+            a.placement.offset != b.placement.offset || a.placement.size != b.placement.size) return false;
+    }
+    return true;
+}
+
+bool RenderGraph::memoryOverlaps(const Resource& a, const Resource& b) const {
+    if (a.placement.heap == NO_HEAP || a.placement.heap != b.placement.heap) return false;
+    return a.placement.offset < b.placement.offset + b.placement.size && b.placement.offset < a.placement.offset + a.placement.size;
+}
+
+// Tracks each resource's layout, its last write and the reads since, and only emits a
+// barrier for a layout change, a write after anything, or a read in a stage the last
+// write hasn't been made visible to. Buffers are the same without layouts. A
+// transient's first use starts from UNDEFINED and waits on the images that used its
+// memory earlier this frame. Earlier frames need no wait: the executor backs each
+// frame slot with its own memory, and the slot's previous frame has completed.
+void RenderGraph::computeBarriers() {
+    struct State {
+        bool touched = false;
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags writeStages = 0;
+        VkAccessFlags writeAccess = 0;
+        VkPipelineStageFlags readStages = 0;
+        VkPipelineStageFlags visibleStages = 0;
+        VkAccessFlags visibleAccess = 0;
+    };
+    std::vector<State> states(_resources.size());
+
+    auto initialState = [&](ResourceId id) {
+        const Resource& resource = _resources[id];
+        State state;
+        state.touched = true;
+        if (resource.imported) {
+            state.layout = resource.initialLayout;
+            state.writeStages = resource.initialStages;
+            state.writeAccess = resource.initialAccess;
+            return state;
+        }
+        for (const Resource& other : _resources) {
+            if (other.lastUse < resource.firstUse && memoryOverlaps(resource, other)) {
+                state.writeStages |= other.lastStages;
+                state.writeAccess |= other.lastWriteAccess;
+            }
+        }
+        return state;
+    };
+
+    struct Merged {
+        ResourceId resource;
+        bool write;
+        VkPipelineStageFlags stages;
+        VkAccessFlags access;
+        VkAccessFlags writeAccess;
+        VkImageLayout layout;
+    };
+    std::vector<Merged> merged;
+
+    for (CompiledPass& compiled : _compiled) {
+        const Pass& pass = _passes[compiled.pass];
+
+        // One entry per resource, even if the pass lists it more than once.
+        merged.clear();
+        for (const Use& use : pass.uses) {
+            AccessInfo info = accessInfo(use.access, _resources[use.resource].desc.aspect);
+            if (isBuffer(use.resource)) info.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            // Attachments written by a pass are also read by it (blending, depth test).
+            bool attachment = use.access == Access::ColorAttachment || use.access == Access::DepthAttachment;
+            VkAccessFlags access = ((use.read || (use.write && attachment)) ? info.readAccess : 0) | (use.write ? info.writeAccess : 0);
+            VkAccessFlags writeAccess = use.write ? info.writeAccess : 0;
+
+            auto existing = std::find_if(merged.begin(), merged.end(), [&](const Merged& m) { return m.resource == use.resource; });
+            if (existing == merged.end()) {
+                merged.push_back({ use.resource, use.write, info.stages, access, writeAccess, info.layout });
+                continue;
+            }
+            if (existing->layout != info.layout) {
+                throw std::runtime_error("render graph: pass '" + pass.name + "' needs '" + _resources[use.resource].name + "' in two layouts!");
+            }
+            existing->write = existing->write || use.write;
+            existing->stages |= info.stages;
+            existing->access |= access;
+            existing->writeAccess |= writeAccess;
+        }
+
+        BarrierBatch& batch = compiled.barriers;
+        auto addBarrier = [&](ResourceId resource, VkImageLayout oldLayout, VkImageLayout newLayout, VkAccessFlags srcAccess, VkAccessFlags dstAccess) {
+            if (isBuffer(resource)) batch.buffers.push_back({ resource, srcAccess, dstAccess });
+            else batch.images.push_back({ resource, oldLayout, newLayout, srcAccess, dstAccess });
+        };
+        for (const Merged& use : merged) {
+            _stats.uses++;
+            State& state = states[use.resource];
+            if (!state.touched) state = initialState(use.resource);
+
+            bool layoutChange = use.layout != state.layout;
+            if (layoutChange || use.write) {
+                VkPipelineStageFlags src = state.writeStages | state.readStages;
+                if (layoutChange || src != 0) {
+                    addBarrier(use.resource, state.layout, use.layout, state.writeAccess, use.access);
+                    batch.srcStages |= src;
+                    batch.dstStages |= use.stages;
+                }
+                state.layout = use.layout;
+                // A layout transition counts as a write that later uses wait on.
+                state.writeStages = use.stages;
+                state.writeAccess = use.writeAccess;
+                state.readStages = use.write ? 0 : use.stages;
+                state.visibleStages = use.stages;
+                state.visibleAccess = use.access;
+                continue;
+            }
+
+            bool visible = (use.stages & ~state.visibleStages) == 0 && (use.access & ~state.visibleAccess) == 0;
+            if (!visible && state.writeStages != 0) {
+                addBarrier(use.resource, state.layout, state.layout, state.writeAccess, use.access);
+                batch.srcStages |= state.writeStages;
+                batch.dstStages |= use.stages;
+                state.visibleStages |= use.stages;
+                state.visibleAccess |= use.access;
+            }
+            state.readStages |= use.stages;
+        }
+
+        if (!batch.empty()) {
+            if (batch.srcStages == 0) batch.srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+            _stats.barrierBatches++;
+            _stats.imageBarriers += static_cast<uint32_t>(batch.images.size());
+            _stats.bufferBarriers += static_cast<uint32_t>(batch.buffers.size());
+        }
+    }
+
+    for (ResourceId id = 0; id < _resources.size(); id++) {
+        const Resource& resource = _resources[id];
+        if (!resource.imported || resource.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED) continue;
+        State state = states[id].touched ? states[id] : initialState(id);
+        if (state.layout == resource.finalLayout) continue;
+
+        _finalBarriers.images.push_back({ id, state.layout, resource.finalLayout, state.writeAccess, 0 });
+        _finalBarriers.srcStages |= state.writeStages | state.readStages;
+        _finalBarriers.dstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    }
+    if (!_finalBarriers.images.empty()) {
+        if (_finalBarriers.srcStages == 0) _finalBarriers.srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        _stats.barrierBatches++;
+        _stats.imageBarriers += static_cast<uint32_t>(_finalBarriers.images.size());
+    }
+}
+
+void RenderGraph::printStats(std::ostream& out) const {
+    out << "passes: " << _stats.passes << " (" << _stats.culledPasses << " culled)\n";
+    out << "barriers: " << _stats.imageBarriers << " image and " << _stats.bufferBarriers << " buffer barriers in "
+        << _stats.barrierBatches << " vkCmdPipelineBarrier calls for " << _stats.uses << " resource uses\n";
+    out << "transient memory: " << megabytes(_stats.transientBytes) << " MB aliased, "
+        << megabytes(_stats.unaliasedBytes) << " MB without aliasing\n";
+}
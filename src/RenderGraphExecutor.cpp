@@ -0,0 +1,190 @@
+#include "RenderGraphExecutor.h"
+#include "Renderer.h"
+#include <stdexcept>
+
+void RenderGraphExecutor::init(VulkanContext* context, Renderer* renderer) {
+    _vkContext = context;
+    _renderer = renderer;
+}
+
+void RenderGraphExecutor::cleanup() {
+    for (Allocation& allocation : _allocations) {
+        destroy(allocation);
+    }
+}
+
+VkImage RenderGraphExecutor::createImage(const RenderGraph::ImageDesc& desc) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { desc.extent.width, desc.extent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = desc.format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = desc.usage;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    VkImage image;
+    if (vkCreateImage(_vkContext->device(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create render graph image!");
+    }
+    return image;
+}
+
+RenderGraph::MemoryRequirements RenderGraphExecutor::memoryRequirements(const RenderGraph::ImageDesc& desc) {
+    // Only asked again when an image changes shape, e.g. on resize.
+    RequirementsKey key{ desc.format, desc.extent.width, desc.extent.height, desc.usage };
+    auto it = _requirements.find(key);
+    if (it != _requirements.end()) return it->second;
+
+    VkImage probe = createImage(desc);
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(_vkContext->device(), probe, &requirements);
+    vkDestroyImage(_vkContext->device(), probe, nullptr);
+
+    RenderGraph::MemoryRequirements result{ requirements.size, requirements.alignment,
+        _vkContext->findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) };
+    _requirements.emplace(key, result);
+    return result;
+}
+
+RenderGraphExecutor::Allocation RenderGraphExecutor::allocate(RenderGraph::MemoryLayout layout, uint32_t resourceCount) {
+    VkDevice device = _vkContext->device();
+    Allocation allocation;
+    allocation.layout = std::move(layout);
+    allocation.images.resize(resourceCount);
+
+    for (const RenderGraph::Heap& heap : allocation.layout.heaps) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = heap.size;
+        allocInfo.memoryTypeIndex = heap.memoryTypeIndex;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate render graph memory!");
+        }
+        allocation.heaps.push_back(memory);
+    }
+
+    for (const RenderGraph::TransientImage& transient : allocation.layout.images) {
+        Image& image = allocation.images[transient.resource];
+        image.image = createImage(transient.desc);
+        vkBindImageMemory(device, image.image, allocation.heaps[transient.placement.heap], transient.placement.offset);
+        image.view = _vkContext->createImageView(image.image, transient.desc.format, transient.desc.aspect);
+    }
+    return allocation;
+}
+
+void RenderGraphExecutor::destroy(Allocation& allocation) {
+    VkDevice device = _vkContext->device();
+    for (Framebuffer& framebuffer : allocation.framebuffers) {
+        vkDestroyFramebuffer(device, framebuffer.framebuffer, nullptr);
+    }
+    for (Image& image : allocation.images) {
+        if (image.image == VK_NULL_HANDLE) continue;
+        vkDestroyImageView(device, image.view, nullptr);
+        vkDestroyImage(device, image.image, nullptr);
+    }
+    for (VkDeviceMemory memory : allocation.heaps) {
+        vkFreeMemory(device, memory, nullptr);
+    }
+    allocation = {};
+}
+
+void RenderGraphExecutor::execute(RenderGraph& graph, VkCommandBuffer commandBuffer) {
+    graph.compile([this](const RenderGraph::ImageDesc& desc) { return memoryRequirements(desc); });
+
+    Allocation& allocation = _allocations[_renderer->currentFrame()];
+    RenderGraph::MemoryLayout layout = graph.memoryLayout();
+    if (layout != allocation.layout) {
+        _renderer->retire([this, retired = std::move(allocation)]() mutable { destroy(retired); });
+        allocation = allocate(std::move(layout), graph.resourceCount());
+    }
+
+    _graph = &graph;
+    _allocation = &allocation;
+    for (const RenderGraph::CompiledPass& compiled : graph.compiledPasses()) {
+        recordBarriers(commandBuffer, compiled.barriers);
+        const RenderGraph::Record& record = graph.passRecord(compiled.pass);
+        if (record) record(commandBuffer, *this);
+    }
+    recordBarriers(commandBuffer, graph.finalBarriers());
+    _graph = nullptr;
+    _allocation = nullptr;
+    _stats = graph.stats();
+}
+
+void RenderGraphExecutor::recordBarriers(VkCommandBuffer commandBuffer, const RenderGraph::BarrierBatch& batch) {
+    if (batch.empty()) return;
+
+    std::vector<VkImageMemoryBarrier> barriers(batch.images.size());
+    for (size_t i = 0; i < batch.images.size(); i++) {
+        const RenderGraph::ImageBarrier& source = batch.images[i];
+        VkImageMemoryBarrier& barrier = barriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = source.srcAccess;
+        barrier.dstAccessMask = source.dstAccess;
+        barrier.oldLayout = source.oldLayout;
+        barrier.newLayout = source.newLayout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image(source.resource);
+        barrier.subresourceRange.aspectMask = _graph->desc(source.resource).aspect;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.layerCount = 1;
+    }
+    std::vector<VkBufferMemoryBarrier> bufferBarriers(batch.buffers.size());
+    for (size_t i = 0; i < batch.buffers.size(); i++) {
+        const RenderGraph::BufferBarrier& source = batch.buffers[i];
+        VkBufferMemoryBarrier& barrier = bufferBarriers[i];
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = source.srcAccess;
+        barrier.dstAccessMask = source.dstAccess;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = _graph->importedBuffer(source.resource);
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+    }
+    vkCmdPipelineBarrier(commandBuffer, batch.srcStages, batch.dstStages, 0, 0, nullptr,
+        static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(), static_cast<uint32_t>(barriers.size()), barriers.data());
+}
+
+VkImage RenderGraphExecutor::image(RenderGraph::ResourceId resource) const {
+    return _graph->imported(resource) ? _graph->importedImage(resource) : _allocation->images[resource].image;
+}
+
+VkImageView RenderGraphExecutor::view(RenderGraph::ResourceId resource) const {
+    return _graph->imported(resource) ? _graph->importedView(resource) : _allocation->images[resource].view;
+}
+
+VkFramebuffer RenderGraphExecutor::framebuffer(VkRenderPass renderPass, std::initializer_list<RenderGraph::ResourceId> attachments) {
+    std::vector<VkImageView> views;
+    for (RenderGraph::ResourceId attachment : attachments) {
+        views.push_back(view(attachment));
+    }
+    for (const Framebuffer& cached : _allocation->framebuffers) {
+        if (cached.renderPass == renderPass && cached.views == views) return cached.framebuffer;
+    }
+
+    VkExtent2D extent = _graph->desc(*attachments.begin()).extent;
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = renderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+    framebufferInfo.pAttachments = views.data();
+    framebufferInfo.width = extent.width;
+    framebufferInfo.height = extent.height;
+    framebufferInfo.layers = 1;
+
+    VkFramebuffer framebuffer;
+    if (vkCreateFramebuffer(_vkContext->device(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create render graph framebuffer!");
+    }
+    _allocation->framebuffers.push_back({ renderPass, std::move(views), framebuffer });
+    return framebuffer;
+}
@@ -2,8 +2,9 @@
 #include <stdexcept>
 #include <array>
 
-void Renderer::init(VulkanContext* context) {
+void Renderer::init(VulkanContext* context, GLFWwindow* window) {
     _vkContext = context;
+    _window = window;
     createRenderPass();
     createFramebuffers();
     createCommandPool();
@@ -12,16 +13,15 @@ void Renderer::init(VulkanContext* context) {
 }
 
 void Renderer::cleanup() {
+    releaseRetired(true);
     VkDevice device = _vkContext->device();
-    for (size_t i = 0; i < 2; i++) {
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vkDestroySemaphore(device, _renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(device, _imageAvailableSemaphores[i], nullptr);
-        vkDestroyFence(device, _inFlightFences[i], nullptr);
     }
+    vkDestroySemaphore(device, _graphicsTimeline, nullptr);
     vkDestroyCommandPool(device, _commandPool, nullptr);
-    for (auto framebuffer : _swapChainFramebuffers) {
-        vkDestroyFramebuffer(device, framebuffer, nullptr);
-    }
+    destroyFramebuffers();
     vkDestroyRenderPass(device, _renderPass, nullptr);
 }
 
@@ -33,8 +33,9 @@ void Renderer::createRenderPass() {
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // The render graph moves the image into and out of the attachment layout.
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
     VkAttachmentReference colorAttachmentRef{};
     colorAttachmentRef.attachment = 0;
@@ -45,22 +46,12 @@ void Renderer::createRenderPass() {
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &colorAttachmentRef;
 
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
     VkRenderPassCreateInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     renderPassInfo.attachmentCount = 1;
     renderPassInfo.pAttachments = &colorAttachment;
     renderPassInfo.subpassCount = 1;
     renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
 
     if (vkCreateRenderPass(_vkContext->device(), &renderPassInfo, nullptr, &_renderPass) != VK_SUCCESS) {
         throw std::runtime_error("failed to create render pass!");
@@ -88,6 +79,21 @@ void Renderer::createFramebuffers() {
     }
 }
 
+void Renderer::destroyFramebuffers() {
+    for (auto framebuffer : _swapChainFramebuffers) {
+        vkDestroyFramebuffer(_vkContext->device(), framebuffer, nullptr);
+    }
+    _swapChainFramebuffers.clear();
+}
+
+void Renderer::recreateSwapChain() {
+    // The image format comes from the surface's fixed format list, so the render pass stays valid.
+    vkDeviceWaitIdle(_vkContext->device());
+    destroyFramebuffers();
+    _vkContext->recreateSwapChain(_window);
+    createFramebuffers();
+}
+
 void Renderer::createCommandPool() {
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -100,7 +106,7 @@ void Renderer::createCommandPool() {
 }
 
 void Renderer::createCommandBuffers() {
-    _commandBuffers.resize(2); // Double buffering
+    _commandBuffers.resize(MAX_FRAMES_IN_FLIGHT); // Double buffering
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.commandPool = _commandPool;
@@ -113,36 +119,86 @@ void Renderer::createCommandBuffers() {
 }
 
 void Renderer::createSyncObjects() {
-    _imageAvailableSemaphores.resize(2);
-    _renderFinishedSemaphores.resize(2);
-    _inFlightFences.resize(2);
+    _imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
+    _renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-    for (size_t i = 0; i < 2; i++) {
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         if (vkCreateSemaphore(_vkContext->device(), &semaphoreInfo, nullptr, &_imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(_vkContext->device(), &semaphoreInfo, nullptr, &_renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(_vkContext->device(), &fenceInfo, nullptr, &_inFlightFences[i]) != VK_SUCCESS) {
+            vkCreateSemaphore(_vkContext->device(), &semaphoreInfo, nullptr, &_renderFinishedSemaphores[i]) != VK_SUCCESS) {
             throw std::runtime_error("failed to create synchronization objects!");
         }
     }
+    _graphicsTimeline = createTimeline();
+}
+
+VkSemaphore Renderer::createTimeline() {
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+
+    VkSemaphore timeline;
+    if (vkCreateSemaphore(_vkContext->device(), &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timeline semaphore!");
+    }
+    return timeline;
+}
+
+void Renderer::waitTimeline(VkSemaphore timeline, uint64_t value) {
+    if (value == 0) return;
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &timeline;
+    waitInfo.pValues = &value;
+    vkWaitSemaphores(_vkContext->device(), &waitInfo, UINT64_MAX);
+}
+
+void Renderer::pace() {
+    // Frame N - 1 signals N: waiting for it leaves nothing queued ahead of this frame.
+    if (_pacing == Pacing::LowLatency) waitTimeline(_graphicsTimeline, _frameNumber);
 }
 
 void Renderer::beginFrame() {
-    vkWaitForFences(_vkContext->device(), 1, &_inFlightFences[_currentFrame], VK_TRUE, UINT64_MAX);
-    vkAcquireNextImageKHR(_vkContext->device(), _vkContext->swapChain(), UINT64_MAX, _imageAvailableSemaphores[_currentFrame], VK_NULL_HANDLE, &_imageIndex);
-    vkResetFences(_vkContext->device(), 1, &_inFlightFences[_currentFrame]);
+    // The frame that last used this slot, N - MAX_FRAMES_IN_FLIGHT, signals N + 1 - MAX_FRAMES_IN_FLIGHT.
+    if (_frameNumber >= MAX_FRAMES_IN_FLIGHT) waitTimeline(_graphicsTimeline, _frameNumber + 1 - MAX_FRAMES_IN_FLIGHT);
+    releaseRetired(false);
+    // An out-of-date acquire signals nothing, so the semaphore can be reused for the retry.
+    VkResult result = vkAcquireNextImageKHR(_vkContext->device(), _vkContext->swapChain(), UINT64_MAX, _imageAvailableSemaphores[_currentFrame], VK_NULL_HANDLE, &_imageIndex);
+    while (result == VK_ERROR_OUT_OF_DATE_KHR) {
+        recreateSwapChain();
+        result = vkAcquireNextImageKHR(_vkContext->device(), _vkContext->swapChain(), UINT64_MAX, _imageAvailableSemaphores[_currentFrame], VK_NULL_HANDLE, &_imageIndex);
+    }
+    if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+        throw std::runtime_error("failed to acquire swap chain image!");
+    }
 
     vkResetCommandBuffer(_commandBuffers[_currentFrame], 0);
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     vkBeginCommandBuffer(_commandBuffers[_currentFrame], &beginInfo);
+}
+
+void Renderer::retire(std::function<void()> destroy) {
+    _retired.push_back({ _frameNumber, std::move(destroy) });
+}
+
+void Renderer::releaseRetired(bool all) {
+    // Frames up to _frameNumber - MAX_FRAMES_IN_FLIGHT have completed.
+    while (!_retired.empty() && (all || _retired.front().frameNumber + MAX_FRAMES_IN_FLIGHT <= _frameNumber)) {
+        _retired.front().destroy();
+        _retired.pop_front();
+    }
+}
 
+void Renderer::beginUIPass() {
     VkRenderPassBeginInfo renderPassInfo{};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = _renderPass;
@@ -155,50 +211,68 @@ void Renderer::beginFrame() {
     renderPassInfo.pClearValues = &clearColor;
 
     vkCmdBeginRenderPass(_commandBuffers[_currentFrame], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
 
-    // --- PROFESIONAL 3D MESH RENDERING WOULD GO HERE ---
-    // vkCmdBindPipeline(...)
-    // vkCmdBindDescriptorSets(...)
-    // vkCmdBindVertexBuffers(...)
-    // vkCmdDrawIndexed(...)
-    // ----------------------------------------------------
+void Renderer::endUIPass() {
+    vkCmdEndRenderPass(_commandBuffers[_currentFrame]);
+}
+
+RenderGraph::ResourceId Renderer::importSwapChainImage(RenderGraph& graph) {
+    RenderGraph::ImageDesc desc;
+    desc.format = _vkContext->swapChainImageFormat();
+    desc.extent = _vkContext->swapChainExtent();
+    desc.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    // Acquire's semaphore is waited on at COLOR_ATTACHMENT_OUTPUT, so the first transition waits there too.
+    return graph.importImage("swapchain", desc, _vkContext->swapChainImages()[_imageIndex], _vkContext->swapChainImageViews()[_imageIndex],
+                             VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 }
 
 void Renderer::endFrame() {
-    vkCmdEndRenderPass(_commandBuffers[_currentFrame]);
     vkEndCommandBuffer(_commandBuffers[_currentFrame]);
 
+    // The binary semaphore ignores its entry in the value array.
+    VkSemaphore signalSemaphores[] = {_renderFinishedSemaphores[_currentFrame], _graphicsTimeline};
+    uint64_t signalValues[] = {0, _frameNumber + 1};
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 2;
+    timelineInfo.pSignalSemaphoreValues = signalValues;
+
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    VkSemaphore waitSemaphores[] = {_imageAvailableSemaphores[_currentFrame]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    submitInfo.pNext = &timelineInfo;
     submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
+    submitInfo.pWaitSemaphores = &_imageAvailableSemaphores[_currentFrame];
+    submitInfo.pWaitDstStageMask = &waitStage;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &_commandBuffers[_currentFrame];
-
-    VkSemaphore signalSemaphores[] = {_renderFinishedSemaphores[_currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = 2;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if (vkQueueSubmit(_vkContext->graphicsQueue(), 1, &submitInfo, _inFlightFences[_currentFrame]) != VK_SUCCESS) {
+    if (vkQueueSubmit(_vkContext->graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
 
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.pWaitSemaphores = &_renderFinishedSemaphores[_currentFrame];
     VkSwapchainKHR swapChains[] = {_vkContext->swapChain()};
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = &_imageIndex;
 
-    vkQueuePresentKHR(_vkContext->presentQueue(), &presentInfo);
+    VkResult result = vkQueuePresentKHR(_vkContext->presentQueue(), &presentInfo);
+    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
+        recreateSwapChain();
+    } else if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to present swap chain image!");
+    }
 
-    _currentFrame = (_currentFrame + 1) % 2;
+    _currentFrame = (_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    _frameNumber++;
 }
 
 VkCommandBuffer Renderer::currentCommandBuffer() {
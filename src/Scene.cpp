@@ -0,0 +1,66 @@
+#include "Scene.h"
+#include <stdexcept>
+
+const char* entityTypeName(EntityType type) {
+    switch (type) {
+        case EntityType::Empty: return "Empty";
+        case EntityType::Camera: return "Camera";
+        case EntityType::Light: return "Light";
+        case EntityType::Mesh: return "Mesh";
+        default: return "Unknown";
+    }
+}
+
+Scene::Scene() {
+    _names.push_back("Untitled Scene");
+    _types.push_back(EntityType::Empty);
+    _parents.push_back(ROOT_ENTITY);
+    _firstChildren.push_back(NULL_ENTITY);
+    _lastChildren.push_back(NULL_ENTITY);
+    _nextSiblings.push_back(NULL_ENTITY);
+}
+
+void Scene::reserve(size_t count) {
+    _names.reserve(count);
+    _types.reserve(count);
+    _parents.reserve(count);
+    _firstChildren.reserve(count);
+    _lastChildren.reserve(count);
+    _nextSiblings.reserve(count);
+}
+
+Entity Scene::createEntity(std::string name, EntityType type, Entity parent) {
+    if (parent >= _names.size()) {
+        throw std::runtime_error("invalid parent entity!");
+    }
+
+    Entity entity = static_cast<Entity>(_names.size());
+    _names.push_back(std::move(name));
+    _types.push_back(type);
+    _parents.push_back(parent);
+    _firstChildren.push_back(NULL_ENTITY);
+    _lastChildren.push_back(NULL_ENTITY);
+    _nextSiblings.push_back(NULL_ENTITY);
+
+    if (_lastChildren[parent] == NULL_ENTITY) {
+        _firstChildren[parent] = entity;
+    } else {
+        _nextSiblings[_lastChildren[parent]] = entity;
+    }
+    _lastChildren[parent] = entity;
+
+    for (Listener* listener : _listeners) {
+        listener->onEntityCreated(*this, entity);
+    }
+    return entity;
+}
+
+void Scene::renameEntity(Entity entity, std::string name) {
+    if (!isValid(entity)) return;
+
+    std::string oldName = std::move(_names[entity]);
+    _names[entity] = std::move(name);
+    for (Listener* listener : _listeners) {
+        listener->onEntityRenamed(*this, entity, oldName);
+    }
+}
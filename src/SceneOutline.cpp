@@ -0,0 +1,136 @@
+#include "SceneOutline.h"
+#include <algorithm>
+#include <utility>
+
+void SceneOutline::init(Scene* scene) {
+    _scene = scene;
+    _scene->addListener(this);
+    _rowOf.assign(_scene->entityCount(), HIDDEN_ROW);
+    _expanded.assign(_scene->entityCount(), 0);
+    _expanded[ROOT_ENTITY] = 1;
+    rebuild();
+}
+
+void SceneOutline::onEntityCreated(const Scene&, Entity entity) {
+    _rowOf.push_back(HIDDEN_ROW);
+    _expanded.push_back(0);
+    _pending.push_back(entity);
+}
+
+void SceneOutline::sync() {
+    if (_pending.empty()) return;
+
+    if (_pending.size() > REBUILD_THRESHOLD) {
+        _pending.clear();
+        rebuild();
+        return;
+    }
+
+    // New entities are always appended as the last child, so each lands where its
+    // parent's visible subtree ends in the current rows. Children of other pending
+    // entities never show: new entities start collapsed.
+    struct Insert {
+        size_t at;
+        Row row;
+    };
+    std::vector<Insert> inserts;
+    for (Entity entity : _pending) {
+        Entity parent = _scene->parent(entity);
+        if (_rowOf[parent] == HIDDEN_ROW || !_expanded[parent]) continue;
+        inserts.push_back({ subtreeEndRow(parent), { entity, _rows[_rowOf[parent]].depth + 1 } });
+    }
+    _pending.clear();
+    if (inserts.empty()) return;
+
+    // Rows meeting at one position close nested subtrees: the deepest goes first, and
+    // siblings keep creation order. Then one merge and one reindex for the whole batch.
+    std::stable_sort(inserts.begin(), inserts.end(), [](const Insert& a, const Insert& b) {
+        return a.at != b.at ? a.at < b.at : a.row.depth > b.row.depth;
+    });
+    // Merged in place from the back, so only rows after the first insert move.
+    size_t first = inserts.front().at;
+    size_t read = _rows.size();
+    _rows.resize(_rows.size() + inserts.size());
+    size_t write = _rows.size();
+    for (size_t next = inserts.size(); next > 0; next--) {
+        while (read > inserts[next - 1].at) _rows[--write] = _rows[--read];
+        _rows[--write] = inserts[next - 1].row;
+    }
+    reindexFrom(first);
+}
+
+void SceneOutline::setExpanded(Entity entity, bool expanded) {
+    if (isExpanded(entity) == expanded) return;
+    // Pending entities must have their rows first, or expanding would list them twice.
+    sync();
+    _expanded[entity] = expanded ? 1 : 0;
+
+    uint32_t row = _rowOf[entity];
+    if (row == HIDDEN_ROW) return;
+
+    if (expanded) {
+        std::vector<Row> descendants;
+        collectVisibleDescendants(entity, _rows[row].depth + 1, descendants);
+        insertRows(row + 1, descendants);
+    } else {
+        // Rows after `row` up to the next sibling are exactly the previously visible subtree.
+        size_t end = row + 1;
+        while (end < _rows.size() && _rows[end].depth > _rows[row].depth) end++;
+        eraseRows(row + 1, end);
+    }
+}
+
+void SceneOutline::rebuild() {
+    for (const Row& row : _rows) _rowOf[row.entity] = HIDDEN_ROW;
+    _rows.clear();
+    _rows.push_back({ ROOT_ENTITY, 0 });
+    collectVisibleDescendants(ROOT_ENTITY, 1, _rows);
+    reindexFrom(0);
+}
+
+void SceneOutline::collectVisibleDescendants(Entity entity, uint32_t depth, std::vector<Row>& out) const {
+    if (!_expanded[entity]) return;
+
+    // Iterative pre-order walk; scenes can be deep enough to overflow a recursive one.
+    std::vector<std::pair<Entity, uint32_t>> stack;
+    if (_scene->firstChild(entity) != NULL_ENTITY) stack.push_back({ _scene->firstChild(entity), depth });
+    while (!stack.empty()) {
+        auto [current, currentDepth] = stack.back();
+        stack.pop_back();
+        out.push_back({ current, currentDepth });
+
+        if (_scene->nextSibling(current) != NULL_ENTITY) stack.push_back({ _scene->nextSibling(current), currentDepth });
+        if (_expanded[current] && _scene->firstChild(current) != NULL_ENTITY) stack.push_back({ _scene->firstChild(current), currentDepth + 1 });
+    }
+}
+
+size_t SceneOutline::subtreeEndRow(Entity entity) const {
+    // The visible subtree ends at the row of the nearest following sibling of the
+    // entity or one of its ancestors. That is O(depth) instead of a row scan.
+    // Siblings still waiting in _pending have no row yet and are skipped.
+    for (Entity current = entity; current != ROOT_ENTITY; current = _scene->parent(current)) {
+        Entity sibling = _scene->nextSibling(current);
+        while (sibling != NULL_ENTITY && _rowOf[sibling] == HIDDEN_ROW) sibling = _scene->nextSibling(sibling);
+        if (sibling != NULL_ENTITY) return _rowOf[sibling];
+    }
+    return _rows.size();
+}
+
+void SceneOutline::insertRows(size_t at, const std::vector<Row>& rows) {
+    if (rows.empty()) return;
+    _rows.insert(_rows.begin() + at, rows.begin(), rows.end());
+    reindexFrom(at);
+}
+
+void SceneOutline::eraseRows(size_t begin, size_t end) {
+    if (begin >= end) return;
+    for (size_t i = begin; i < end; i++) _rowOf[_rows[i].entity] = HIDDEN_ROW;
+    _rows.erase(_rows.begin() + begin, _rows.begin() + end);
+    reindexFrom(begin);
+}
+
+void SceneOutline::reindexFrom(size_t row) {
+    for (size_t i = row; i < _rows.size(); i++) {
+        _rowOf[_rows[i].entity] = static_cast<uint32_t>(i);
+    }
+}
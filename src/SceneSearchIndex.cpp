@@ -0,0 +1,140 @@
+#include "SceneSearchIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+namespace {
+
+char lowerChar(char c) {
+    return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+std::string toLower(const std::string& text) {
+    std::string result(text.size(), '\0');
+    std::transform(text.begin(), text.end(), result.begin(), lowerChar);
+    return result;
+}
+
+uint32_t trigramKey(const char* text) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(text[0])) |
+           static_cast<uint32_t>(static_cast<uint8_t>(text[1])) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(text[2])) << 16;
+}
+
+// Unique trigrams of an already lower-cased string.
+std::vector<uint32_t> trigramsOf(const std::string& text) {
+    std::vector<uint32_t> result;
+    if (text.size() < 3) return result;
+    result.reserve(text.size() - 2);
+    for (size_t i = 0; i + 3 <= text.size(); i++) result.push_back(trigramKey(text.data() + i));
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+bool containsIgnoreCase(const std::string& haystack, const std::string& lowerNeedle) {
+    auto it = std::search(haystack.begin(), haystack.end(), lowerNeedle.begin(), lowerNeedle.end(),
+        [](char a, char b) { return lowerChar(a) == b; });
+    return it != haystack.end();
+}
+
+} // namespace
+
+void SceneSearchIndex::init(Scene* scene) {
+    _scene = scene;
+    _scene->addListener(this);
+    for (Entity entity = 1; entity < _scene->entityCount(); entity++) {
+        onEntityCreated(*_scene, entity);
+    }
+}
+
+void SceneSearchIndex::onEntityCreated(const Scene& scene, Entity entity) {
+    // Ids only ever grow, so appending keeps every posting list sorted.
+    _byType[static_cast<size_t>(scene.type(entity))].push_back(entity);
+    indexName(entity, scene.name(entity));
+    _generation++;
+}
+
+void SceneSearchIndex::onEntityRenamed(const Scene& scene, Entity entity, const std::string& oldName) {
+    unindexName(entity, oldName);
+    indexName(entity, scene.name(entity));
+    _generation++;
+}
+
+void SceneSearchIndex::indexName(Entity entity, const std::string& name) {
+    for (uint32_t trigram : trigramsOf(toLower(name))) {
+        std::vector<Entity>& list = _trigrams[trigram];
+        if (list.empty() || list.back() < entity) {
+            list.push_back(entity);
+        } else {
+            list.insert(std::lower_bound(list.begin(), list.end(), entity), entity);
+        }
+    }
+}
+
+void SceneSearchIndex::unindexName(Entity entity, const std::string& name) {
+    for (uint32_t trigram : trigramsOf(toLower(name))) {
+        auto found = _trigrams.find(trigram);
+        if (found == _trigrams.end()) continue;
+        std::vector<Entity>& list = found->second;
+        auto it = std::lower_bound(list.begin(), list.end(), entity);
+        if (it != list.end() && *it == entity) list.erase(it);
+        if (list.empty()) _trigrams.erase(found);
+    }
+}
+
+void SceneSearchIndex::candidatesFromTrigrams(const std::string& query, std::vector<Entity>& out) const {
+    std::vector<const std::vector<Entity>*> lists;
+    for (uint32_t trigram : trigramsOf(query)) {
+        auto found = _trigrams.find(trigram);
+        if (found == _trigrams.end()) return;
+        lists.push_back(&found->second);
+    }
+
+    // Intersect smallest-first so the working set shrinks as fast as possible.
+    std::sort(lists.begin(), lists.end(), [](auto* a, auto* b) { return a->size() < b->size(); });
+    out = *lists[0];
+    std::vector<Entity> scratch;
+    for (size_t i = 1; i < lists.size() && !out.empty(); i++) {
+        scratch.clear();
+        std::set_intersection(out.begin(), out.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(scratch));
+        out.swap(scratch);
+    }
+}
+
+bool SceneSearchIndex::matches(Entity entity, const std::string& query, std::optional<EntityType> type) const {
+    if (type && _scene->type(entity) != *type) return false;
+    return query.empty() || containsIgnoreCase(_scene->name(entity), query);
+}
+
+const std::vector<Entity>& SceneSearchIndex::search(const std::string& text, std::optional<EntityType> type) {
+    std::string query = toLower(text);
+    bool refinesLast = _lastGeneration == _generation && _lastType == type &&
+                       query.find(_lastQuery) != std::string::npos;
+    if (refinesLast && query == _lastQuery) return _results;
+
+    std::vector<Entity> candidates;
+    if (refinesLast) {
+        // Anything matching the longer query also matched the shorter one.
+        candidates.swap(_results);
+    } else if (query.size() >= 3) {
+        candidatesFromTrigrams(query, candidates);
+    } else if (type) {
+        candidates = _byType[static_cast<size_t>(*type)];
+    } else {
+        // Too short for a trigram: one linear scan over the names (none are read for an
+        // empty query), which the next character refines instead of repeating.
+        candidates.resize(_scene->entityCount() - 1);
+        for (size_t i = 0; i < candidates.size(); i++) candidates[i] = static_cast<Entity>(i + 1);
+    }
+
+    _results.clear();
+    for (Entity entity : candidates) {
+        if (matches(entity, query, type)) _results.push_back(entity);
+    }
+
+    _lastQuery = std::move(query);
+    _lastType = type;
+    _lastGeneration = _generation;
+    return _results;
+}
@@ -0,0 +1,38 @@
+#include "Selection.h"
+
+void Selection::add(Entity entity) {
+    _primary = entity;
+    if (contains(entity)) return;
+    if (entity >= _slots.size()) _slots.resize(static_cast<size_t>(entity) + 1);
+    _slots[entity] = static_cast<uint32_t>(_entities.size());
+    _entities.push_back(entity);
+    _generation++;
+}
+
+void Selection::remove(Entity entity) {
+    if (!contains(entity)) return;
+    uint32_t slot = _slots[entity];
+    Entity last = _entities.back();
+    _entities[slot] = last;
+    _slots[last] = slot;
+    _entities.pop_back();
+    _generation++;
+    if (_primary == entity) _primary = _entities.empty() ? NULL_ENTITY : _entities.back();
+}
+
+void Selection::toggle(Entity entity) {
+    if (contains(entity)) remove(entity);
+    else add(entity);
+}
+
+void Selection::select(Entity entity) {
+    clear();
+    if (entity != NULL_ENTITY) add(entity);
+}
+
+void Selection::clear() {
+    if (_entities.empty()) return;
+    _entities.clear();
+    _primary = NULL_ENTITY;
+    _generation++;
+}
@@ -0,0 +1,94 @@
+#include "ShadowCascades.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void ShadowCascades::setResolution(uint32_t resolution) {
+    if (resolution == _resolution) return;
+    _resolution = resolution;
+    invalidateAll();
+}
+
+void ShadowCascades::setLightDirection(const glm::vec3& direction) {
+    glm::vec3 normalized = glm::normalize(direction);
+    if (normalized == _lightDirection) return;
+    _lightDirection = normalized;
+    invalidateAll();
+}
+
+void ShadowCascades::invalidateAll() {
+    for (auto& cascade : _cascades) cascade.staticDirty = true;
+}
+
+void ShadowCascades::update(const Camera& camera) {
+    glm::vec3 up = std::abs(_lightDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    _lightView = glm::lookAt(glm::vec3(0.0f), _lightDirection, up);
+
+    glm::mat4 inverseView = glm::inverse(camera.view());
+    float nearPlane = camera.nearPlane();
+    float farPlane = std::min(camera.farPlane(), _maxDistance);
+    float tanHalfFov = std::tan(camera.fov() * 0.5f);
+
+    float sliceStart = nearPlane;
+    for (uint32_t i = 0; i < CASCADE_COUNT; i++) {
+        // Blend of logarithmic and uniform splits (practical split scheme).
+        float p = static_cast<float>(i + 1) / CASCADE_COUNT;
+        float logSplit = nearPlane * std::pow(farPlane / nearPlane, p);
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * p;
+        float sliceEnd = uniformSplit + (logSplit - uniformSplit) * _splitLambda;
+
+        // Bounding sphere of the slice. Its view-space centre and radius depend only on
+        // the split distances, so camera rotation never changes the cascade size.
+        float centerDepth = (sliceStart + sliceEnd) * 0.5f;
+        float radius = 0.0f;
+        for (float depth : { sliceStart, sliceEnd }) {
+            float halfHeight = depth * tanHalfFov;
+            glm::vec3 corner(halfHeight * camera.aspect(), halfHeight, depth - centerDepth);
+            radius = std::max(radius, glm::length(corner));
+        }
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        glm::vec3 centerWorld = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, -centerDepth, 1.0f));
+        glm::vec3 centerLight = glm::vec3(_lightView * glm::vec4(centerWorld, 1.0f));
+
+        Cascade& cascade = _cascades[i];
+        float halfExtent = radius * (1.0f + CACHE_MARGIN);
+        float texelSize = 2.0f * halfExtent / _resolution;
+        float slack = radius * CACHE_MARGIN - texelSize;
+        glm::vec3 drift = glm::abs(centerLight - cascade.anchor);
+        if (halfExtent != cascade.halfExtent || drift.x > slack || drift.y > slack || drift.z > slack) {
+            // Snap to whole texels so re-anchoring never shifts rasterization by a sub-texel amount.
+            cascade.anchor = glm::floor(centerLight / texelSize) * texelSize;
+            cascade.halfExtent = halfExtent;
+            cascade.staticDirty = true;
+        }
+
+        // Light space looks down -z; the depth range is extended towards the light for off-screen casters.
+        const glm::vec3& a = cascade.anchor;
+        glm::mat4 projection = glm::ortho(a.x - halfExtent, a.x + halfExtent, a.y - halfExtent, a.y + halfExtent,
+                                          -(a.z + halfExtent + CASTER_DISTANCE), -(a.z - halfExtent));
+        cascade.viewProjection = projection * _lightView;
+        cascade.splitDepth = sliceEnd;
+        sliceStart = sliceEnd;
+    }
+}
+
+void ShadowCascades::invalidateStatic(const glm::vec3& min, const glm::vec3& max) {
+    for (auto& cascade : _cascades) {
+        if (cascade.staticDirty) continue;
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+        for (int i = 0; i < 8; i++) {
+            glm::vec3 corner((i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z);
+            glm::vec4 clip = cascade.viewProjection * glm::vec4(corner, 1.0f);
+            boundsMin = glm::min(boundsMin, glm::vec3(clip));
+            boundsMax = glm::max(boundsMax, glm::vec3(clip));
+        }
+        // Orthographic, so clip space is NDC: x/y in [-1, 1], depth in [0, 1].
+        bool overlaps = boundsMax.x >= -1.0f && boundsMin.x <= 1.0f &&
+                        boundsMax.y >= -1.0f && boundsMin.y <= 1.0f &&
+                        boundsMax.z >= 0.0f && boundsMin.z <= 1.0f;
+        if (overlaps) cascade.staticDirty = true;
+    }
+}
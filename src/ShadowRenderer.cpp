@@ -0,0 +1,453 @@
+#include "ShadowRenderer.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <stdexcept>
+#include <array>
+#include <utility>
+
+void ShadowRenderer::init(VulkanContext* context) {
+    _vkContext = context;
+    _cascades.setResolution(CASCADE_RESOLUTION);
+    createRenderPasses();
+    createAtlas(_staticAtlas);
+    createAtlas(_dynamicAtlas);
+    createPipeline();
+    createSampler();
+    createDescriptors();
+}
+
+void ShadowRenderer::cleanup() {
+    VkDevice device = _vkContext->device();
+    for (auto& frame : _frames) {
+        vkUnmapMemory(device, frame.uniformMemory);
+        vkDestroyBuffer(device, frame.uniformBuffer, nullptr);
+        vkFreeMemory(device, frame.uniformMemory, nullptr);
+    }
+    vkDestroyDescriptorPool(device, _descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(device, _setLayout, nullptr);
+    vkDestroySampler(device, _sampler, nullptr);
+    vkDestroyPipeline(device, _pipeline, nullptr);
+    vkDestroyPipelineLayout(device, _pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, _casterSetLayout, nullptr);
+    destroyAtlas(_dynamicAtlas);
+    destroyAtlas(_staticAtlas);
+    vkDestroyRenderPass(device, _loadPass, nullptr);
+    vkDestroyRenderPass(device, _clearPass, nullptr);
+}
+
+void ShadowRenderer::createRenderPasses() {
+    // Two compatible passes over the same framebuffer: CLEAR for the first use of an
+    // atlas (or when every tile is redrawn), LOAD so untouched tiles keep their cached
+    // depth. The render graph moves the atlas in and out of the attachment layout.
+    VkAttachmentDescription depthAttachment{};
+    depthAttachment.format = DEPTH_FORMAT;
+    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depthRef{ 0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.pDepthStencilAttachment = &depthRef;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &depthAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    if (vkCreateRenderPass(_vkContext->device(), &renderPassInfo, nullptr, &_clearPass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow clear render pass!");
+    }
+
+    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    if (vkCreateRenderPass(_vkContext->device(), &renderPassInfo, nullptr, &_loadPass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow load render pass!");
+    }
+}
+
+void ShadowRenderer::createAtlas(Atlas& atlas) {
+    _vkContext->createImage(ATLAS_SIZE, ATLAS_SIZE, DEPTH_FORMAT,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, atlas.image, atlas.memory);
+    atlas.view = _vkContext->createImageView(atlas.image, DEPTH_FORMAT, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = _loadPass;
+    framebufferInfo.attachmentCount = 1;
+    framebufferInfo.pAttachments = &atlas.view;
+    framebufferInfo.width = ATLAS_SIZE;
+    framebufferInfo.height = ATLAS_SIZE;
+    framebufferInfo.layers = 1;
+    if (vkCreateFramebuffer(_vkContext->device(), &framebufferInfo, nullptr, &atlas.framebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow atlas framebuffer!");
+    }
+}
+
+void ShadowRenderer::destroyAtlas(Atlas& atlas) {
+    VkDevice device = _vkContext->device();
+    vkDestroyFramebuffer(device, atlas.framebuffer, nullptr);
+    vkDestroyImageView(device, atlas.view, nullptr);
+    vkDestroyImage(device, atlas.image, nullptr);
+    vkFreeMemory(device, atlas.memory, nullptr);
+    atlas = {};
+}
+
+void ShadowRenderer::createPipeline() {
+    VkDevice device = _vkContext->device();
+
+    // Set 0 is bound by the casters: instance transforms (binding 0) and their draw
+    // list (1). The bindings match mesh.vert's set 0, so MeshRenderer's sets are
+    // compatible with this layout.
+    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
+    for (uint32_t i = 0; i < 2; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &_casterSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow caster descriptor set layout!");
+    }
+
+    // Light matrix, pushed per tile.
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.size = sizeof(glm::mat4);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &_casterSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &_pipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow pipeline layout!");
+    }
+
+    VkShaderModule vertModule = _vkContext->createShaderModule("shaders/shadow.vert.spv");
+
+    // Depth only: no fragment shader.
+    VkPipelineShaderStageCreateInfo shaderStage{};
+    shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStage.module = vertModule;
+    shaderStage.pName = "main";
+
+    VkVertexInputBindingDescription binding{};
+    binding.binding = 0;
+    binding.stride = CASTER_VERTEX_STRIDE;
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    VkVertexInputAttributeDescription positionAttribute{ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 };
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &binding;
+    vertexInputInfo.vertexAttributeDescriptionCount = 1;
+    vertexInputInfo.pVertexAttributeDescriptions = &positionAttribute;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.depthBiasEnable = VK_TRUE;
+    rasterizer.depthBiasConstantFactor = 1.25f;
+    rasterizer.depthBiasSlopeFactor = 1.75f;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    depthStencil.depthTestEnable = VK_TRUE;
+    depthStencil.depthWriteEnable = VK_TRUE;
+    depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 1;
+    pipelineInfo.pStages = &shaderStage;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pDepthStencilState = &depthStencil;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = _pipelineLayout;
+    pipelineInfo.renderPass = _loadPass;
+    pipelineInfo.subpass = 0;
+
+    VkResult result = vkCreateGraphicsPipelines(device, _vkContext->pipelineCache(), 1, &pipelineInfo, nullptr, &_pipeline);
+    vkDestroyShaderModule(device, vertModule, nullptr);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow pipeline!");
+    }
+}
+
+void ShadowRenderer::createSampler() {
+    // Hardware 2x2 PCF; outside the atlas everything is lit.
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    samplerInfo.compareEnable = VK_TRUE;
+    samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    samplerInfo.maxLod = 0.0f;
+
+    if (vkCreateSampler(_vkContext->device(), &samplerInfo, nullptr, &_sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow sampler!");
+    }
+}
+
+void ShadowRenderer::createDescriptors() {
+    VkDevice device = _vkContext->device();
+
+    std::array<VkDescriptorSetLayoutBinding, 3> bindings{};
+    bindings[0].binding = 0;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[0].descriptorCount = 1;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    for (uint32_t i = 1; i < 3; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+    layoutInfo.pBindings = bindings.data();
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &_setLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSizes[2] = {
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, Renderer::MAX_FRAMES_IN_FLIGHT },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Renderer::MAX_FRAMES_IN_FLIGHT * 2 }
+    };
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = Renderer::MAX_FRAMES_IN_FLIGHT;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = poolSizes;
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shadow descriptor pool!");
+    }
+
+    for (auto& frame : _frames) {
+        _vkContext->createBuffer(sizeof(ShadowUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            frame.uniformBuffer, frame.uniformMemory);
+        vkMapMemory(device, frame.uniformMemory, 0, sizeof(ShadowUniforms), 0, reinterpret_cast<void**>(&frame.mapped));
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = _descriptorPool;
+        allocInfo.descriptorSetCount = 1;
+        allocInfo.pSetLayouts = &_setLayout;
+        if (vkAllocateDescriptorSets(device, &allocInfo, &frame.descriptorSet) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate shadow descriptor set!");
+        }
+
+        VkDescriptorBufferInfo bufferInfo{ frame.uniformBuffer, 0, sizeof(ShadowUniforms) };
+        VkDescriptorImageInfo imageInfos[2] = {
+            { _sampler, _staticAtlas.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL },
+            { _sampler, _dynamicAtlas.view, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL }
+        };
+
+        std::array<VkWriteDescriptorSet, 2> writes{};
+        writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[0].dstSet = frame.descriptorSet;
+        writes[0].dstBinding = 0;
+        writes[0].descriptorCount = 1;
+        writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[0].pBufferInfo = &bufferInfo;
+        writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[1].dstSet = frame.descriptorSet;
+        writes[1].dstBinding = 1;
+        writes[1].descriptorCount = 2;
+        writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        writes[1].pImageInfo = imageInfos;
+        vkUpdateDescriptorSets(device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    }
+}
+
+glm::mat4 ShadowRenderer::tileMatrix(uint32_t cascade) {
+    // NDC xy of a cascade -> its quarter of the atlas in UV space; depth passes through.
+    glm::vec3 offset(0.25f + 0.5f * (cascade % 2), 0.25f + 0.5f * (cascade / 2), 0.0f);
+    return glm::scale(glm::translate(glm::mat4(1.0f), offset), glm::vec3(0.25f, 0.25f, 1.0f));
+}
+
+void ShadowRenderer::beginTile(VkCommandBuffer commandBuffer, uint32_t cascade, bool clear) {
+    VkRect2D tile{};
+    tile.offset = { static_cast<int32_t>((cascade % 2) * CASCADE_RESOLUTION), static_cast<int32_t>((cascade / 2) * CASCADE_RESOLUTION) };
+    tile.extent = { CASCADE_RESOLUTION, CASCADE_RESOLUTION };
+
+    VkViewport viewport{};
+    viewport.x = static_cast<float>(tile.offset.x);
+    viewport.y = static_cast<float>(tile.offset.y);
+    viewport.width = static_cast<float>(CASCADE_RESOLUTION);
+    viewport.height = static_cast<float>(CASCADE_RESOLUTION);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &tile);
+
+    if (clear) {
+        VkClearAttachment clearAttachment{};
+        clearAttachment.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        clearAttachment.clearValue.depthStencil = { 1.0f, 0 };
+        VkClearRect clearRect{ tile, 0, 1 };
+        vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect);
+    }
+
+    const glm::mat4& lightViewProjection = _cascades.cascade(cascade).viewProjection;
+    vkCmdPushConstants(commandBuffer, _pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &lightViewProjection);
+}
+
+ShadowRenderer::Atlases ShadowRenderer::addPasses(RenderGraph& graph, uint32_t frameIndex, const Camera& camera, const Casters& casters) {
+    _cascades.update(camera);
+    Atlases atlases{ importAtlas(graph, "shadow atlas static", _staticAtlas), importAtlas(graph, "shadow atlas dynamic", _dynamicAtlas) };
+    addStaticPass(graph, atlases.staticAtlas, casters);
+    addDynamicPass(graph, atlases.dynamicAtlas, casters);
+    writeUniforms(frameIndex);
+    return atlases;
+}
+
+RenderGraph::ResourceId ShadowRenderer::importAtlas(RenderGraph& graph, const char* name, const Atlas& atlas) {
+    // Between frames an atlas waits in the layout the mesh shader samples it in; the
+    // previous frame's scene pass may still be reading it.
+    RenderGraph::ImageDesc desc{ DEPTH_FORMAT, { ATLAS_SIZE, ATLAS_SIZE },
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT };
+    return graph.importImage(name, desc, atlas.image, atlas.view,
+        atlas.initialized ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
+}
+
+void ShadowRenderer::beginAtlas(VkCommandBuffer commandBuffer, const Atlas& atlas, bool clear) {
+    VkClearValue clearValue{};
+    clearValue.depthStencil = { 1.0f, 0 };
+
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = clear ? _clearPass : _loadPass;
+    renderPassInfo.framebuffer = atlas.framebuffer;
+    renderPassInfo.renderArea.extent = { ATLAS_SIZE, ATLAS_SIZE };
+    renderPassInfo.clearValueCount = 1;
+    renderPassInfo.pClearValues = &clearValue;
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _pipeline);
+}
+
+void ShadowRenderer::addStaticPass(RenderGraph& graph, RenderGraph::ResourceId atlas, const Casters& casters) {
+    _staticCascadesUpdated = 0;
+    if (!_staticAtlas.initialized) _cascades.invalidateAll();
+
+    uint32_t dirtyMask = 0;
+    uint32_t dirtyCount = 0;
+    for (uint32_t i = 0; i < ShadowCascades::CASCADE_COUNT; i++) {
+        if (!_cascades.cascade(i).staticDirty) continue;
+        dirtyMask |= 1u << i;
+        dirtyCount++;
+    }
+    // The common case while editing: nothing static moved, the cache is reused as is.
+    if (dirtyMask == 0) return;
+
+    bool clearAll = dirtyCount == ShadowCascades::CASCADE_COUNT;
+    std::vector<RenderGraph::Use> uses = casters.uses;
+    uses.push_back(clearAll ? RenderGraph::write(atlas, RenderGraph::Access::DepthAttachment)
+                            : RenderGraph::readWrite(atlas, RenderGraph::Access::DepthAttachment));
+    // Tiles count as rendered once they are recorded, not when the pass is added: a
+    // graph that never runs it leaves them dirty for the next frame.
+    graph.addPass("shadows static", std::move(uses), [this, casters, dirtyMask, dirtyCount, clearAll](VkCommandBuffer commandBuffer, RenderGraphExecutor&) {
+        beginAtlas(commandBuffer, _staticAtlas, clearAll);
+        for (uint32_t i = 0; i < ShadowCascades::CASCADE_COUNT; i++) {
+            if (!(dirtyMask & (1u << i))) continue;
+            beginTile(commandBuffer, i, !clearAll);
+            if (casters.drawStatic) casters.drawStatic(commandBuffer, _pipelineLayout, _cascades.cascade(i).viewProjection);
+            _cascades.markStaticRendered(i);
+        }
+        vkCmdEndRenderPass(commandBuffer);
+
+        _staticAtlas.initialized = true;
+        _staticCascadesUpdated = dirtyCount;
+        _totalStaticUpdates += dirtyCount;
+    });
+}
+
+void ShadowRenderer::addDynamicPass(RenderGraph& graph, RenderGraph::ResourceId atlas, const Casters& casters) {
+    _dynamicCascadesUpdated = 0;
+    bool anyTileUsed = false;
+    for (bool used : _dynamicTileUsed) anyTileUsed |= used;
+    // An unused tile is already cleared to 1.0, so with nothing dynamic there is nothing to record.
+    if (!casters.drawDynamic && !anyTileUsed && _dynamicAtlas.initialized) return;
+
+    bool clearAll = !_dynamicAtlas.initialized;
+    std::vector<RenderGraph::Use> uses = casters.uses;
+    uses.push_back(clearAll ? RenderGraph::write(atlas, RenderGraph::Access::DepthAttachment)
+                            : RenderGraph::readWrite(atlas, RenderGraph::Access::DepthAttachment));
+    // Which tiles end up with casters is only known once they are drawn.
+    graph.addPass("shadows dynamic", std::move(uses), [this, casters, clearAll](VkCommandBuffer commandBuffer, RenderGraphExecutor&) {
+        beginAtlas(commandBuffer, _dynamicAtlas, clearAll);
+        for (uint32_t i = 0; i < ShadowCascades::CASCADE_COUNT; i++) {
+            if (!casters.drawDynamic && !_dynamicTileUsed[i]) continue;
+            beginTile(commandBuffer, i, !clearAll && _dynamicTileUsed[i]);
+            bool drew = casters.drawDynamic && casters.drawDynamic(commandBuffer, _pipelineLayout, _cascades.cascade(i).viewProjection);
+            _dynamicTileUsed[i] = drew;
+            if (drew) _dynamicCascadesUpdated++;
+        }
+        vkCmdEndRenderPass(commandBuffer);
+        _dynamicAtlas.initialized = true;
+    });
+}
+
+void ShadowRenderer::writeUniforms(uint32_t frameIndex) {
+    ShadowUniforms& uniforms = *_frames[frameIndex].mapped;
+    for (uint32_t i = 0; i < ShadowCascades::CASCADE_COUNT; i++) {
+        const ShadowCascades::Cascade& cascade = _cascades.cascade(i);
+        uniforms.cascadeMatrices[i] = tileMatrix(i) * cascade.viewProjection;
+        uniforms.splitDepths[i] = cascade.splitDepth;
+    }
+    // Shaders want the direction towards the light.
+    uniforms.lightDirection = glm::vec4(-_cascades.lightDirection(), 0.0f);
+    uniforms.atlasTexelSize = glm::vec4(1.0f / ATLAS_SIZE);
+}
@@ -0,0 +1,44 @@
+#include "StartupTrace.h"
+#include <algorithm>
+#include <cstdio>
+
+StartupTrace::StartupTrace() : _origin(Clock::now()), _mainThread(std::this_thread::get_id()) {}
+
+void StartupTrace::record(const char* name, Clock::time_point start, Clock::time_point end) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.push_back({ name, std::this_thread::get_id(), start, end });
+}
+
+void StartupTrace::print(std::ostream& out) const {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        entries = _entries;
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.start < b.start; });
+
+    // Workers are numbered in order of their first stage.
+    std::vector<std::thread::id> workers;
+    auto milliseconds = [this](Clock::time_point time) {
+        return std::chrono::duration<double, std::milli>(time - _origin).count();
+    };
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-28s %10s %10s  %s\n", "Startup stage", "start ms", "took ms", "thread");
+    out << line;
+    Clock::time_point finish = _origin;
+    for (const auto& entry : entries) {
+        std::string thread = "main";
+        if (entry.thread != _mainThread) {
+            auto it = std::find(workers.begin(), workers.end(), entry.thread);
+            if (it == workers.end()) it = workers.insert(workers.end(), entry.thread);
+            thread = "worker " + std::to_string(it - workers.begin() + 1);
+        }
+        std::snprintf(line, sizeof(line), "%-28s %10.2f %10.2f  %s\n", entry.name.c_str(),
+                      milliseconds(entry.start), milliseconds(entry.end) - milliseconds(entry.start), thread.c_str());
+        out << line;
+        finish = std::max(finish, entry.end);
+    }
+    std::snprintf(line, sizeof(line), "%-28s %10s %10.2f\n", "Total", "", milliseconds(finish));
+    out << line;
+}
@@ -0,0 +1,473 @@
+#include "ThumbnailCache.h"
+#include <imgui_impl_vulkan.h>
+#include <stb_image.h>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+
+namespace {
+
+constexpr uint32_t S = ThumbnailCache::THUMBNAIL_SIZE;
+
+// Fits the image into the tile, keeping its aspect ratio; each output pixel
+// averages the source pixels under it.
+bool renderImage(const std::string& path, std::vector<uint8_t>& pixels) {
+    int width, height, channels;
+    stbi_uc* source = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (source == nullptr) return false;
+
+    float scale = std::min(static_cast<float>(S) / width, static_cast<float>(S) / height);
+    uint32_t outWidth = std::max(1u, static_cast<uint32_t>(width * scale));
+    uint32_t outHeight = std::max(1u, static_cast<uint32_t>(height * scale));
+    uint32_t offsetX = (S - outWidth) / 2, offsetY = (S - outHeight) / 2;
+
+    pixels.assign(ThumbnailCache::SLOT_BYTES, 0);
+    for (uint32_t y = 0; y < outHeight; y++) {
+        int y0 = static_cast<int>(y / scale), y1 = std::max(y0 + 1, std::min(height, static_cast<int>((y + 1) / scale)));
+        for (uint32_t x = 0; x < outWidth; x++) {
+            int x0 = static_cast<int>(x / scale), x1 = std::max(x0 + 1, std::min(width, static_cast<int>((x + 1) / scale)));
+            uint32_t sum[4] = {};
+            for (int sy = y0; sy < y1; sy++) {
+                const stbi_uc* row = source + (static_cast<size_t>(sy) * width + x0) * 4;
+                for (int sx = x0; sx < x1; sx++, row += 4) {
+                    for (int c = 0; c < 4; c++) sum[c] += row[c];
+                }
+            }
+            uint32_t count = static_cast<uint32_t>((y1 - y0) * (x1 - x0));
+            uint8_t* out = &pixels[((offsetY + y) * S + offsetX + x) * 4];
+            for (int c = 0; c < 4; c++) out[c] = static_cast<uint8_t>(sum[c] / count);
+        }
+    }
+    stbi_image_free(source);
+    return true;
+}
+
+// Flat-shaded three-quarter view of an OBJ file, rasterized with a depth buffer.
+bool renderObjMesh(const std::string& path, std::vector<uint8_t>& pixels) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream tokens(line);
+        std::string keyword;
+        tokens >> keyword;
+        if (keyword == "v") {
+            glm::vec3 position(0.0f);
+            tokens >> position.x >> position.y >> position.z;
+            positions.push_back(position);
+        } else if (keyword == "f") {
+            std::vector<uint32_t> face;
+            std::string corner;
+            while (tokens >> corner) {
+                long index = std::strtol(corner.c_str(), nullptr, 10);  // "v", "v/vt", "v//vn", ...
+                index = index < 0 ? static_cast<long>(positions.size()) + index : index - 1;
+                if (index < 0 || index >= static_cast<long>(positions.size())) break;
+                face.push_back(static_cast<uint32_t>(index));
+            }
+            for (size_t i = 2; i < face.size(); i++) indices.insert(indices.end(), { face[0], face[i - 1], face[i] });
+        }
+    }
+    if (indices.empty()) return false;
+
+    glm::vec3 min(std::numeric_limits<float>::max()), max(std::numeric_limits<float>::lowest());
+    for (const auto& position : positions) {
+        min = glm::min(min, position);
+        max = glm::max(max, position);
+    }
+    glm::vec3 center = (min + max) * 0.5f;
+    float radius = std::max(glm::length(max - min) * 0.5f, 1e-6f);
+
+    // Yaw then pitch, so the camera looks down at a front corner.
+    const float yaw = 0.6f, pitch = 0.45f;
+    glm::mat3 rotateY(std::cos(yaw), 0.0f, -std::sin(yaw), 0.0f, 1.0f, 0.0f, std::sin(yaw), 0.0f, std::cos(yaw));
+    glm::mat3 rotateX(1.0f, 0.0f, 0.0f, 0.0f, std::cos(pitch), std::sin(pitch), 0.0f, -std::sin(pitch), std::cos(pitch));
+    glm::mat3 rotation = rotateX * rotateY;
+
+    std::vector<glm::vec3> projected(positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        glm::vec3 p = rotation * ((positions[i] - center) / radius);  // unit sphere, +z towards the camera
+        projected[i] = glm::vec3((p.x * 0.45f + 0.5f) * S, (0.5f - p.y * 0.45f) * S, p.z);
+    }
+
+    pixels.assign(ThumbnailCache::SLOT_BYTES, 0);
+    std::vector<float> depth(S * S, std::numeric_limits<float>::lowest());
+    const glm::vec3 light = glm::normalize(glm::vec3(0.4f, 0.7f, 1.0f));
+    const glm::vec3 albedo(0.72f, 0.76f, 0.84f);
+
+    for (size_t t = 0; t < indices.size(); t += 3) {
+        const glm::vec3& a = projected[indices[t]];
+        const glm::vec3& b = projected[indices[t + 1]];
+        const glm::vec3& c = projected[indices[t + 2]];
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (std::abs(area) < 1e-8f) continue;
+
+        // Winding is not reliable in the wild, so faces are lit from both sides.
+        glm::vec3 normal = rotation * glm::cross(positions[indices[t + 1]] - positions[indices[t]], positions[indices[t + 2]] - positions[indices[t]]);
+        float shade = 0.25f + 0.75f * std::abs(glm::dot(glm::normalize(normal), light));
+        uint8_t color[4] = { static_cast<uint8_t>(albedo.r * shade * 255.0f), static_cast<uint8_t>(albedo.g * shade * 255.0f),
+                             static_cast<uint8_t>(albedo.b * shade * 255.0f), 255 };
+
+        int x0 = std::max(0, static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))));
+        int x1 = std::min(static_cast<int>(S) - 1, static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))));
+        int y0 = std::max(0, static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))));
+        int y1 = std::min(static_cast<int>(S) - 1, static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))));
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                float px = x + 0.5f, py = y + 0.5f;
+                float w0 = ((c.x - b.x) * (py - b.y) - (c.y - b.y) * (px - b.x)) / area;
+                float w1 = ((a.x - c.x) * (py - c.y) - (a.y - c.y) * (px - c.x)) / area;
+                float w2 = 1.0f - w0 - w1;
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) continue;
+                float z = w0 * a.z + w1 * b.z + w2 * c.z;
+                float& nearest = depth[y * S + x];
+                if (z <= nearest) continue;
+                nearest = z;
+                std::memcpy(&pixels[(y * S + x) * 4], color, 4);
+            }
+        }
+    }
+    return true;
+}
+
+bool renderThumbnail(AssetType type, const std::string& path, std::vector<uint8_t>& pixels) {
+    if (type == AssetType::Texture) return renderImage(path, pixels);
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (type == AssetType::Mesh && extension == ".obj") return renderObjMesh(path, pixels);
+    return false;
+}
+
+} // namespace
+
+void ThumbnailCache::init(VulkanContext* context, Renderer* renderer, JobSystem* jobs, VkDescriptorPool imguiPool, const std::string& directory) {
+    _vkContext = context;
+    _renderer = renderer;
+    _jobs = jobs;
+    _imguiPool = imguiPool;
+    _directory = directory;
+
+    loadIndex();
+
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+    if (vkCreateSampler(_vkContext->device(), &samplerInfo, nullptr, &_sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create thumbnail sampler!");
+    }
+
+    for (auto& upload : _uploadBuffers) {
+        _vkContext->createBuffer(UPLOADS_PER_FRAME * SLOT_BYTES, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, upload.buffer, upload.memory);
+        vkMapMemory(_vkContext->device(), upload.memory, 0, VK_WHOLE_SIZE, 0, &upload.mapped);
+    }
+}
+
+void ThumbnailCache::cleanup() {
+    // Thumbnails still being written are simply regenerated next time.
+    saveIndex();
+
+    VkDevice device = _vkContext->device();
+    for (auto& [index, page] : _pages) destroyPage(page);
+    _pages.clear();
+    for (auto& upload : _uploadBuffers) {
+        vkDestroyBuffer(device, upload.buffer, nullptr);
+        vkFreeMemory(device, upload.memory, nullptr);
+    }
+    vkDestroySampler(device, _sampler, nullptr);
+}
+
+bool ThumbnailCache::request(const AssetRecord& asset, const std::string& absolutePath, Thumbnail& thumbnail) {
+    if (!canGenerate(asset.type)) return false;
+
+    auto [it, inserted] = _entries.try_emplace(asset.contentHash);
+    Entry& entry = it->second;
+    if (entry.failed || entry.pending) return false;
+
+    if (!entry.onDisk) {
+        if (_jobsInFlight >= MAX_JOBS_IN_FLIGHT) {
+            if (inserted) _entries.erase(it);
+            return false;  // asked again next frame while still visible
+        }
+        entry.location = allocateLocation();
+        entry.pending = true;
+        _jobsInFlight++;
+        _jobs->submit([this, hash = asset.contentHash, location = entry.location, type = asset.type, absolutePath] {
+            Completed completed{ hash, location, true, {} };
+            if (!renderThumbnail(type, absolutePath, completed.pixels) || !writeSlot(location, completed.pixels)) {
+                completed.pixels.clear();
+            }
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            _completed.push_back(std::move(completed));
+        });
+        return false;
+    }
+
+    uint32_t slot = entry.location % SLOTS_PER_PAGE;
+    GpuPage* page = residentPage(entry.location / SLOTS_PER_PAGE);
+    if (page == nullptr) return false;
+    page->lastUsedFrame = _frameNumber;
+
+    if (!page->loaded[slot]) {
+        if (_jobsInFlight >= MAX_JOBS_IN_FLIGHT) return false;
+        entry.pending = true;
+        _jobsInFlight++;
+        _jobs->submit([this, hash = asset.contentHash, location = entry.location] {
+            Completed completed{ hash, location, false, {} };
+            if (!readSlot(location, completed.pixels)) completed.pixels.clear();
+            std::lock_guard<std::mutex> lock(_completedMutex);
+            _completed.push_back(std::move(completed));
+        });
+        return false;
+    }
+
+    float tile = 1.0f / PAGE_TILES;
+    thumbnail.texture = page->descriptor;
+    thumbnail.u0 = (slot % PAGE_TILES) * tile;
+    thumbnail.v0 = (slot / PAGE_TILES) * tile;
+    thumbnail.u1 = thumbnail.u0 + tile;
+    thumbnail.v1 = thumbnail.v0 + tile;
+    return true;
+}
+
+void ThumbnailCache::update(uint32_t frameIndex, uint64_t frameNumber) {
+    _frameNumber = frameNumber;
+    _uploads.clear();
+
+    UploadBuffer& staging = _uploadBuffers[frameIndex];
+    std::lock_guard<std::mutex> lock(_completedMutex);
+    while (!_completed.empty() && _uploads.size() < UPLOADS_PER_FRAME) {
+        Completed completed = std::move(_completed.front());
+        _completed.pop_front();
+        _jobsInFlight--;
+
+        auto it = _entries.find(completed.hash);
+        if (it == _entries.end()) continue;
+        Entry& entry = it->second;
+        entry.pending = false;
+        if (completed.pixels.empty()) {
+            // Generation failures are remembered; a lost page file just means regenerating.
+            _freeLocations.push_back(entry.location);
+            if (completed.generated) {
+                entry.location = NO_THUMBNAIL;
+                entry.failed = true;
+            } else {
+                _entries.erase(it);
+            }
+            continue;
+        }
+        entry.onDisk = true;
+
+        uint32_t page = completed.location / SLOTS_PER_PAGE;
+        if (_pages.find(page) == _pages.end()) continue;  // evicted meanwhile; reloaded when next requested
+        VkDeviceSize offset = _uploads.size() * SLOT_BYTES;
+        std::memcpy(static_cast<uint8_t*>(staging.mapped) + offset, completed.pixels.data(), SLOT_BYTES);
+        _uploads.push_back({ page, completed.location % SLOTS_PER_PAGE, offset });
+    }
+}
+
+std::vector<RenderGraph::ResourceId> ThumbnailCache::addPass(RenderGraph& graph, uint32_t frameIndex) {
+    using Access = RenderGraph::Access;
+    std::vector<RenderGraph::ResourceId> written;
+    if (_uploads.empty()) return written;
+
+    struct PageCopy {
+        VkImage image;
+        std::vector<VkBufferImageCopy> regions;
+    };
+    std::vector<PageCopy> copies;
+    std::vector<RenderGraph::Use> uses;
+
+    // Pages evicted by this frame's requests since update() lose their uploads with them.
+    std::sort(_uploads.begin(), _uploads.end(), [](const Upload& a, const Upload& b) { return a.page < b.page; });
+    for (size_t first = 0; first < _uploads.size();) {
+        size_t last = first;
+        while (last < _uploads.size() && _uploads[last].page == _uploads[first].page) last++;
+        auto it = _pages.find(_uploads[first].page);
+        if (it == _pages.end()) {
+            first = last;
+            continue;
+        }
+        GpuPage& page = it->second;
+
+        PageCopy copy{ page.image, {} };
+        for (size_t i = first; i < last; i++) {
+            VkBufferImageCopy region{};
+            region.bufferOffset = _uploads[i].offset;
+            region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.imageOffset = { static_cast<int32_t>((_uploads[i].slot % PAGE_TILES) * THUMBNAIL_SIZE),
+                                   static_cast<int32_t>((_uploads[i].slot / PAGE_TILES) * THUMBNAIL_SIZE), 0 };
+            region.imageExtent = { THUMBNAIL_SIZE, THUMBNAIL_SIZE, 1 };
+            copy.regions.push_back(region);
+            page.loaded[_uploads[i].slot] = true;
+        }
+        copies.push_back(std::move(copy));
+
+        // A page's first upload discards its (undefined) contents; later ones keep the other tiles.
+        RenderGraph::ImageDesc desc{ VK_FORMAT_R8G8B8A8_UNORM, { PAGE_SIZE, PAGE_SIZE },
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+        RenderGraph::ResourceId resource = graph.importImage("thumbnail page", desc, page.image, page.view,
+            page.initialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        uses.push_back(page.initialized ? RenderGraph::readWrite(resource, Access::TransferDst) : RenderGraph::write(resource, Access::TransferDst));
+        written.push_back(resource);
+        page.initialized = true;
+        first = last;
+    }
+    _uploads.clear();
+    if (copies.empty()) return written;
+
+    VkBuffer source = _uploadBuffers[frameIndex].buffer;
+    graph.addPass("thumbnails", std::move(uses), [source, copies = std::move(copies)](VkCommandBuffer commandBuffer, RenderGraphExecutor&) {
+        for (const PageCopy& copy : copies) {
+            vkCmdCopyBufferToImage(commandBuffer, source, copy.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                static_cast<uint32_t>(copy.regions.size()), copy.regions.data());
+        }
+    });
+    return written;
+}
+
+ThumbnailCache::GpuPage* ThumbnailCache::residentPage(uint32_t index) {
+    auto it = _pages.find(index);
+    if (it != _pages.end()) return &it->second;
+
+    if (_pages.size() >= MAX_RESIDENT_PAGES) {
+        // Only pages not drawn this frame can go; if all of them are, the tile waits.
+        auto victim = _pages.end();
+        for (auto page = _pages.begin(); page != _pages.end(); ++page) {
+            if (page->second.lastUsedFrame < _frameNumber &&
+                (victim == _pages.end() || page->second.lastUsedFrame < victim->second.lastUsedFrame)) {
+                victim = page;
+            }
+        }
+        if (victim == _pages.end()) return nullptr;
+        // It may still be sampled by frames in flight.
+        _renderer->retire([this, page = victim->second]() mutable { destroyPage(page); });
+        _pages.erase(victim);
+    }
+
+    GpuPage& page = _pages[index];
+    createPage(page);
+    return &page;
+}
+
+void ThumbnailCache::createPage(GpuPage& page) {
+    _vkContext->createImage(PAGE_SIZE, PAGE_SIZE, VK_FORMAT_R8G8B8A8_UNORM,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, page.image, page.memory);
+    page.view = _vkContext->createImageView(page.image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+    page.descriptor = ImGui_ImplVulkan_AddTexture(_sampler, page.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+}
+
+void ThumbnailCache::destroyPage(GpuPage& page) {
+    VkDevice device = _vkContext->device();
+    vkFreeDescriptorSets(device, _imguiPool, 1, &page.descriptor);
+    vkDestroyImageView(device, page.view, nullptr);
+    vkDestroyImage(device, page.image, nullptr);
+    vkFreeMemory(device, page.memory, nullptr);
+}
+
+uint32_t ThumbnailCache::allocateLocation() {
+    if (!_freeLocations.empty()) {
+        uint32_t location = _freeLocations.back();
+        _freeLocations.pop_back();
+        return location;
+    }
+    return _nextLocation++;
+}
+
+std::string ThumbnailCache::pagePath(uint32_t page) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "/page_%04u.bin", page);
+    return _directory + name;
+}
+
+bool ThumbnailCache::writeSlot(uint32_t location, const std::vector<uint8_t>& pixels) {
+    std::lock_guard<std::mutex> lock(_diskMutex);
+    std::string path = pagePath(location / SLOTS_PER_PAGE);
+    std::error_code error;
+    std::filesystem::create_directories(_directory, error);
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+        file.open(path, std::ios::out | std::ios::binary);  // first tile of a new page
+        file.close();
+        file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    }
+    file.seekp(static_cast<std::streamoff>((location % SLOTS_PER_PAGE) * SLOT_BYTES));
+    file.write(reinterpret_cast<const char*>(pixels.data()), SLOT_BYTES);
+    return static_cast<bool>(file);
+}
+
+bool ThumbnailCache::readSlot(uint32_t location, std::vector<uint8_t>& pixels) {
+    std::lock_guard<std::mutex> lock(_diskMutex);
+    std::ifstream file(pagePath(location / SLOTS_PER_PAGE), std::ios::binary);
+    if (!file.is_open()) return false;
+    pixels.resize(SLOT_BYTES);
+    file.seekg(static_cast<std::streamoff>((location % SLOTS_PER_PAGE) * SLOT_BYTES));
+    file.read(reinterpret_cast<char*>(pixels.data()), SLOT_BYTES);
+    return file.gcount() == static_cast<std::streamsize>(SLOT_BYTES);
+}
+
+void ThumbnailCache::loadIndex() {
+    std::ifstream file(_directory + "/index.bin", std::ios::binary);
+    if (!file.is_open()) return;
+
+    uint32_t header[4];  // magic, version, thumbnail size, entry count
+    if (!file.read(reinterpret_cast<char*>(header), sizeof(header))) return;
+    if (header[0] != INDEX_MAGIC || header[1] != INDEX_VERSION || header[2] != THUMBNAIL_SIZE) return;
+
+    std::vector<bool> used;
+    for (uint32_t i = 0; i < header[3]; i++) {
+        uint64_t hash;
+        uint32_t location;
+        if (!file.read(reinterpret_cast<char*>(&hash), sizeof(hash)) ||
+            !file.read(reinterpret_cast<char*>(&location), sizeof(location))) {
+            break;
+        }
+        Entry& entry = _entries[hash];
+        entry.location = location;
+        entry.failed = location == NO_THUMBNAIL;
+        entry.onDisk = !entry.failed;
+        if (entry.onDisk) {
+            if (location >= used.size()) used.resize(location + 1, false);
+            used[location] = true;
+            _nextLocation = std::max(_nextLocation, location + 1);
+        }
+    }
+    for (uint32_t location = 0; location < _nextLocation; location++) {
+        if (!used[location]) _freeLocations.push_back(location);
+    }
+}
+
+void ThumbnailCache::saveIndex() const {
+    std::vector<std::pair<uint64_t, uint32_t>> entries;
+    entries.reserve(_entries.size());
+    for (const auto& [hash, entry] : _entries) {
+        if (entry.onDisk || entry.failed) entries.emplace_back(hash, entry.onDisk ? entry.location : NO_THUMBNAIL);
+    }
+
+    std::ofstream file(_directory + "/index.bin", std::ios::binary | std::ios::trunc);
+    uint32_t header[4] = { INDEX_MAGIC, INDEX_VERSION, THUMBNAIL_SIZE, static_cast<uint32_t>(entries.size()) };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    for (const auto& [hash, location] : entries) {
+        file.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        file.write(reinterpret_cast<const char*>(&location), sizeof(location));
+    }
+}
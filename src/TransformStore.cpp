@@ -0,0 +1,181 @@
+#include "TransformStore.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRANSFORM_STORE_SSE
+#endif
+
+// Entities per chunk of a parallel pass: 256 KB of matrices, big enough that
+// handing out chunks costs nothing next to the work in them.
+static constexpr size_t BATCH_GRAIN = 4096;
+
+// matrix = delta * matrix for `count` entities. Each result column is the delta's
+// columns weighted by the four components of the same input column.
+static void multiplyBatch(const glm::mat4& delta, const Entity* entities, size_t count,
+                          const std::shared_ptr<TransformStore::Page>* pages, uint32_t limit) {
+#ifdef TRANSFORM_STORE_SSE
+    const __m128 d0 = _mm_loadu_ps(&delta[0][0]);
+    const __m128 d1 = _mm_loadu_ps(&delta[1][0]);
+    const __m128 d2 = _mm_loadu_ps(&delta[2][0]);
+    const __m128 d3 = _mm_loadu_ps(&delta[3][0]);
+    for (size_t i = 0; i < count; i++) {
+        Entity entity = entities[i];
+        if (entity >= limit) continue;
+        float* matrix = &pages[entity / TransformStore::PAGE_SIZE]->matrices[entity % TransformStore::PAGE_SIZE][0][0];
+        for (int column = 0; column < 4; column++) {
+            __m128 c = _mm_loadu_ps(matrix + column * 4);
+            __m128 r = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(d0, _mm_shuffle_ps(c, c, 0x00)), _mm_mul_ps(d1, _mm_shuffle_ps(c, c, 0x55))),
+                _mm_add_ps(_mm_mul_ps(d2, _mm_shuffle_ps(c, c, 0xAA)), _mm_mul_ps(d3, _mm_shuffle_ps(c, c, 0xFF))));
+            _mm_storeu_ps(matrix + column * 4, r);
+        }
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+        Entity entity = entities[i];
+        if (entity >= limit) continue;
+        glm::mat4& matrix = pages[entity / TransformStore::PAGE_SIZE]->matrices[entity % TransformStore::PAGE_SIZE];
+        matrix = delta * matrix;
+    }
+#endif
+}
+
+void TransformStore::init(Scene* scene) {
+    scene->addListener(this);
+    for (Entity entity = 0; entity < scene->entityCount(); entity++) {
+        onEntityCreated(*scene, entity);
+    }
+}
+
+void TransformStore::onEntityCreated(const Scene&, Entity entity) {
+    uint32_t page = entity / PAGE_SIZE;
+    if (page == _pages.size()) _pages.push_back(std::make_shared<Page>());
+    _count = entity + 1;
+    size_t words = (_count + BLOCK_SIZE * 64 - 1) / (BLOCK_SIZE * 64);
+    if (_dirty.size() < words) _dirty.resize(words, 0);
+    set(entity, glm::mat4(1.0f));
+}
+
+TransformStore::Page& TransformStore::writablePage(uint32_t page) {
+    // Only snapshot() adds references, on this thread, so a page held by nothing
+    // else cannot gain a reader while it is being written.
+    if (_pages[page].use_count() > 1) _pages[page] = std::make_shared<Page>(*_pages[page]);
+    return *_pages[page];
+}
+
+void TransformStore::set(Entity entity, const glm::mat4& matrix) {
+    writablePage(entity / PAGE_SIZE).matrices[entity % PAGE_SIZE] = matrix;
+    markDirty(entity);
+    _generation++;
+}
+
+void TransformStore::updateFootprint(const Selection& selection) {
+    if (_footprintSelection == &selection && _footprintGeneration == selection.generation()) return;
+    _footprintSelection = &selection;
+    _footprintGeneration = selection.generation();
+
+    std::vector<uint8_t> touched(_pages.size(), 0);
+    _footprintBlocks.assign(_dirty.size(), 0);
+    for (Entity entity : selection.entities()) {
+        if (entity >= _count) continue;
+        touched[entity / PAGE_SIZE] = 1;
+        _footprintBlocks[entity / BLOCK_SIZE / 64] |= 1ull << (entity / BLOCK_SIZE % 64);
+    }
+    _footprintPages.clear();
+    for (uint32_t page = 0; page < touched.size(); page++) {
+        if (touched[page]) _footprintPages.push_back(page);
+    }
+}
+
+void TransformStore::applyDelta(const Selection& selection, const glm::mat4& delta, JobSystem& jobs) {
+    if (selection.empty()) return;
+
+    // Copy-on-write and dirty marking happen here, per page and per 64 blocks, so the
+    // parallel pass only multiplies.
+    updateFootprint(selection);
+    for (uint32_t page : _footprintPages) writablePage(page);
+    for (size_t i = 0; i < std::min(_dirty.size(), _footprintBlocks.size()); i++) _dirty[i] |= _footprintBlocks[i];
+    _generation++;
+
+    const std::vector<Entity>& entities = selection.entities();
+    jobs.parallelFor(entities.size(), BATCH_GRAIN, [&](size_t begin, size_t end) {
+        multiplyBatch(delta, entities.data() + begin, end - begin, _pages.data(), _count);
+    });
+}
+
+bool TransformStore::bounds(const Selection& selection, JobSystem& jobs, glm::vec3& min, glm::vec3& max) const {
+    const std::vector<Entity>& entities = selection.entities();
+    size_t chunks = (entities.size() + BATCH_GRAIN - 1) / BATCH_GRAIN;
+    std::vector<glm::vec3> mins(chunks, glm::vec3(std::numeric_limits<float>::max()));
+    std::vector<glm::vec3> maxs(chunks, glm::vec3(std::numeric_limits<float>::lowest()));
+
+    jobs.parallelFor(entities.size(), BATCH_GRAIN, [&](size_t begin, size_t end) {
+        glm::vec3 chunkMin = mins[begin / BATCH_GRAIN], chunkMax = maxs[begin / BATCH_GRAIN];
+        for (size_t i = begin; i < end; i++) {
+            if (entities[i] >= _count) continue;
+            glm::vec3 entityMin, entityMax;
+            cubeBounds(get(entities[i]), entityMin, entityMax);
+            chunkMin = glm::min(chunkMin, entityMin);
+            chunkMax = glm::max(chunkMax, entityMax);
+        }
+        mins[begin / BATCH_GRAIN] = chunkMin;
+        maxs[begin / BATCH_GRAIN] = chunkMax;
+    });
+
+    min = glm::vec3(std::numeric_limits<float>::max());
+    max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (size_t i = 0; i < chunks; i++) {
+        min = glm::min(min, mins[i]);
+        max = glm::max(max, maxs[i]);
+    }
+    return min.x <= max.x;
+}
+
+TransformStore::Snapshot TransformStore::snapshot() const {
+    Snapshot snapshot;
+    snapshot.count = _count;
+    snapshot.generation = _generation;
+    snapshot.pages.assign(_pages.begin(), _pages.end());
+    return snapshot;
+}
+
+void TransformStore::takeDirty(std::vector<Range>& ranges) {
+    ranges.clear();
+    uint32_t blockCount = (_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    for (uint32_t word = 0; word < _dirty.size(); word++) {
+        uint64_t bits = _dirty[word];
+        _dirty[word] = 0;
+        while (bits != 0) {
+            uint32_t bit = static_cast<uint32_t>(std::countr_zero(bits));
+            bits &= bits - 1;
+            uint32_t block = word * 64 + bit;
+            if (block >= blockCount) break;
+
+            Entity first = block * BLOCK_SIZE;
+            uint32_t count = std::min(BLOCK_SIZE, _count - first);
+            if (!ranges.empty() && ranges.back().first + ranges.back().count == first) {
+                ranges.back().count += count;
+            } else {
+                ranges.push_back({ first, count });
+            }
+        }
+    }
+}
+
+void TransformStore::markAllDirty() {
+    std::fill(_dirty.begin(), _dirty.end(), ~0ull);
+}
+
+void TransformStore::copy(Range range, glm::mat4* out) const {
+    for (Entity entity = range.first; entity < range.first + range.count;) {
+        uint32_t offset = entity % PAGE_SIZE;
+        uint32_t count = std::min(PAGE_SIZE - offset, range.first + range.count - entity);
+        std::memcpy(out, &_pages[entity / PAGE_SIZE]->matrices[offset], count * sizeof(glm::mat4));
+        out += count;
+        entity += count;
+    }
+}
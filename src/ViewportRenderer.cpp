@@ -0,0 +1,551 @@
+#include "ViewportRenderer.h"
+#include "RenderGraphExecutor.h"
+#include <imgui_impl_vulkan.h>
+#include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cmath>
+
+void ViewportRenderer::init(VulkanContext* context, VkDescriptorPool imguiPool, bool enableEntityIds) {
+    _vkContext = context;
+    _imguiPool = imguiPool;
+    _entityIdsEnabled = enableEntityIds;
+    createRenderPasses();
+    createSampler();
+    createDescriptorPool();
+    createUpscalePipeline();
+    createDescriptorSets();
+    createQueryPool();
+    createPickReadbacks();
+}
+
+void ViewportRenderer::cleanup() {
+    VkDevice device = _vkContext->device();
+    for (VkDescriptorSet set : _displaySets) {
+        if (set != VK_NULL_HANDLE) vkFreeDescriptorSets(device, _imguiPool, 1, &set);
+    }
+
+    for (auto& readback : _pickReadbacks) {
+        if (readback.buffer == VK_NULL_HANDLE) continue;
+        vkUnmapMemory(device, readback.memory);
+        vkDestroyBuffer(device, readback.buffer, nullptr);
+        vkFreeMemory(device, readback.memory, nullptr);
+    }
+    if (_queryPool != VK_NULL_HANDLE) vkDestroyQueryPool(device, _queryPool, nullptr);
+
+    vkDestroyPipeline(device, _upscalePipeline, nullptr);
+    vkDestroyPipelineLayout(device, _upscalePipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(device, _upscaleSetLayout, nullptr);
+    vkDestroyDescriptorPool(device, _descriptorPool, nullptr);
+    vkDestroySampler(device, _sampler, nullptr);
+    vkDestroyRenderPass(device, _upscalePass, nullptr);
+    vkDestroyRenderPass(device, _scenePassAfterPyramid, nullptr);
+    vkDestroyRenderPass(device, _scenePassBeforePyramid, nullptr);
+    vkDestroyRenderPass(device, _scenePass, nullptr);
+}
+
+void ViewportRenderer::createRenderPasses() {
+    _scenePass = createScenePass(ScenePart::Whole);
+    _scenePassBeforePyramid = createScenePass(ScenePart::BeforeDepthPyramid);
+    _scenePassAfterPyramid = createScenePass(ScenePart::AfterDepthPyramid);
+
+    // Upscale pass: writes every pixel of the panel-sized display image, which ImGui samples.
+    VkAttachmentDescription displayAttachment{};
+    displayAttachment.format = COLOR_FORMAT;
+    displayAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    displayAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    displayAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    displayAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    displayAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    displayAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    displayAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference displayRef{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription upscaleSubpass{};
+    upscaleSubpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    upscaleSubpass.colorAttachmentCount = 1;
+    upscaleSubpass.pColorAttachments = &displayRef;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = 1;
+    renderPassInfo.pAttachments = &displayAttachment;
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &upscaleSubpass;
+
+    if (vkCreateRenderPass(_vkContext->device(), &renderPassInfo, nullptr, &_upscalePass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create viewport upscale render pass!");
+    }
+}
+
+VkRenderPass ViewportRenderer::createScenePass(ScenePart part) {
+    // Whole scene pass: depth is never needed after the pass. With occlusion culling the
+    // pass is split in two around the depth pyramid build: the first half keeps depth for
+    // the compute reads, the second half loads everything back. Attachments start and end
+    // in their attachment layouts; the render graph does every transition and dependency.
+    // All three variants are compatible, so they share framebuffers and pipelines.
+    bool resumes = part == ScenePart::AfterDepthPyramid;
+    bool suspends = part == ScenePart::BeforeDepthPyramid;
+
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<VkAttachmentReference> colorRefs;
+
+    VkAttachmentDescription colorAttachment{};
+    colorAttachment.format = COLOR_FORMAT;
+    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttachment.loadOp = resumes ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    attachments.push_back(colorAttachment);
+    colorRefs.push_back({ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+
+    if (_entityIdsEnabled) {
+        VkAttachmentDescription entityIdAttachment = colorAttachment;
+        entityIdAttachment.format = ENTITY_ID_FORMAT;
+        attachments.push_back(entityIdAttachment);
+        colorRefs.push_back({ 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL });
+    }
+
+    VkAttachmentDescription depthAttachment = colorAttachment;
+    depthAttachment.format = DEPTH_FORMAT;
+    depthAttachment.storeOp = suspends ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    attachments.push_back(depthAttachment);
+
+    VkAttachmentReference depthRef{};
+    depthRef.attachment = static_cast<uint32_t>(attachments.size() - 1);
+    depthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+    subpass.pColorAttachments = colorRefs.data();
+    subpass.pDepthStencilAttachment = &depthRef;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    VkRenderPass renderPass;
+    if (vkCreateRenderPass(_vkContext->device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create viewport scene render pass!");
+    }
+    return renderPass;
+}
+
+void ViewportRenderer::createSampler() {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.maxLod = 0.0f;
+
+    if (vkCreateSampler(_vkContext->device(), &samplerInfo, nullptr, &_sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create viewport sampler!");
+    }
+}
+
+void ViewportRenderer::createDescriptorPool() {
+    // One upscale set per frame slot.
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Renderer::MAX_FRAMES_IN_FLIGHT };
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = Renderer::MAX_FRAMES_IN_FLIGHT;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    if (vkCreateDescriptorPool(_vkContext->device(), &poolInfo, nullptr, &_descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create viewport descriptor pool!");
+    }
+}
+
+void ViewportRenderer::createDescriptorSets() {
+    VkDescriptorSetLayout layouts[Renderer::MAX_FRAMES_IN_FLIGHT];
+    std::fill(std::begin(layouts), std::end(layouts), _upscaleSetLayout);
+
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = _descriptorPool;
+    allocInfo.descriptorSetCount = Renderer::MAX_FRAMES_IN_FLIGHT;
+    allocInfo.pSetLayouts = layouts;
+    if (vkAllocateDescriptorSets(_vkContext->device(), &allocInfo, _upscaleSets) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate upscale descriptor sets!");
+    }
+}
+
+void ViewportRenderer::createUpscalePipeline() {
+    VkDevice device = _vkContext->device();
+
+    VkDescriptorSetLayoutBinding samplerBinding{};
+    samplerBinding.binding = 0;
+    samplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    samplerBinding.descriptorCount = 1;
+    samplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &samplerBinding;
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &_upscaleSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upscale descriptor set layout!");
+    }
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pushConstantRange.size = sizeof(UpscalePushConstants);
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &_upscaleSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    if (vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &_upscalePipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upscale pipeline layout!");
+    }
+
+    VkShaderModule vertModule = _vkContext->createShaderModule("shaders/fullscreen.vert.spv");
+    VkShaderModule fragModule = _vkContext->createShaderModule("shaders/upscale.frag.spv");
+
+    VkPipelineShaderStageCreateInfo shaderStages[2]{};
+    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = vertModule;
+    shaderStages[0].pName = "main";
+    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = fragModule;
+    shaderStages[1].pName = "main";
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewportState{};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.cullMode = VK_CULL_MODE_NONE;
+    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment{};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = _upscalePipelineLayout;
+    pipelineInfo.renderPass = _upscalePass;
+    pipelineInfo.subpass = 0;
+
+    VkResult result = vkCreateGraphicsPipelines(device, _vkContext->pipelineCache(), 1, &pipelineInfo, nullptr, &_upscalePipeline);
+    vkDestroyShaderModule(device, fragModule, nullptr);
+    vkDestroyShaderModule(device, vertModule, nullptr);
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error("failed to create upscale pipeline!");
+    }
+}
+
+void ViewportRenderer::createQueryPool() {
+    // Timestamps drive dynamic resolution; without them the scale simply stays at max.
+    const DeviceCapabilities& capabilities = _vkContext->capabilities();
+    uint32_t validBits = capabilities.timestampValidBits();
+    if (validBits == 0) return;
+    _timestampMask = validBits >= 64 ? UINT64_MAX : ((uint64_t(1) << validBits) - 1);
+    _timestampPeriod = capabilities.properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = 2 * Renderer::MAX_FRAMES_IN_FLIGHT;
+
+    if (vkCreateQueryPool(_vkContext->device(), &queryPoolInfo, nullptr, &_queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+}
+
+void ViewportRenderer::createPickReadbacks() {
+    if (!_entityIdsEnabled) return;
+
+    for (auto& readback : _pickReadbacks) {
+        _vkContext->createBuffer(sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            readback.buffer, readback.memory);
+        vkMapMemory(_vkContext->device(), readback.memory, 0, sizeof(uint32_t), 0, reinterpret_cast<void**>(&readback.mapped));
+    }
+}
+
+void ViewportRenderer::setPanelSize(uint32_t width, uint32_t height) {
+    _requestedExtent = { width, height };
+}
+
+void ViewportRenderer::beginFrame(uint32_t frameIndex) {
+    _frameIndex = frameIndex;
+
+    collectTimings();
+    collectPickResult();
+
+    // The graph reallocates its images when the extent changes and retires the old ones.
+    _extent = _requestedExtent;
+    float scale = _queryPool != VK_NULL_HANDLE ? _resolution.scale() : 1.0f;
+    _renderExtent.width = std::max(1u, static_cast<uint32_t>(std::lround(_extent.width * scale)));
+    _renderExtent.height = std::max(1u, static_cast<uint32_t>(std::lround(_extent.height * scale)));
+}
+
+void ViewportRenderer::collectTimings() {
+    if (_queryPool == VK_NULL_HANDLE || !_timestampsWritten[_frameIndex]) return;
+
+    uint64_t timestamps[2];
+    VkResult result = vkGetQueryPoolResults(_vkContext->device(), _queryPool, _frameIndex * 2, 2,
+        sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    _timestampsWritten[_frameIndex] = false;
+    if (result != VK_SUCCESS) return;
+
+    uint64_t ticks = (timestamps[1] - timestamps[0]) & _timestampMask;
+    _gpuTimeMs = static_cast<float>(ticks * _timestampPeriod / 1.0e6);
+    _resolution.update(_gpuTimeMs);
+}
+
+void ViewportRenderer::collectPickResult() {
+    PickReadback& readback = _pickReadbacks[_frameIndex];
+    if (!readback.pending) return;
+    _pickResult = *readback.mapped;
+    readback.pending = false;
+}
+
+void ViewportRenderer::requestPick(float u, float v) {
+    if (!_entityIdsEnabled || u < 0.0f || v < 0.0f || u >= 1.0f || v >= 1.0f) return;
+    _pickRequest = std::make_pair(u, v);
+}
+
+std::optional<uint32_t> ViewportRenderer::takePickResult() {
+    std::optional<uint32_t> result = _pickResult;
+    _pickResult.reset();
+    return result;
+}
+
+RenderGraph::ResourceId ViewportRenderer::addPasses(RenderGraph& graph, const SceneCallbacks& callbacks) {
+    if (!hasTarget()) return RenderGraph::NO_RESOURCE;
+    using Access = RenderGraph::Access;
+
+    // Attachments are allocated at full panel size; lower render scales use a sub-rectangle.
+    RenderGraph::ResourceId color = graph.createImage("viewport color",
+        { COLOR_FORMAT, _extent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+    RenderGraph::ResourceId entityId = RenderGraph::NO_RESOURCE;
+    if (_entityIdsEnabled) {
+        entityId = graph.createImage("viewport entity id",
+            { ENTITY_ID_FORMAT, _extent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+    }
+    RenderGraph::ResourceId depth = graph.createImage("viewport depth",
+        { DEPTH_FORMAT, _extent, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT });
+    RenderGraph::ResourceId display = graph.createImage("viewport display",
+        { COLOR_FORMAT, _extent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+
+    bool split = static_cast<bool>(callbacks.depthPyramid);
+    VkRenderPass firstPass = split ? _scenePassBeforePyramid : _scenePass;
+
+    std::vector<RenderGraph::Use> sceneWrites = { RenderGraph::write(color, Access::ColorAttachment) };
+    if (_entityIdsEnabled) sceneWrites.push_back(RenderGraph::write(entityId, Access::ColorAttachment));
+    sceneWrites.push_back(RenderGraph::write(depth, Access::DepthAttachment));
+    sceneWrites.insert(sceneWrites.end(), callbacks.drawUses.begin(), callbacks.drawUses.end());
+
+    graph.addPass("viewport scene", sceneWrites, [=, this](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+        if (_queryPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(commandBuffer, _queryPool, _frameIndex * 2, 2);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _queryPool, _frameIndex * 2);
+        }
+        VkFramebuffer framebuffer = _entityIdsEnabled ? executor.framebuffer(_scenePass, { color, entityId, depth })
+                                                      : executor.framebuffer(_scenePass, { color, depth });
+        beginScenePass(commandBuffer, firstPass, framebuffer);
+        if (callbacks.drawEarly) callbacks.drawEarly(commandBuffer);
+        if (!split && callbacks.overlay) callbacks.overlay(commandBuffer);
+        vkCmdEndRenderPass(commandBuffer);
+    });
+
+    if (split) {
+        std::vector<RenderGraph::Use> pyramidUses = { RenderGraph::read(depth, Access::SampledCompute) };
+        pyramidUses.insert(pyramidUses.end(), callbacks.depthPyramidUses.begin(), callbacks.depthPyramidUses.end());
+        graph.addPass("depth pyramid", pyramidUses, [=, this](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+            callbacks.depthPyramid(commandBuffer, executor.view(depth));
+        });
+
+        std::vector<RenderGraph::Use> sceneLoads = { RenderGraph::readWrite(color, Access::ColorAttachment) };
+        if (_entityIdsEnabled) sceneLoads.push_back(RenderGraph::readWrite(entityId, Access::ColorAttachment));
+        sceneLoads.push_back(RenderGraph::readWrite(depth, Access::DepthAttachment));
+        sceneLoads.insert(sceneLoads.end(), callbacks.drawUses.begin(), callbacks.drawUses.end());
+
+        graph.addPass("viewport scene late", sceneLoads, [=, this](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+            VkFramebuffer framebuffer = _entityIdsEnabled ? executor.framebuffer(_scenePass, { color, entityId, depth })
+                                                          : executor.framebuffer(_scenePass, { color, depth });
+            beginScenePass(commandBuffer, _scenePassAfterPyramid, framebuffer);
+            if (callbacks.drawLate) callbacks.drawLate(commandBuffer);
+            if (callbacks.overlay) callbacks.overlay(commandBuffer);
+            vkCmdEndRenderPass(commandBuffer);
+        });
+    }
+
+    // Ahead of the upscale, so entity ids are dead by then and the display image can take their memory.
+    if (_pickRequest && _entityIdsEnabled) {
+        graph.addPass("viewport pick", { RenderGraph::read(entityId, Access::TransferSrc) },
+            [=, this](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+                recordPickCopy(commandBuffer, executor.image(entityId));
+            }, true);
+    }
+
+    graph.addPass("viewport upscale", { RenderGraph::read(color, Access::SampledFragment), RenderGraph::write(display, Access::ColorAttachment) },
+        [=, this](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+            recordUpscale(commandBuffer, executor.framebuffer(_upscalePass, { display }), executor.view(color), executor.view(display));
+        });
+    return display;
+}
+
+void ViewportRenderer::beginScenePass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer) {
+    std::array<VkClearValue, 3> clearValues{};
+    clearValues[0].color = {{0.05f, 0.05f, 0.05f, 1.0f}};
+    uint32_t clearCount = 1;
+    if (_entityIdsEnabled) clearValues[clearCount++].color.uint32[0] = 0;
+    clearValues[clearCount++].depthStencil = { 1.0f, 0 };
+
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = framebuffer;
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = _renderExtent;
+    // Ignored by the resuming half, which loads every attachment.
+    renderPassInfo.clearValueCount = renderPass == _scenePassAfterPyramid ? 0 : clearCount;
+    renderPassInfo.pClearValues = clearValues.data();
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(_renderExtent.width), static_cast<float>(_renderExtent.height), 0.0f, 1.0f };
+    VkRect2D scissor{ { 0, 0 }, _renderExtent };
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+}
+
+void ViewportRenderer::recordPickCopy(VkCommandBuffer commandBuffer, VkImage entityId) {
+    // The request is in panel space; map it into the region rendered at the current scale.
+    uint32_t x = std::min(static_cast<uint32_t>(_pickRequest->first * _renderExtent.width), _renderExtent.width - 1);
+    uint32_t y = std::min(static_cast<uint32_t>(_pickRequest->second * _renderExtent.height), _renderExtent.height - 1);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = { static_cast<int32_t>(x), static_cast<int32_t>(y), 0 };
+    region.imageExtent = { 1, 1, 1 };
+
+    PickReadback& readback = _pickReadbacks[_frameIndex];
+    vkCmdCopyImageToBuffer(commandBuffer, entityId, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback.buffer, 1, &region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = readback.buffer;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+        0, nullptr, 1, &barrier, 0, nullptr);
+
+    readback.pending = true;
+    _pickRequest.reset();
+}
+
+void ViewportRenderer::recordUpscale(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, VkImageView color, VkImageView display) {
+    // This slot's previous command buffer has completed, so both of its sets can be rewritten
+    // with whatever views the graph has now; ImGui binds the display set later in this frame.
+    VkDevice device = _vkContext->device();
+    VkDescriptorImageInfo colorInfo{ _sampler, color, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    VkDescriptorImageInfo displayInfo{ _sampler, display, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    std::array<VkWriteDescriptorSet, 2> writes{};
+    writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[0].dstSet = _upscaleSets[_frameIndex];
+    writes[0].dstBinding = 0;
+    writes[0].descriptorCount = 1;
+    writes[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writes[0].pImageInfo = &colorInfo;
+    writes[1] = writes[0];
+    writes[1].dstSet = _displaySets[_frameIndex];
+    writes[1].pImageInfo = &displayInfo;
+    if (_displaySets[_frameIndex] == VK_NULL_HANDLE) {
+        _displaySets[_frameIndex] = ImGui_ImplVulkan_AddTexture(_sampler, display, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        vkUpdateDescriptorSets(device, 1, writes.data(), 0, nullptr);
+    } else {
+        vkUpdateDescriptorSets(device, 2, writes.data(), 0, nullptr);
+    }
+
+    VkRenderPassBeginInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = _upscalePass;
+    renderPassInfo.framebuffer = framebuffer;
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = _extent;
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(_extent.width), static_cast<float>(_extent.height), 0.0f, 1.0f };
+    VkRect2D scissor{ { 0, 0 }, _extent };
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+    UpscalePushConstants constants{};
+    constants.uvScale[0] = static_cast<float>(_renderExtent.width) / _extent.width;
+    constants.uvScale[1] = static_cast<float>(_renderExtent.height) / _extent.height;
+    constants.texelSize[0] = 1.0f / _extent.width;
+    constants.texelSize[1] = 1.0f / _extent.height;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _upscalePipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, _upscalePipelineLayout, 0, 1, &_upscaleSets[_frameIndex], 0, nullptr);
+    vkCmdPushConstants(commandBuffer, _upscalePipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(constants), &constants);
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+
+    vkCmdEndRenderPass(commandBuffer);
+
+    if (_queryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool, _frameIndex * 2 + 1);
+        _timestampsWritten[_frameIndex] = true;
+    }
+}
@@ -3,6 +3,10 @@
 #include <set>
 #include <algorithm>
 #include <limits>
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
 
 const std::vector<const char*> validationLayers = {
     "VK_LAYER_KHRONOS_validation"
@@ -12,6 +16,17 @@ const std::vector<const char*> deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+static std::vector<char> readShaderFile(const std::string& path) {
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open shader file: " + path);
+    }
+    std::vector<char> code(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(code.data(), code.size());
+    return code;
+}
+
 #ifdef NDEBUG
 const bool enableValidationLayers = false;
 #else
@@ -19,43 +34,47 @@ const bool enableValidationLayers = true;
 #endif
 
 void VulkanContext::init(GLFWwindow* window) {
-    createInstance();
+    createInstance(window != nullptr);
     setupDebugMessenger();
-    createSurface(window);
+    if (window != nullptr) createSurface(window);
     pickPhysicalDevice();
     createLogicalDevice();
+    if (window == nullptr) return;
     createSwapChain(window);
     createImageViews();
 }
 
 void VulkanContext::cleanup() {
-    for (auto imageView : _swapChainImageViews) {
-        vkDestroyImageView(_device, imageView, nullptr);
+    if (_pipelineCache != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(_device, _pipelineCache, nullptr);
     }
-    vkDestroySwapchainKHR(_device, _swapChain, nullptr);
+    destroyImageViews();
+    if (_swapChain != VK_NULL_HANDLE) vkDestroySwapchainKHR(_device, _swapChain, nullptr);
     vkDestroyDevice(_device, nullptr);
-    vkDestroySurfaceKHR(_instance, _surface, nullptr);
+    if (_surface != VK_NULL_HANDLE) vkDestroySurfaceKHR(_instance, _surface, nullptr);
     vkDestroyInstance(_instance, nullptr);
 }
 
-void VulkanContext::createInstance() {
+void VulkanContext::createInstance(bool presentable) {
     VkApplicationInfo appInfo{};
     appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
     appInfo.pApplicationName = "Vulkan Editor";
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+    appInfo.apiVersion = VK_API_VERSION_1_2;
 
     VkInstanceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
 
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-    createInfo.enabledExtensionCount = glfwExtensionCount;
-    createInfo.ppEnabledExtensionNames = glfwExtensions;
+    if (presentable) {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        createInfo.enabledExtensionCount = glfwExtensionCount;
+        createInfo.ppEnabledExtensionNames = glfwExtensions;
+    }
 
     if (enableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -87,10 +106,15 @@ void VulkanContext::pickPhysicalDevice() {
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(_instance, &deviceCount, devices.data());
 
+    // Every query happens once per device here; the winner's results are kept.
+    uint64_t bestScore = 0;
     for (const auto& device : devices) {
-        if (isDeviceSuitable(device)) {
+        DeviceCapabilities capabilities = queryCapabilities(device);
+        uint64_t score = scoreDevice(capabilities);
+        if (score > bestScore) {
+            bestScore = score;
             _physicalDevice = device;
-            break;
+            _capabilities = std::move(capabilities);
         }
     }
 
@@ -98,7 +122,7 @@ void VulkanContext::pickPhysicalDevice() {
 }
 
 void VulkanContext::createLogicalDevice() {
-    QueueFamilyIndices indices = findQueueFamilies(_physicalDevice);
+    const QueueFamilyIndices& indices = _capabilities.queueIndices;
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
@@ -114,15 +138,26 @@ void VulkanContext::createLogicalDevice() {
     }
 
     VkPhysicalDeviceFeatures deviceFeatures{};
-    deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.samplerAnisotropy = _capabilities.features.samplerAnisotropy;
+    deviceFeatures.multiDrawIndirect = _capabilities.features.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = _capabilities.features.drawIndirectFirstInstance;
+
+    // Frames are paced with a timeline semaphore.
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.timelineSemaphore = VK_TRUE;
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &vulkan12Features;
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.pEnabledFeatures = &deviceFeatures;
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    std::vector<const char*> enabledExtensions;
+    if (_surface != VK_NULL_HANDLE) enabledExtensions = deviceExtensions;
+    if (_capabilities.memoryBudget) enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
     if (vkCreateDevice(_physicalDevice, &createInfo, nullptr, &_device) != VK_SUCCESS) {
         throw std::runtime_error("failed to create logical device!");
@@ -135,7 +170,7 @@ void VulkanContext::createLogicalDevice() {
 void VulkanContext::createSwapChain(GLFWwindow* window) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(_physicalDevice);
 
-    VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
+    VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(_capabilities.surfaceFormats);
     VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities, window);
 
@@ -154,7 +189,7 @@ void VulkanContext::createSwapChain(GLFWwindow* window) {
     createInfo.imageArrayLayers = 1;
     createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
 
-    QueueFamilyIndices indices = findQueueFamilies(_physicalDevice);
+    const QueueFamilyIndices& indices = _capabilities.queueIndices;
     uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
 
     if (indices.graphicsFamily != indices.presentFamily) {
@@ -169,10 +204,14 @@ void VulkanContext::createSwapChain(GLFWwindow* window) {
     createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     createInfo.presentMode = presentMode;
     createInfo.clipped = VK_TRUE;
+    createInfo.oldSwapchain = _swapChain;
 
-    if (vkCreateSwapchainKHR(_device, &createInfo, nullptr, &_swapChain) != VK_SUCCESS) {
+    VkSwapchainKHR swapChain;
+    if (vkCreateSwapchainKHR(_device, &createInfo, nullptr, &swapChain) != VK_SUCCESS) {
         throw std::runtime_error("failed to create swap chain!");
     }
+    if (_swapChain != VK_NULL_HANDLE) vkDestroySwapchainKHR(_device, _swapChain, nullptr);
+    _swapChain = swapChain;
 
     vkGetSwapchainImagesKHR(_device, _swapChain, &imageCount, nullptr);
     _swapChainImages.resize(imageCount);
@@ -182,6 +221,28 @@ void VulkanContext::createSwapChain(GLFWwindow* window) {
     _swapChainExtent = extent;
 }
 
+void VulkanContext::recreateSwapChain(GLFWwindow* window) {
+    // A minimized window has a zero extent, which no swap chain can have.
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window, &width, &height);
+    while (width == 0 || height == 0) {
+        glfwWaitEvents();
+        glfwGetFramebufferSize(window, &width, &height);
+    }
+
+    vkDeviceWaitIdle(_device);
+    destroyImageViews();
+    createSwapChain(window);
+    createImageViews();
+}
+
+void VulkanContext::destroyImageViews() {
+    for (auto imageView : _swapChainImageViews) {
+        vkDestroyImageView(_device, imageView, nullptr);
+    }
+    _swapChainImageViews.clear();
+}
+
 void VulkanContext::createImageViews() {
     _swapChainImageViews.resize(_swapChainImages.size());
     for (size_t i = 0; i < _swapChainImages.size(); i++) {
@@ -206,57 +267,277 @@ void VulkanContext::createImageViews() {
     }
 }
 
-bool VulkanContext::isDeviceSuitable(VkPhysicalDevice device) {
-    QueueFamilyIndices indices = findQueueFamilies(device);
-    bool extensionsSupported = checkDeviceExtensionSupport(device);
-    bool swapChainAdequate = false;
-    if (extensionsSupported) {
-        SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
-        swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
+uint32_t VulkanContext::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    const VkPhysicalDeviceMemoryProperties& memProperties = _capabilities.memory;
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
     }
-    return indices.isComplete() && extensionsSupported && swapChainAdequate;
+    throw std::runtime_error("failed to find suitable memory type!");
 }
 
-QueueFamilyIndices VulkanContext::findQueueFamilies(VkPhysicalDevice device) {
-    QueueFamilyIndices indices;
+void VulkanContext::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory) {
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateBuffer(_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create buffer!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetBufferMemoryRequirements(_device, buffer, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+
+    if (vkAllocateMemory(_device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate buffer memory!");
+    }
+    vkBindBufferMemory(_device, buffer, memory, 0);
+}
+
+void VulkanContext::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage, VkImage& image, VkDeviceMemory& memory) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent = { width, height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = format;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = usage;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(_device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image!");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(_device, image, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    if (vkAllocateMemory(_device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate image memory!");
+    }
+    vkBindImageMemory(_device, image, memory, 0);
+}
+
+VkImageView VulkanContext::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = aspectFlags;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+
+    VkImageView imageView;
+    if (vkCreateImageView(_device, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image view!");
+    }
+    return imageView;
+}
+
+VkShaderModule VulkanContext::createShaderModule(const std::string& path) {
+    std::lock_guard<std::mutex> lock(_shaderCodeMutex);
+    auto cached = _shaderCode.find(path);
+    if (cached == _shaderCode.end()) {
+        cached = _shaderCode.emplace(path, readShaderFile(path)).first;
+    }
+    const std::vector<char>& code = cached->second;
+
+    VkShaderModuleCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    createInfo.codeSize = code.size();
+    createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+    VkShaderModule shaderModule;
+    if (vkCreateShaderModule(_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create shader module!");
+    }
+    return shaderModule;
+}
+
+void VulkanContext::preloadShaders(const std::string& directory) {
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".spv") continue;
+        // Same spelling as the paths passed to createShaderModule(), e.g. "shaders/mesh.vert.spv".
+        std::string path = (std::filesystem::path(directory) / entry.path().filename()).generic_string();
+        std::vector<char> code = readShaderFile(path);
+
+        std::lock_guard<std::mutex> lock(_shaderCodeMutex);
+        _shaderCode.emplace(std::move(path), std::move(code));
+    }
+    // A missing directory is reported by createShaderModule() with the file that was needed.
+}
+
+void VulkanContext::createPipelineCache(const std::vector<char>& initialData) {
+    // VkPipelineCacheHeaderVersionOne: length, version, vendorID, deviceID, pipelineCacheUUID.
+    const VkPhysicalDeviceProperties& properties = _capabilities.properties;
+    bool compatible = initialData.size() >= 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+    if (compatible) {
+        uint32_t header[4];
+        std::memcpy(header, initialData.data(), sizeof(header));
+        compatible = header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                     header[2] == properties.vendorID && header[3] == properties.deviceID &&
+                     std::memcmp(initialData.data() + sizeof(header), properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    if (compatible) {
+        cacheInfo.initialDataSize = initialData.size();
+        cacheInfo.pInitialData = initialData.data();
+    }
+
+    if (vkCreatePipelineCache(_device, &cacheInfo, nullptr, &_pipelineCache) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create pipeline cache!");
+    }
+}
+
+std::vector<char> VulkanContext::pipelineCacheData() const {
+    if (_pipelineCache == VK_NULL_HANDLE) return {};
+    size_t size = 0;
+    vkGetPipelineCacheData(_device, _pipelineCache, &size, nullptr);
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(_device, _pipelineCache, &size, data.data()) != VK_SUCCESS) return {};
+    data.resize(size);
+    return data;
+}
+
+DeviceCapabilities VulkanContext::queryCapabilities(VkPhysicalDevice device) {
+    DeviceCapabilities capabilities;
+    vkGetPhysicalDeviceProperties(device, &capabilities.properties);
+    vkGetPhysicalDeviceFeatures(device, &capabilities.features);
+    vkGetPhysicalDeviceMemoryProperties(device, &capabilities.memory);
+
     uint32_t queueFamilyCount = 0;
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
-    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
-    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
-
-    int i = 0;
-    for (const auto& queueFamily : queueFamilies) {
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) indices.graphicsFamily = i;
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _surface, &presentSupport);
-        if (presentSupport) indices.presentFamily = i;
-        if (indices.isComplete()) break;
-        i++;
+    capabilities.queueFamilies.resize(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, capabilities.queueFamilies.data());
+    capabilities.queueIndices = findQueueFamilies(device, capabilities.queueFamilies);
+
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    capabilities.extensions.resize(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, capabilities.extensions.data());
+    // Without a surface nothing is presented, so the swap chain is neither needed nor queried.
+    capabilities.extensionsSupported = _surface == VK_NULL_HANDLE || std::all_of(deviceExtensions.begin(), deviceExtensions.end(),
+        [&capabilities](const char* name) { return capabilities.hasExtension(name); });
+    capabilities.memoryBudget = capabilities.hasExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    // The 1.2 feature struct may only be chained for devices that report 1.2.
+    if (capabilities.properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceVulkan12Features vulkan12Features{};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &vulkan12Features;
+        vkGetPhysicalDeviceFeatures2(device, &features2);
+        capabilities.timelineSemaphore = vulkan12Features.timelineSemaphore == VK_TRUE;
+    }
+    if (_surface == VK_NULL_HANDLE) {
+        capabilities.swapChainAdequate = true;
+    } else if (capabilities.extensionsSupported) {
+        capabilities.surfaceFormats = querySurfaceFormats(device);
+        capabilities.swapChainAdequate = !capabilities.surfaceFormats.empty() && !querySwapChainSupport(device).presentModes.empty();
+    }
+
+    for (uint32_t i = 0; i < capabilities.memory.memoryHeapCount; i++) {
+        if (capabilities.memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            capabilities.deviceLocalBytes += capabilities.memory.memoryHeaps[i].size;
+        }
+    }
+    return capabilities;
+}
+
+uint64_t VulkanContext::scoreDevice(const DeviceCapabilities& capabilities) {
+    if (!capabilities.queueIndices.isComplete() || !capabilities.extensionsSupported || !capabilities.swapChainAdequate ||
+        !capabilities.timelineSemaphore) {
+        return 0;
+    }
+
+    // Device type dominates, then dedicated memory (1 point per 64 MiB), then features.
+    uint64_t score = 1;
+    switch (capabilities.properties.deviceType) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score += 1000000; break;
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += 100000; break;
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score += 10000; break;
+    default: break;
+    }
+    score += capabilities.deviceLocalBytes / (64ull * 1024 * 1024);
+    if (capabilities.features.multiDrawIndirect) score += 1000;
+    if (capabilities.features.samplerAnisotropy) score += 500;
+    if (capabilities.timestampValidBits() > 0) score += 500;
+    if (capabilities.queueIndices.graphicsFamily == capabilities.queueIndices.presentFamily) score += 100;
+    return score;
+}
+
+QueueFamilyIndices VulkanContext::findQueueFamilies(VkPhysicalDevice device, const std::vector<VkQueueFamilyProperties>& queueFamilies) {
+    QueueFamilyIndices indices;
+    for (uint32_t i = 0; i < queueFamilies.size(); i++) {
+        bool graphics = (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+        VkBool32 presentSupport = graphics;
+        if (_surface != VK_NULL_HANDLE) vkGetPhysicalDeviceSurfaceSupportKHR(device, i, _surface, &presentSupport);
+        // Prefer one family for both, which keeps the swap chain images exclusive.
+        if (graphics && presentSupport) {
+            indices.graphicsFamily = i;
+            indices.presentFamily = i;
+            break;
+        }
+        if (graphics && !indices.graphicsFamily) indices.graphicsFamily = i;
+        if (presentSupport && !indices.presentFamily) indices.presentFamily = i;
     }
     return indices;
 }
 
-bool VulkanContext::checkDeviceExtensionSupport(VkPhysicalDevice device) {
-    uint32_t extensionCount;
-    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
-    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
-    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
-    std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
-    for (const auto& extension : availableExtensions) {
-        requiredExtensions.erase(extension.extensionName);
+bool DeviceCapabilities::hasExtension(const char* name) const {
+    for (const auto& extension : extensions) {
+        if (std::strcmp(extension.extensionName, name) == 0) return true;
     }
-    return requiredExtensions.empty();
+    return false;
+}
+
+bool VulkanContext::deviceLocalBudget(VkDeviceSize& budget, VkDeviceSize& usage) const {
+    if (!_capabilities.memoryBudget) return false;
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    properties.pNext = &budgetProperties;
+    vkGetPhysicalDeviceMemoryProperties2(_physicalDevice, &properties);
+
+    budget = 0;
+    usage = 0;
+    for (uint32_t i = 0; i < properties.memoryProperties.memoryHeapCount; i++) {
+        if (properties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            budget += budgetProperties.heapBudget[i];
+            usage += budgetProperties.heapUsage[i];
+        }
+    }
+    return true;
 }
 
 SwapChainSupportDetails VulkanContext::querySwapChainSupport(VkPhysicalDevice device) {
     SwapChainSupportDetails details;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, _surface, &details.capabilities);
-    uint32_t formatCount;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(device, _surface, &formatCount, nullptr);
-    if (formatCount != 0) {
-        details.formats.resize(formatCount);
-        vkGetPhysicalDeviceSurfaceFormatsKHR(device, _surface, &formatCount, details.formats.data());
-    }
     uint32_t presentModeCount;
     vkGetPhysicalDeviceSurfacePresentModesKHR(device, _surface, &presentModeCount, nullptr);
     if (presentModeCount != 0) {
@@ -266,6 +547,17 @@ SwapChainSupportDetails VulkanContext::querySwapChainSupport(VkPhysicalDevice de
     return details;
 }
 
+std::vector<VkSurfaceFormatKHR> VulkanContext::querySurfaceFormats(VkPhysicalDevice device) {
+    std::vector<VkSurfaceFormatKHR> formats;
+    uint32_t formatCount;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(device, _surface, &formatCount, nullptr);
+    if (formatCount != 0) {
+        formats.resize(formatCount);
+        vkGetPhysicalDeviceSurfaceFormatsKHR(device, _surface, &formatCount, formats.data());
+    }
+    return formats;
+}
+
 VkSurfaceFormatKHR VulkanContext::chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
     for (const auto& availableFormat : availableFormats) {
         if (availableFormat.format == VK_FORMAT_B8G8R8A8_SRGB && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
@@ -0,0 +1,97 @@
+#include "WorldPartition.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+uint64_t splitMix(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+uint32_t WorldPartition::addCell(const Cell& cell) {
+    auto [it, inserted] = _byCoord.try_emplace(key(cell.coord), static_cast<uint32_t>(_cells.size()));
+    if (inserted) {
+        _cells.push_back(cell);
+    } else {
+        Cell& existing = _cells[it->second];
+        _totalBytes -= existing.cpuBytes + existing.gpuBytes;
+        existing = cell;
+    }
+    _totalBytes += cell.cpuBytes + cell.gpuBytes;
+    return it->second;
+}
+
+void WorldPartition::cellsNear(const glm::vec3& center, float radius, std::vector<uint32_t>& out) const {
+    out.clear();
+    glm::ivec2 first(static_cast<int>(std::floor((center.x - radius) / _cellSize)), static_cast<int>(std::floor((center.z - radius) / _cellSize)));
+    glm::ivec2 last(static_cast<int>(std::floor((center.x + radius) / _cellSize)), static_cast<int>(std::floor((center.z + radius) / _cellSize)));
+    for (int z = first.y; z <= last.y; z++) {
+        for (int x = first.x; x <= last.x; x++) {
+            // Closest point of the cell's footprint to the centre.
+            float dx = std::max({ x * _cellSize - center.x, 0.0f, center.x - (x + 1) * _cellSize });
+            float dz = std::max({ z * _cellSize - center.z, 0.0f, center.z - (z + 1) * _cellSize });
+            if (dx * dx + dz * dz > radius * radius) continue;
+            auto it = _byCoord.find(key({ x, z }));
+            if (it != _byCoord.end()) out.push_back(it->second);
+        }
+    }
+}
+
+WorldPartition WorldPartition::synthetic(uint32_t cellsPerSide, float cellSize, uint64_t averageBytes, uint64_t seed) {
+    WorldPartition world(cellSize);
+    world._cells.reserve(static_cast<size_t>(cellsPerSide) * cellsPerSide);
+    int half = static_cast<int>(cellsPerSide / 2);
+    for (uint32_t z = 0; z < cellsPerSide; z++) {
+        for (uint32_t x = 0; x < cellsPerSide; x++) {
+            uint64_t state = seed ^ (static_cast<uint64_t>(z) * cellsPerSide + x);
+            Cell cell;
+            cell.coord = glm::ivec2(static_cast<int>(x) - half, static_cast<int>(z) - half);
+            // Between half and one and a half times the average.
+            uint64_t bytes = averageBytes / 2 + splitMix(state) % (averageBytes + 1);
+            cell.gpuBytes = bytes / 4 * 3;
+            cell.cpuBytes = bytes - cell.gpuBytes;
+            float height = 8.0f + static_cast<float>(splitMix(state) % 1000) * 0.1f;
+            cell.boundsMin = glm::vec3(cell.coord.x * cellSize, 0.0f, cell.coord.y * cellSize);
+            cell.boundsMax = glm::vec3((cell.coord.x + 1) * cellSize, height, (cell.coord.y + 1) * cellSize);
+            world.addCell(cell);
+        }
+    }
+    return world;
+}
+
+WorldPartition WorldPartition::fromScene(const Scene& scene, const TransformStore& transforms, float cellSize) {
+    WorldPartition world(cellSize);
+    for (Entity entity = 1; entity < scene.entityCount(); entity++) {
+        if (scene.type(entity) != EntityType::Mesh) continue;
+        const glm::mat4& matrix = transforms.get(entity);
+        glm::vec3 min, max;
+        TransformStore::cubeBounds(matrix, min, max);
+        glm::vec3 position(matrix[3]);
+        glm::ivec2 coord(static_cast<int>(std::floor(position.x / cellSize)), static_cast<int>(std::floor(position.z / cellSize)));
+
+        auto [it, inserted] = world._byCoord.try_emplace(key(coord), world.cellCount());
+        if (inserted) {
+            Cell cell;
+            cell.coord = coord;
+            cell.boundsMin = min;
+            cell.boundsMax = max;
+            world._cells.push_back(std::move(cell));
+        }
+        Cell& cell = world._cells[it->second];
+        cell.boundsMin = glm::min(cell.boundsMin, min);
+        cell.boundsMax = glm::max(cell.boundsMax, max);
+        SceneEntry entry{ entity, { position.x, position.y, position.z } };
+        cell.payload.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        cell.gpuBytes += sizeof(glm::mat4);
+    }
+    for (Cell& cell : world._cells) {
+        cell.cpuBytes = cell.payload.size();
+        world._totalBytes += cell.cpuBytes + cell.gpuBytes;
+    }
+    return world;
+}
@@ -0,0 +1,373 @@
+#include "WorldStreamer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+uint64_t mixCell(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+float xzDistance(const WorldPartition::Cell& cell, const glm::vec3& point) {
+    float dx = std::max({ cell.boundsMin.x - point.x, 0.0f, point.x - cell.boundsMax.x });
+    float dz = std::max({ cell.boundsMin.z - point.z, 0.0f, point.z - cell.boundsMax.z });
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+} // namespace
+
+void WorldStreamer::init(VulkanContext* context, JobSystem* jobs) {
+    _vkContext = context;
+    _jobs = jobs;
+}
+
+void WorldStreamer::cleanup() {
+    setWorld(nullptr, {});
+}
+
+void WorldStreamer::setWorld(std::shared_ptr<const WorldPartition> world, const Callbacks& callbacks) {
+    releaseAll();
+    _world = std::move(world);
+    _callbacks = callbacks;
+    _completions = std::make_shared<CompletionQueue>();
+    _cells.assign(_world ? _world->cellCount() : 0, CellRuntime{});
+    // Released GPU bytes stay pending across worlds: frames in flight may still use them.
+    Stats stats;
+    stats.cpuBudget = _stats.cpuBudget;
+    stats.gpuBudget = _stats.gpuBudget;
+    stats.deviceBudget = _stats.deviceBudget;
+    _stats = stats;
+}
+
+void WorldStreamer::releaseAll() {
+    if (!_world) return;
+
+    // Loads in flight finish first so that release sees everything load made.
+    if (_simulated) {
+        for (const SimulatedLoad& load : _simulatedLoads) {
+            _completions->completed.push_back({ load.cell, true });
+        }
+        _simulatedLoads.clear();
+    } else {
+        std::unique_lock<std::mutex> lock(_completions->mutex);
+        _completions->pushed.wait(lock, [this] { return _completions->completed.size() >= _loadsInFlight; });
+    }
+    drainCompletions();
+
+    for (uint32_t index : _active) {
+        if (_cells[index].state == CellState::Resident) {
+            _pendingFree.push_back({ _world->cell(index).gpuBytes, _frameNumber + Renderer::MAX_FRAMES_IN_FLIGHT });
+            _gpuPendingFree += _world->cell(index).gpuBytes;
+        }
+        if (_callbacks.release) _callbacks.release(index);
+    }
+    _active.clear();
+    _commitQueue.clear();
+    _cpuUsed = 0;
+    _gpuUsed = 0;
+    _gpuCommitted = 0;
+}
+
+void WorldStreamer::refreshBudgets() {
+    _stats.cpuBudget = _settings.cpuBudget;
+
+    if (_vkContext && !_simulated &&
+        (_budgetQueriedFrame == UINT64_MAX || _frameNumber - _budgetQueriedFrame >= BUDGET_QUERY_INTERVAL)) {
+        _budgetQueriedFrame = _frameNumber;
+        VkDeviceSize budget, usage;
+        _stats.deviceBudget = _vkContext->deviceLocalBudget(budget, usage);
+        if (_stats.deviceBudget) {
+            // What we hold is ours to keep; the rest of the process and the system are not.
+            uint64_t own = _gpuCommitted + _gpuPendingFree;
+            uint64_t others = usage > own ? usage - own : 0;
+            uint64_t headroom = budget > others ? budget - others : 0;
+            _deviceGpuBudget = static_cast<uint64_t>(static_cast<double>(headroom) * _settings.deviceBudgetFraction);
+        }
+    }
+    _stats.gpuBudget = _stats.deviceBudget ? _deviceGpuBudget : _settings.gpuBudget;
+}
+
+void WorldStreamer::drainCompletions() {
+    std::deque<Completion> completed;
+    if (_simulated) {
+        // Start order, which is what makes a replay reproducible.
+        auto ready = std::stable_partition(_simulatedLoads.begin(), _simulatedLoads.end(),
+                                           [this](const SimulatedLoad& load) { return load.readyFrame <= _frameNumber; });
+        for (auto it = _simulatedLoads.begin(); it != ready; ++it) {
+            completed.push_back({ it->cell, true });
+        }
+        _simulatedLoads.erase(_simulatedLoads.begin(), ready);
+        // Pushed by releaseAll().
+        completed.insert(completed.end(), _completions->completed.begin(), _completions->completed.end());
+        _completions->completed.clear();
+    } else {
+        std::lock_guard<std::mutex> lock(_completions->mutex);
+        completed.swap(_completions->completed);
+    }
+
+    for (const Completion& completion : completed) {
+        _loadsInFlight--;
+        CellRuntime& runtime = _cells[completion.cell];
+        if (completion.succeeded && !runtime.cancelled) {
+            runtime.state = CellState::Loaded;
+            _commitQueue.push_back(completion.cell);
+            continue;
+        }
+
+        if (completion.succeeded && _callbacks.release) _callbacks.release(completion.cell);
+        runtime.failed = !completion.succeeded;
+        runtime.cancelled = false;
+        runtime.state = CellState::Unloaded;
+        _cpuUsed -= _world->cell(completion.cell).cpuBytes;
+        _gpuUsed -= _world->cell(completion.cell).gpuBytes;
+        _active.erase(std::find(_active.begin(), _active.end(), completion.cell));
+    }
+}
+
+float WorldStreamer::priority(const WorldPartition::Cell& cell, const glm::vec3& eye, const glm::vec4 (&planes)[4]) const {
+    glm::vec3 closest = glm::clamp(eye, cell.boundsMin, cell.boundsMax);
+    float distance = glm::length(closest - eye);
+    for (const glm::vec4& plane : planes) {
+        // The corner furthest along the plane normal; if even that is behind, so is the box.
+        glm::vec3 corner(plane.x > 0.0f ? cell.boundsMax.x : cell.boundsMin.x,
+                         plane.y > 0.0f ? cell.boundsMax.y : cell.boundsMin.y,
+                         plane.z > 0.0f ? cell.boundsMax.z : cell.boundsMin.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) return distance * _settings.offscreenPenalty;
+    }
+    return distance;
+}
+
+void WorldStreamer::update(const Camera& camera, uint64_t frameNumber) {
+    if (!_world) return;
+    _frameNumber = frameNumber;
+    _stats.committedBytes = 0;
+    _stats.committedCells = 0;
+
+    auto retired = std::remove_if(_pendingFree.begin(), _pendingFree.end(), [this](const PendingFree& pending) {
+        if (pending.releaseFrame > _frameNumber) return false;
+        _gpuPendingFree -= pending.bytes;
+        return true;
+    });
+    _pendingFree.erase(retired, _pendingFree.end());
+
+    refreshBudgets();
+    drainCompletions();
+
+    glm::vec3 eye = glm::vec3(glm::inverse(camera.view())[3]);
+    // Side planes only (Gribb-Hartmann): the far plane would cut off cells we want ready before they come into view.
+    glm::mat4 viewProjection = camera.viewProjection();
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++) {
+        rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    }
+    const glm::vec4 planes[4] = { rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1], rows[3] - rows[1] };
+
+    // Out of range cells go; the rest get this frame's priority, which eviction below compares against.
+    std::vector<uint32_t> active = _active;
+    for (uint32_t index : active) {
+        const WorldPartition::Cell& cell = _world->cell(index);
+        if (xzDistance(cell, eye) > _settings.unloadRadius) {
+            evict(index);
+        } else {
+            _cells[index].priority = priority(cell, eye, planes);
+        }
+    }
+
+    // A budget that shrank (the device reported less headroom) is restored by
+    // dropping the least important cells first.
+    makeRoom(0, 0, -1.0f);
+
+    _world->cellsNear(eye, _settings.loadRadius, _candidates);
+    auto unwanted = std::remove_if(_candidates.begin(), _candidates.end(), [this](uint32_t index) {
+        CellRuntime& runtime = _cells[index];
+        if (runtime.state == CellState::Loading) runtime.cancelled = false;  // back in range before it finished
+        return runtime.state != CellState::Unloaded || runtime.failed;
+    });
+    _candidates.erase(unwanted, _candidates.end());
+    for (uint32_t index : _candidates) {
+        _cells[index].priority = priority(_world->cell(index), eye, planes);
+    }
+    std::sort(_candidates.begin(), _candidates.end(), [this](uint32_t a, uint32_t b) {
+        return _cells[a].priority != _cells[b].priority ? _cells[a].priority < _cells[b].priority : a < b;
+    });
+
+    for (uint32_t index : _candidates) {
+        if (_loadsInFlight >= _settings.maxConcurrentLoads) break;
+        const WorldPartition::Cell& cell = _world->cell(index);
+        if (cell.cpuBytes > _stats.cpuBudget || cell.gpuBytes > _stats.gpuBudget) continue;  // would never fit
+        // Strictly by priority: a cell that has to wait holds back everything behind it.
+        if (!makeRoom(cell.cpuBytes, cell.gpuBytes, _cells[index].priority)) break;
+        if (_gpuUsed + _gpuPendingFree + cell.gpuBytes > _stats.gpuBudget) break;  // room frees as frames retire
+        startLoad(index);
+    }
+
+    commitLoaded();
+
+    _stats.resident = 0;
+    for (uint32_t index : _active) {
+        if (_cells[index].state == CellState::Resident) _stats.resident++;
+    }
+    _stats.loading = static_cast<uint32_t>(_active.size()) - _stats.resident;
+    _stats.cpuBytes = _cpuUsed;
+    _stats.gpuBytes = _gpuUsed + _gpuPendingFree;
+}
+
+bool WorldStreamer::makeRoom(uint64_t cpuBytes, uint64_t gpuBytes, float priority) {
+    auto fits = [&](uint64_t cpuFreed, uint64_t gpuFreed) {
+        return _cpuUsed - cpuFreed + cpuBytes <= _stats.cpuBudget && _gpuUsed - gpuFreed + gpuBytes <= _stats.gpuBudget;
+    };
+    if (fits(0, 0)) return true;
+
+    // Loading cells keep their reservation until the job ends, so only loaded ones free anything now.
+    std::vector<uint32_t> victims;
+    for (uint32_t index : _active) {
+        if (_cells[index].state != CellState::Loading && _cells[index].priority > priority) victims.push_back(index);
+    }
+    std::sort(victims.begin(), victims.end(), [this](uint32_t a, uint32_t b) {
+        return _cells[a].priority != _cells[b].priority ? _cells[a].priority > _cells[b].priority : a > b;
+    });
+
+    uint64_t cpuFreed = 0;
+    uint64_t gpuFreed = 0;
+    size_t needed = 0;
+    while (!fits(cpuFreed, gpuFreed) && needed < victims.size()) {
+        cpuFreed += _world->cell(victims[needed]).cpuBytes;
+        gpuFreed += _world->cell(victims[needed]).gpuBytes;
+        needed++;
+    }
+    // Only evict when it buys the room; a budget restore (priority < 0) evicts regardless.
+    if (!fits(cpuFreed, gpuFreed) && priority >= 0.0f) return false;
+
+    for (size_t i = 0; i < needed; i++) {
+        evict(victims[i]);
+    }
+    return fits(0, 0);
+}
+
+void WorldStreamer::startLoad(uint32_t index) {
+    const WorldPartition::Cell& cell = _world->cell(index);
+    _cells[index].state = CellState::Loading;
+    _cells[index].cancelled = false;
+    _active.push_back(index);
+    _cpuUsed += cell.cpuBytes;
+    _gpuUsed += cell.gpuBytes;
+    _loadsInFlight++;
+    _stats.loadsStarted++;
+
+    if (_simulated) {
+        _simulatedLoads.push_back({ _frameNumber + std::max(_simulatedLatency, 1u), index });
+        return;
+    }
+
+    _jobs->submit([queue = _completions, world = _world, load = _callbacks.load, index] {
+        bool succeeded;
+        try {
+            succeeded = !load || load(index, world->cell(index));
+        } catch (const std::exception&) {
+            succeeded = false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            queue->completed.push_back({ index, succeeded });
+        }
+        queue->pushed.notify_one();
+    });
+}
+
+void WorldStreamer::evict(uint32_t index) {
+    CellRuntime& runtime = _cells[index];
+    const WorldPartition::Cell& cell = _world->cell(index);
+    if (runtime.state == CellState::Loading) {
+        runtime.cancelled = true;
+        return;
+    }
+
+    if (runtime.state == CellState::Loaded) {
+        _commitQueue.erase(std::find(_commitQueue.begin(), _commitQueue.end(), index));
+    } else if (runtime.state == CellState::Resident) {
+        _gpuCommitted -= cell.gpuBytes;
+        _pendingFree.push_back({ cell.gpuBytes, _frameNumber + Renderer::MAX_FRAMES_IN_FLIGHT });
+        _gpuPendingFree += cell.gpuBytes;
+    }
+    if (_callbacks.release) _callbacks.release(index);
+
+    runtime.state = CellState::Unloaded;
+    _cpuUsed -= cell.cpuBytes;
+    _gpuUsed -= cell.gpuBytes;
+    _active.erase(std::find(_active.begin(), _active.end(), index));
+    _stats.evictions++;
+}
+
+void WorldStreamer::commitLoaded() {
+    while (!_commitQueue.empty()) {
+        uint32_t index = _commitQueue.front();
+        const WorldPartition::Cell& cell = _world->cell(index);
+        // At least one per frame, however large, so a big cell can't wedge the queue.
+        if (_stats.committedCells > 0 && _stats.committedBytes + cell.gpuBytes > _settings.commitBytesPerFrame) break;
+
+        _commitQueue.pop_front();
+        if (_callbacks.commit) _callbacks.commit(index);
+        _cells[index].state = CellState::Resident;
+        _gpuCommitted += cell.gpuBytes;
+        _stats.committedBytes += cell.gpuBytes;
+        _stats.committedCells++;
+    }
+}
+
+std::vector<WorldStreamer::ReplayFrame> WorldStreamer::replay(std::shared_ptr<const WorldPartition> world, const Settings& settings,
+                                                              const std::vector<CameraSample>& path, uint32_t loadLatencyFrames) {
+    WorldStreamer streamer;
+    streamer._settings = settings;
+    streamer._simulated = true;
+    streamer._simulatedLatency = loadLatencyFrames;
+    streamer.setWorld(std::move(world), {});
+
+    Camera camera;
+    camera.setPerspective(60.0f, 16.0f / 9.0f, 0.1f, 4096.0f);
+
+    std::vector<ReplayFrame> frames;
+    frames.reserve(path.size());
+    for (size_t i = 0; i < path.size(); i++) {
+        camera.lookAt(path[i].eye, path[i].target, glm::vec3(0.0f, 1.0f, 0.0f));
+        streamer.update(camera, i + 1);
+
+        const Stats& stats = streamer.stats();
+        ReplayFrame frame{ stats.resident, stats.loading, stats.cpuBytes, stats.gpuBytes, stats.committedBytes,
+                           stats.committedCells, stats.loadsStarted, stats.evictions, 0 };
+        for (uint32_t index : streamer._active) {
+            if (streamer._cells[index].state == CellState::Resident) frame.residentHash += mixCell(index);
+        }
+        frames.push_back(frame);
+    }
+    streamer.cleanup();
+    return frames;
+}
+
+std::vector<WorldStreamer::CameraSample> WorldStreamer::flythrough(const WorldPartition& world, uint32_t frames) {
+    glm::vec3 min(std::numeric_limits<float>::max());
+    glm::vec3 max(std::numeric_limits<float>::lowest());
+    for (uint32_t i = 0; i < world.cellCount(); i++) {
+        min = glm::min(min, world.cell(i).boundsMin);
+        max = glm::max(max, world.cell(i).boundsMax);
+    }
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.4f;
+
+    // A figure eight: long straight-ish runs plus turns that swing the frustum around.
+    auto position = [&](float t) {
+        float angle = t * 6.28318530718f;
+        return glm::vec3(center.x + extent.x * std::sin(angle), 40.0f, center.z + extent.z * std::sin(2.0f * angle));
+    };
+
+    std::vector<CameraSample> path(frames);
+    for (uint32_t i = 0; i < frames; i++) {
+        float t = static_cast<float>(i) / static_cast<float>(frames);
+        glm::vec3 ahead = position(t + 0.002f);
+        path[i] = { position(t), glm::vec3(ahead.x, 20.0f, ahead.z) };
+    }
+    return path;
+}
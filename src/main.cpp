@@ -2,16 +2,23 @@
 #include <vector>
 #include <stdexcept>
 #include <cstdlib>
+#include <cstring>
 
 
 
 #include "EditorApp.h"
 
-int main() {
+int main(int argc, char** argv) {
+    LaunchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--startup-trace") == 0) options.startupTrace = true;
+        else if (std::strcmp(argv[i], "--project") == 0 && i + 1 < argc) options.projectRoot = argv[++i];
+    }
+
     EditorApp app;
 
     try {
-        app.run();
+        app.run(options);
     } catch (const std::exception& e) {
         std::cerr << "Fatal Error: " << e.what() << std::endl;
         return EXIT_FAILURE;
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "VulkanContext.h"
+#include "RenderGraph.h"
+#include "RenderGraphExecutor.h"
+
+// Shared by the tests that draw on a headless device.
+
+// Compatible with the Viewport's whole scene pass (color, entity id, depth), which the
+// mesh pipeline is built for. Every attachment is cleared or loaded with `loadOp`,
+// and the graph moves them in and out of the attachment layouts.
+VkRenderPass createTestScenePass(VkDevice device, VkAttachmentLoadOp loadOp);
+
+// Records `graph` into a one-time command buffer, submits it and waits for the queue.
+void submitAndWait(VulkanContext& context, RenderGraphExecutor& executor, RenderGraph& graph);
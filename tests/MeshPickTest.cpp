@@ -0,0 +1,173 @@
+#include "Tests.h"
+#include "HeadlessGpu.h"
+#include "MeshRenderer.h"
+#include "ShadowRenderer.h"
+#include "InstanceBuffer.h"
+#include "ViewportRenderer.h"
+#include "TransformStore.h"
+#include "Camera.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cstring>
+#include <exception>
+#include <vector>
+
+// Renders a small scene with the editor's mesh pipeline on a headless device and reads
+// the entity-id attachment back the way Viewport picking does.
+
+namespace {
+
+constexpr VkExtent2D EXTENT{ 64, 64 };
+
+glm::mat4 placed(glm::vec3 position, float size) {
+    return glm::scale(glm::translate(glm::mat4(1.0f), position), glm::vec3(size));
+}
+
+// The id at texture coordinates (u, v), from the top left.
+uint32_t pixel(const uint32_t* ids, float u, float v) {
+    uint32_t x = static_cast<uint32_t>(u * EXTENT.width);
+    uint32_t y = static_cast<uint32_t>(v * EXTENT.height);
+    return ids[y * EXTENT.width + x];
+}
+
+} // namespace
+
+bool meshPickReadbackTest(std::ostream& out) {
+    VulkanContext context;
+    try {
+        context.init(nullptr);
+    } catch (const std::exception& error) {
+        out << "SKIPPED: no Vulkan device (" << error.what() << ")\n";
+        return true;
+    }
+    VkDevice device = context.device();
+
+    // A non-mesh entity first, so the draw list is not the identity: instance 0 is entity 2.
+    Scene scene;
+    TransformStore transforms;
+    transforms.init(&scene);
+    scene.createEntity("Light", EntityType::Light);
+    Entity back = scene.createEntity("Back", EntityType::Mesh);
+    Entity front = scene.createEntity("Front", EntityType::Mesh);
+    Entity top = scene.createEntity("Top", EntityType::Mesh);
+    transforms.set(back, placed(glm::vec3(0.0f, 0.0f, -2.0f), 3.0f));   // around the front cube
+    transforms.set(front, placed(glm::vec3(0.0f), 1.0f));               // covers the center
+    transforms.set(top, placed(glm::vec3(0.0f, 1.6f, 0.0f), 0.5f));    // above the back cube
+
+    Camera camera;
+    camera.setPerspective(45.0f, 1.0f, 0.1f, 100.0f);
+    camera.lookAt(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    // Never inited: frame slot 0, and retired objects only queue up.
+    Renderer renderer;
+    RenderGraph graph;
+    RenderGraphExecutor graphExecutor;
+    InstanceBuffer instances;
+    ShadowRenderer shadows;
+    MeshRenderer meshes;
+    VkRenderPass scenePass = createTestScenePass(device, VK_ATTACHMENT_LOAD_OP_CLEAR);
+    graphExecutor.init(&context, &renderer);
+    instances.init(&context, &renderer);
+    shadows.init(&context);
+    meshes.init(&context, &scene, scenePass, true, shadows.descriptorSetLayout());
+
+    VkBuffer readback;
+    VkDeviceMemory readbackMemory;
+    VkDeviceSize readbackSize = static_cast<VkDeviceSize>(EXTENT.width) * EXTENT.height * sizeof(uint32_t);
+    context.createBuffer(readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, readback, readbackMemory);
+
+    // The editor's frame, cut down to the scene pass and a copy of every entity id.
+    using Access = RenderGraph::Access;
+    RenderGraph::ResourceId instanceBuffer = instances.addPass(graph, 0, transforms);
+    meshes.beginFrame(0, instances.buffer(), nullptr);
+    ShadowRenderer::Atlases atlases = shadows.addPasses(graph, 0, camera, {});
+    RenderGraph::ResourceId color = graph.createImage("color",
+        { ViewportRenderer::COLOR_FORMAT, EXTENT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+    RenderGraph::ResourceId entityId = graph.createImage("entity id",
+        { ViewportRenderer::ENTITY_ID_FORMAT, EXTENT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+    RenderGraph::ResourceId depth = graph.createImage("depth",
+        { ViewportRenderer::DEPTH_FORMAT, EXTENT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_IMAGE_ASPECT_DEPTH_BIT });
+
+    glm::mat4 viewProjection = camera.viewProjection();
+    glm::mat4 view = camera.view();
+    VkDescriptorSet shadowSet = shadows.descriptorSet(0);
+    graph.addPass("scene", { RenderGraph::write(color, Access::ColorAttachment), RenderGraph::write(entityId, Access::ColorAttachment),
+                             RenderGraph::write(depth, Access::DepthAttachment), RenderGraph::read(instanceBuffer, Access::StorageVertex),
+                             RenderGraph::read(atlases.staticAtlas, Access::SampledFragment),
+                             RenderGraph::read(atlases.dynamicAtlas, Access::SampledFragment) },
+        [&](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+            VkClearValue clearValues[3]{};
+            clearValues[2].depthStencil = { 1.0f, 0 };
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = scenePass;
+            renderPassInfo.framebuffer = executor.framebuffer(scenePass, { color, entityId, depth });
+            renderPassInfo.renderArea.extent = EXTENT;
+            renderPassInfo.clearValueCount = 3;
+            renderPassInfo.pClearValues = clearValues;
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+            VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(EXTENT.width), static_cast<float>(EXTENT.height), 0.0f, 1.0f };
+            VkRect2D scissor{ { 0, 0 }, EXTENT };
+            vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+            vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+            meshes.bind(commandBuffer, shadowSet, viewProjection, view);
+            meshes.draw(commandBuffer);
+            vkCmdEndRenderPass(commandBuffer);
+        });
+    graph.addPass("readback", { RenderGraph::read(entityId, Access::TransferSrc) },
+        [&](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+            VkBufferImageCopy region{};
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.layerCount = 1;
+            region.imageExtent = { EXTENT.width, EXTENT.height, 1 };
+            vkCmdCopyImageToBuffer(commandBuffer, executor.image(entityId), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readback, 1, &region);
+
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }, true);
+
+    submitAndWait(context, graphExecutor, graph);
+
+    std::vector<uint32_t> ids(static_cast<size_t>(EXTENT.width) * EXTENT.height);
+    void* mapped;
+    vkMapMemory(device, readbackMemory, 0, readbackSize, 0, &mapped);
+    std::memcpy(ids.data(), mapped, readbackSize);
+    vkUnmapMemory(device, readbackMemory);
+
+    struct Probe {
+        const char* where;
+        float u, v;
+        Entity expected;
+    };
+    // The top cube lands in the upper half: the Y flip puts world up at the top of the image.
+    const Probe probes[] = {
+        { "center", 0.5f, 0.5f, front },
+        { "left of center", 0.25f, 0.5f, back },
+        { "top", 0.5f, 0.12f, top },
+        { "bottom", 0.5f, 0.88f, NULL_ENTITY },
+        { "corner", 0.02f, 0.02f, NULL_ENTITY },
+    };
+    bool passed = true;
+    for (const Probe& probe : probes) {
+        uint32_t id = pixel(ids.data(), probe.u, probe.v);
+        out << probe.where << ": entity " << id << "\n";
+        if (id != probe.expected) {
+            out << "  expected " << probe.expected << "\n";
+            passed = false;
+        }
+    }
+
+    vkDestroyBuffer(device, readback, nullptr);
+    vkFreeMemory(device, readbackMemory, nullptr);
+    meshes.cleanup();
+    shadows.cleanup();
+    instances.cleanup();
+    graphExecutor.cleanup();
+    vkDestroyRenderPass(device, scenePass, nullptr);
+    context.cleanup();
+    return passed;
+}
@@ -0,0 +1,460 @@
+#include "Tests.h"
+#include "HeadlessGpu.h"
+#include "OcclusionCuller.h"
+#include "MeshRenderer.h"
+#include "ShadowRenderer.h"
+#include "InstanceBuffer.h"
+#include "TransformStore.h"
+#include "Camera.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <string>
+#include <vector>
+
+// CPU ports of shaders/hiz_downsample.comp and shaders/cull.comp, kept line for line
+// with the shaders so a change to either shows up here.
+
+namespace {
+
+using Bounds = OcclusionCuller::Bounds;
+
+struct Size {
+    int width;
+    int height;
+};
+
+// Row-major depth, 0 at the near plane and 1 at the far plane.
+struct DepthImage {
+    Size size;
+    std::vector<float> texels;
+
+    float fetch(int x, int y) const { return texels[static_cast<size_t>(y) * size.width + x]; }
+};
+
+// The viewport's render extent and the pyramid beginFrame() picks for it: the largest
+// power of two that fits in each dimension.
+constexpr Size RENDER_SIZE{ 200, 120 };
+constexpr Size PYRAMID_SIZE{ 128, 64 };
+
+struct View {
+    glm::vec3 eye;
+    float focal;  // 1 / tan(fovY / 2)
+    float aspect;
+    glm::mat4 viewProjection;
+};
+
+// The editor's Camera looking down -Z from `eye`, with a 60 degree vertical field of view.
+Camera makeCamera(glm::vec3 eye) {
+    Camera camera;
+    camera.setPerspective(60.0f, float(RENDER_SIZE.width) / float(RENDER_SIZE.height), 0.1f, 100.0f);
+    camera.lookAt(eye, eye - glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    return camera;
+}
+
+View makeView(glm::vec3 eye) {
+    Camera camera = makeCamera(eye);
+    float aspect = float(RENDER_SIZE.width) / float(RENDER_SIZE.height);
+    return { eye, 1.0f / std::tan(0.5f * camera.fov()), aspect, camera.viewProjection() };
+}
+
+Bounds box(glm::vec3 min, glm::vec3 max) {
+    return { glm::vec4(min.x, min.y, min.z, 0.0f), glm::vec4(max.x, max.y, max.z, 0.0f) };
+}
+
+// The unit cube MeshRenderer draws, stretched over `b`.
+glm::mat4 cubeTransform(const Bounds& b) {
+    glm::vec3 min(b.min), max(b.max);
+    return glm::scale(glm::translate(glm::mat4(1.0f), 0.5f * (min + max)), max - min);
+}
+
+const glm::vec3 EYE(0.0f, 0.0f, 10.0f);
+
+std::vector<Bounds> referenceObjects() {
+    return {
+        box({ -5.0f, -4.0f, -0.5f }, { 5.0f, 4.0f, 0.5f }),    // 0: a wall across the view
+        box({ -1.0f, -1.0f, -6.0f }, { 1.0f, 1.0f, -4.0f }),   // 1: hidden behind it
+        box({ 1.5f, -1.0f, 2.0f }, { 2.5f, 1.0f, 3.0f }),      // 2: in front of it
+        box({ -8.0f, -1.0f, -1.0f }, { -6.0f, 1.0f, 1.0f }),   // 3: beside it
+        box({ 4.0f, -1.0f, -6.0f }, { 9.0f, 1.0f, -4.0f }),    // 4: behind it, sticking out past its edge
+        box({ -40.0f, -1.0f, -1.0f }, { -38.0f, 1.0f, 1.0f }), // 5: left of the frustum
+        box({ -1.0f, -1.0f, 20.0f }, { 1.0f, 1.0f, 22.0f }),   // 6: behind the camera
+    };
+}
+
+// Where the wall goes in the last frame: out of view.
+Bounds movedWall() {
+    return box({ -30.0f, -4.0f, -0.5f }, { -20.0f, 4.0f, 0.5f });
+}
+
+constexpr uint32_t REFERENCE_FRAMES = 4;
+constexpr uint32_t WALL_MOVED_FRAME = 3;
+
+// The depth buffer after drawing the `drawn` boxes: one ray per pixel center, cleared to 1.
+DepthImage rasterize(const View& view, const std::vector<Bounds>& objects, const std::vector<bool>& drawn) {
+    DepthImage depth{ RENDER_SIZE, std::vector<float>(static_cast<size_t>(RENDER_SIZE.width) * RENDER_SIZE.height, 1.0f) };
+    for (int y = 0; y < RENDER_SIZE.height; y++) {
+        for (int x = 0; x < RENDER_SIZE.width; x++) {
+            float ndcX = (x + 0.5f) / RENDER_SIZE.width * 2.0f - 1.0f;
+            float ndcY = (y + 0.5f) / RENDER_SIZE.height * 2.0f - 1.0f;
+            // Clip space Y points down (Camera::viewProjection()).
+            glm::vec3 direction(ndcX * view.aspect / view.focal, -ndcY / view.focal, -1.0f);
+
+            for (size_t i = 0; i < objects.size(); i++) {
+                if (!drawn[i]) continue;
+                float entry = -1e30f, exit = 1e30f;
+                for (int axis = 0; axis < 3; axis++) {
+                    float t0 = (objects[i].min[axis] - view.eye[axis]) / direction[axis];
+                    float t1 = (objects[i].max[axis] - view.eye[axis]) / direction[axis];
+                    entry = std::max(entry, std::min(t0, t1));
+                    exit = std::min(exit, std::max(t0, t1));
+                }
+                if (entry > exit || entry <= 0.0f) continue;
+                glm::vec4 clip = view.viewProjection * glm::vec4(view.eye.x + entry * direction.x, view.eye.y + entry * direction.y,
+                                                                 view.eye.z + entry * direction.z, 1.0f);
+                float& texel = depth.texels[static_cast<size_t>(y) * RENDER_SIZE.width + x];
+                texel = std::min(texel, std::clamp(clip.z / clip.w, 0.0f, 1.0f));
+            }
+        }
+    }
+    return depth;
+}
+
+// hiz_downsample.comp, once per level as OcclusionCuller::buildDepthPyramid() dispatches it.
+std::vector<DepthImage> buildPyramid(const DepthImage& depth) {
+    uint32_t levels = 1;
+    while ((std::max(PYRAMID_SIZE.width, PYRAMID_SIZE.height) >> levels) > 0) levels++;
+
+    std::vector<DepthImage> pyramid;
+    pyramid.reserve(levels);
+    Size inputSize = RENDER_SIZE;
+    for (uint32_t level = 0; level < levels; level++) {
+        const DepthImage& input = level > 0 ? pyramid.back() : depth;
+        Size outputSize{ std::max(1, PYRAMID_SIZE.width >> level), std::max(1, PYRAMID_SIZE.height >> level) };
+        DepthImage output{ outputSize, std::vector<float>(static_cast<size_t>(outputSize.width) * outputSize.height) };
+
+        float ratioX = float(inputSize.width) / float(outputSize.width);
+        float ratioY = float(inputSize.height) / float(outputSize.height);
+        for (int y = 0; y < outputSize.height; y++) {
+            for (int x = 0; x < outputSize.width; x++) {
+                int firstX = int(std::floor(x * ratioX)), firstY = int(std::floor(y * ratioY));
+                int lastX = std::min(int(std::ceil((x + 1) * ratioX)), inputSize.width) - 1;
+                int lastY = std::min(int(std::ceil((y + 1) * ratioY)), inputSize.height) - 1;
+                float farthest = 0.0f;
+                for (int inputY = firstY; inputY <= lastY; inputY++) {
+                    for (int inputX = firstX; inputX <= lastX; inputX++) farthest = std::max(farthest, input.fetch(inputX, inputY));
+                }
+                output.texels[static_cast<size_t>(y) * outputSize.width + x] = farthest;
+            }
+        }
+        pyramid.push_back(std::move(output));
+        inputSize = outputSize;
+    }
+    return pyramid;
+}
+
+// cull.comp projectBounds(); rect is min x, min y, max x, max y in [0, 1].
+bool projectBounds(const glm::mat4& viewProjection, const Bounds& b, float rect[4], float& nearestDepth, bool& straddlesNear) {
+    float rectMin[2] = { 1e30f, 1e30f };
+    float rectMax[2] = { -1e30f, -1e30f };
+    nearestDepth = 1.0f;
+    straddlesNear = false;
+    // Outside if every corner lies beyond the same clip plane.
+    int below[3] = { 0, 0, 0 };
+    int above[3] = { 0, 0, 0 };
+    for (int i = 0; i < 8; i++) {
+        glm::vec4 corner((i & 1) != 0 ? b.max.x : b.min.x, (i & 2) != 0 ? b.max.y : b.min.y, (i & 4) != 0 ? b.max.z : b.min.z, 1.0f);
+        glm::vec4 clip = viewProjection * corner;
+        below[0] += clip.x < -clip.w;
+        below[1] += clip.y < -clip.w;
+        below[2] += clip.z < 0.0f;
+        above[0] += clip.x > clip.w;
+        above[1] += clip.y > clip.w;
+        above[2] += clip.z > clip.w;
+        if (clip.w <= 1e-5f) {
+            straddlesNear = true;
+            continue;
+        }
+        float ndc[3] = { clip.x / clip.w, clip.y / clip.w, clip.z / clip.w };
+        for (int axis = 0; axis < 2; axis++) {
+            rectMin[axis] = std::min(rectMin[axis], ndc[axis]);
+            rectMax[axis] = std::max(rectMax[axis], ndc[axis]);
+        }
+        nearestDepth = std::min(nearestDepth, ndc[2]);
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        if (below[axis] == 8 || above[axis] == 8) return false;
+    }
+    for (int axis = 0; axis < 2; axis++) {
+        rect[axis] = std::clamp(rectMin[axis] * 0.5f + 0.5f, 0.0f, 1.0f);
+        rect[axis + 2] = std::clamp(rectMax[axis] * 0.5f + 0.5f, 0.0f, 1.0f);
+    }
+    return true;
+}
+
+// cull.comp occluded().
+bool occluded(const std::vector<DepthImage>& pyramid, const float rect[4], float nearestDepth) {
+    float width = (rect[2] - rect[0]) * PYRAMID_SIZE.width;
+    float height = (rect[3] - rect[1]) * PYRAMID_SIZE.height;
+    int level = std::clamp(int(std::ceil(std::log2(std::max(std::max(width, height), 1.0f)))), 0, int(pyramid.size()) - 1);
+    const DepthImage& image = pyramid[level];
+    auto texel = [](float coordinate, int extent) { return std::clamp(int(coordinate * extent), 0, extent - 1); };
+    int firstX = texel(rect[0], image.size.width), firstY = texel(rect[1], image.size.height);
+    int lastX = texel(rect[2], image.size.width), lastY = texel(rect[3], image.size.height);
+
+    float farthest = std::max(std::max(image.fetch(firstX, firstY), image.fetch(lastX, firstY)),
+                              std::max(image.fetch(firstX, lastY), image.fetch(lastX, lastY)));
+    return nearestDepth > farthest;
+}
+
+struct Frame {
+    std::vector<bool> early;  // drawn by the first phase
+    std::vector<bool> late;   // drawn by the second
+    uint32_t occluded = 0;
+};
+
+// One frame as OcclusionCuller records it: early cull, early draws, pyramid, late cull.
+// `visible` carries the late results from frame to frame, like its visibility buffer.
+Frame cullFrame(const View& view, const std::vector<Bounds>& objects, std::vector<uint32_t>& visible) {
+    Frame frame{ std::vector<bool>(objects.size()), std::vector<bool>(objects.size()) };
+    std::vector<bool> inFrustum(objects.size());
+    std::vector<float> rects(objects.size() * 4);
+    std::vector<float> nearestDepths(objects.size());
+    std::vector<bool> straddlesNear(objects.size());
+    for (size_t i = 0; i < objects.size(); i++) {
+        bool straddles;
+        inFrustum[i] = projectBounds(view.viewProjection, objects[i], &rects[i * 4], nearestDepths[i], straddles);
+        straddlesNear[i] = straddles;
+        frame.early[i] = inFrustum[i] && visible[i] != 0;
+    }
+
+    std::vector<DepthImage> pyramid = buildPyramid(rasterize(view, objects, frame.early));
+    for (size_t i = 0; i < objects.size(); i++) {
+        bool isVisible = inFrustum[i] && (straddlesNear[i] || !occluded(pyramid, &rects[i * 4], nearestDepths[i]));
+        frame.late[i] = isVisible && visible[i] == 0;
+        if (inFrustum[i] && !isVisible) frame.occluded++;
+        visible[i] = isVisible ? 1 : 0;
+    }
+    return frame;
+}
+
+std::vector<uint32_t> indices(const std::vector<bool>& set) {
+    std::vector<uint32_t> result;
+    for (uint32_t i = 0; i < set.size(); i++) {
+        if (set[i]) result.push_back(i);
+    }
+    return result;
+}
+
+void printIndices(std::ostream& out, const std::vector<uint32_t>& set) {
+    out << "{";
+    for (size_t i = 0; i < set.size(); i++) out << (i > 0 ? " " : "") << set[i];
+    out << "}";
+}
+
+} // namespace
+
+bool occlusionCullerReferenceTest(std::ostream& out) {
+    View view = makeView(EYE);
+    std::vector<Bounds> objects = referenceObjects();
+
+    struct Expected {
+        const char* name;
+        std::vector<uint32_t> early;
+        std::vector<uint32_t> late;
+        uint32_t occluded;
+    };
+    const Expected frames[REFERENCE_FRAMES] = {
+        // Visibility starts cleared: nothing is drawn early, so the pyramid is empty
+        // and everything in the frustum is drawn late.
+        { "first frame", {}, { 0, 1, 2, 3, 4 }, 0 },
+        // The wall's depth is in the pyramid: object 1 is found occluded (it was still
+        // drawn early, from last frame's set).
+        { "second frame", { 0, 1, 2, 3, 4 }, {}, 1 },
+        { "steady state", { 0, 2, 3, 4 }, {}, 1 },
+        // The wall moved out of view: object 1 is caught by the late cull the same frame.
+        { "wall moved away", { 2, 3, 4 }, { 1 }, 0 },
+    };
+
+    bool passed = true;
+    std::vector<uint32_t> visible(objects.size(), 0);
+    for (const Expected& expected : frames) {
+        if (&expected == &frames[WALL_MOVED_FRAME]) objects[0] = movedWall();
+        Frame frame = cullFrame(view, objects, visible);
+        std::vector<uint32_t> early = indices(frame.early);
+        std::vector<uint32_t> late = indices(frame.late);
+
+        out << expected.name << ": early ";
+        printIndices(out, early);
+        out << ", late ";
+        printIndices(out, late);
+        out << ", occluded " << frame.occluded << "\n";
+        if (early != expected.early || late != expected.late || frame.occluded != expected.occluded) {
+            out << "FAIL: expected early ";
+            printIndices(out, expected.early);
+            out << ", late ";
+            printIndices(out, expected.late);
+            out << ", occluded " << expected.occluded << "\n";
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+// The same frames on a headless device: the reference scene as MeshRenderer cubes, fed
+// to the OcclusionCuller the way EditorApp feeds it and drawn through a split scene
+// pass like the Viewport's. Each frame's counters must match the CPU port's.
+bool occlusionCullerGpuTest(std::ostream& out) {
+    VulkanContext context;
+    try {
+        context.init(nullptr);
+    } catch (const std::exception& error) {
+        out << "SKIPPED: no Vulkan device (" << error.what() << ")\n";
+        return true;
+    }
+    if (!context.drawIndirectFirstInstance()) {
+        out << "SKIPPED: the device cannot start indirect draws at an instance\n";
+        context.cleanup();
+        return true;
+    }
+    VkDevice device = context.device();
+
+    Camera camera = makeCamera(EYE);
+    View view = makeView(EYE);
+    std::vector<Bounds> objects = referenceObjects();
+
+    // Every entity is a mesh, so instance i of the draw list is object i.
+    Scene scene;
+    TransformStore transforms;
+    transforms.init(&scene);
+    std::vector<Entity> entities;
+    for (size_t i = 0; i < objects.size(); i++) {
+        entities.push_back(scene.createEntity("Box #" + std::to_string(i), EntityType::Mesh));
+        transforms.set(entities.back(), cubeTransform(objects[i]));
+    }
+
+    // Never inited: frame slot 0, and retired objects only queue up.
+    Renderer renderer;
+    RenderGraph graph;
+    RenderGraphExecutor graphExecutor;
+    InstanceBuffer instances;
+    ShadowRenderer shadows;
+    MeshRenderer meshes;
+    OcclusionCuller culler;
+    VkRenderPass clearPass = createTestScenePass(device, VK_ATTACHMENT_LOAD_OP_CLEAR);
+    VkRenderPass loadPass = createTestScenePass(device, VK_ATTACHMENT_LOAD_OP_LOAD);
+    graphExecutor.init(&context, &renderer);
+    instances.init(&context, &renderer);
+    shadows.init(&context);
+    meshes.init(&context, &scene, clearPass, true, shadows.descriptorSetLayout());
+    culler.init(&context);
+
+    std::vector<VkDrawIndexedIndirectCommand> draws(objects.size());
+    for (uint32_t i = 0; i < draws.size(); i++) draws[i] = { MeshRenderer::INDEX_COUNT, 1, 0, 0, i };
+    culler.setObjects(objects, draws);
+
+    const VkExtent2D renderExtent{ static_cast<uint32_t>(RENDER_SIZE.width), static_cast<uint32_t>(RENDER_SIZE.height) };
+    VkDescriptorSet shadowSet = shadows.descriptorSet(0);
+    auto beginScene = [&](VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer) {
+        VkClearValue clearValues[3]{};
+        clearValues[2].depthStencil = { 1.0f, 0 };
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = renderPass;
+        renderPassInfo.framebuffer = framebuffer;
+        renderPassInfo.renderArea.extent = renderExtent;
+        renderPassInfo.clearValueCount = renderPass == clearPass ? 3 : 0;
+        renderPassInfo.pClearValues = clearValues;
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(renderExtent.width), static_cast<float>(renderExtent.height), 0.0f, 1.0f };
+        VkRect2D scissor{ { 0, 0 }, renderExtent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        meshes.bind(commandBuffer, shadowSet, view.viewProjection, camera.view());
+    };
+
+    bool passed = true;
+    std::vector<uint32_t> visible(objects.size(), 0);
+    for (uint32_t frameNumber = 0; frameNumber < REFERENCE_FRAMES; frameNumber++) {
+        if (frameNumber == WALL_MOVED_FRAME) {
+            objects[0] = movedWall();
+            transforms.set(entities[0], cubeTransform(objects[0]));
+            culler.updateBounds(objects);
+        }
+        Frame expected = cullFrame(view, objects, visible);
+
+        using Access = RenderGraph::Access;
+        graph.reset();
+        RenderGraph::ResourceId instanceBuffer = instances.addPass(graph, 0, transforms);
+        meshes.beginFrame(0, instances.buffer(), nullptr);
+        culler.beginFrame(0, renderExtent);
+        ShadowRenderer::Atlases atlases = shadows.addPasses(graph, 0, camera, {});
+
+        ViewportRenderer::SceneCallbacks callbacks;
+        callbacks.drawUses = { RenderGraph::read(instanceBuffer, Access::StorageVertex), RenderGraph::read(atlases.staticAtlas, Access::SampledFragment),
+                               RenderGraph::read(atlases.dynamicAtlas, Access::SampledFragment) };
+        culler.addPasses(graph, view.viewProjection, callbacks);
+        if (!culler.active()) {
+            out << "FAIL: the culler is inactive\n";
+            passed = false;
+            break;
+        }
+
+        RenderGraph::ResourceId color = graph.createImage("color",
+            { ViewportRenderer::COLOR_FORMAT, renderExtent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+        RenderGraph::ResourceId entityId = graph.createImage("entity id",
+            { ViewportRenderer::ENTITY_ID_FORMAT, renderExtent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+        RenderGraph::ResourceId depth = graph.createImage("depth",
+            { ViewportRenderer::DEPTH_FORMAT, renderExtent, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT });
+
+        std::vector<RenderGraph::Use> sceneWrites = { RenderGraph::write(color, Access::ColorAttachment), RenderGraph::write(entityId, Access::ColorAttachment),
+                                                      RenderGraph::write(depth, Access::DepthAttachment) };
+        sceneWrites.insert(sceneWrites.end(), callbacks.drawUses.begin(), callbacks.drawUses.end());
+        graph.addPass("scene", sceneWrites, [&](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+            beginScene(commandBuffer, clearPass, executor.framebuffer(clearPass, { color, entityId, depth }));
+            callbacks.drawEarly(commandBuffer);
+            vkCmdEndRenderPass(commandBuffer);
+        });
+
+        std::vector<RenderGraph::Use> pyramidUses = { RenderGraph::read(depth, Access::SampledCompute) };
+        pyramidUses.insert(pyramidUses.end(), callbacks.depthPyramidUses.begin(), callbacks.depthPyramidUses.end());
+        graph.addPass("depth pyramid", pyramidUses, [&](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+            callbacks.depthPyramid(commandBuffer, executor.view(depth));
+        });
+
+        std::vector<RenderGraph::Use> sceneLoads = { RenderGraph::readWrite(color, Access::ColorAttachment), RenderGraph::readWrite(entityId, Access::ColorAttachment),
+                                                     RenderGraph::readWrite(depth, Access::DepthAttachment) };
+        sceneLoads.insert(sceneLoads.end(), callbacks.drawUses.begin(), callbacks.drawUses.end());
+        graph.addPass("scene late", sceneLoads, [&](VkCommandBuffer commandBuffer, RenderGraphExecutor& executor) {
+            beginScene(commandBuffer, loadPass, executor.framebuffer(loadPass, { color, entityId, depth }));
+            callbacks.drawLate(commandBuffer);
+            vkCmdEndRenderPass(commandBuffer);
+        }, true);
+
+        submitAndWait(context, graphExecutor, graph);
+        // The slot's frame has completed, so this reads back its counters.
+        culler.beginFrame(0, renderExtent);
+        const OcclusionCuller::Stats& stats = culler.stats();
+
+        uint32_t early = static_cast<uint32_t>(indices(expected.early).size());
+        uint32_t late = static_cast<uint32_t>(indices(expected.late).size());
+        out << "frame " << frameNumber << ": early " << stats.earlyVisible << ", late " << stats.lateVisible
+            << ", occluded " << stats.occluded << "\n";
+        if (stats.earlyVisible != early || stats.lateVisible != late || stats.occluded != expected.occluded) {
+            out << "FAIL: the CPU port has early " << early << ", late " << late << ", occluded " << expected.occluded << "\n";
+            passed = false;
+        }
+    }
+
+    culler.cleanup();
+    meshes.cleanup();
+    shadows.cleanup();
+    instances.cleanup();
+    graphExecutor.cleanup();
+    vkDestroyRenderPass(device, loadPass, nullptr);
+    vkDestroyRenderPass(device, clearPass, nullptr);
+    context.cleanup();
+    return passed;
+}
@@ -0,0 +1,282 @@
+#include "Tests.h"
+#include "RenderGraph.h"
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Access = RenderGraph::Access;
+using ResourceId = RenderGraph::ResourceId;
+
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// The layout each access needs, written out independently of RenderGraph::accessInfo.
+VkImageLayout expectedLayout(Access access, VkImageAspectFlags aspect) {
+    bool depth = (aspect & VK_IMAGE_ASPECT_DEPTH_BIT) != 0;
+    switch (access) {
+    case Access::ColorAttachment: return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    case Access::DepthAttachment: return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    case Access::SampledFragment:
+    case Access::SampledCompute:
+        return depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    case Access::StorageCompute: return VK_IMAGE_LAYOUT_GENERAL;
+    case Access::TransferSrc: return VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    case Access::TransferDst: return VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    default: return VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+}
+
+// Roughly what desktop drivers report: 64 KB aligned, one device-local type.
+RenderGraph::MemoryRequirements desktopMemoryRequirements(const RenderGraph::ImageDesc& desc) {
+    VkDeviceSize bytesPerPixel = desc.format == VK_FORMAT_R16G16B16A16_SFLOAT ? 8 : 4;
+    VkDeviceSize size = alignUp(VkDeviceSize(desc.extent.width) * desc.extent.height * bytesPerPixel, 65536);
+    return RenderGraph::MemoryRequirements{ size, 65536, 0 };
+}
+
+// The editor's frame. With the viewport collapsed only the buffer upload and the UI
+// are left.
+void buildEditorFrame(RenderGraph& graph, VkExtent2D extent, bool viewportOpen) {
+    graph.reset();
+    RenderGraph::ImageDesc swapChainDesc{ VK_FORMAT_B8G8R8A8_UNORM, extent, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, VK_IMAGE_ASPECT_COLOR_BIT };
+    ResourceId swapChain = graph.importImage("swapchain", swapChainDesc, VK_NULL_HANDLE, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED,
+                                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+    ResourceId instances = graph.importBuffer("instances", VK_NULL_HANDLE, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+    graph.addPass("instances", { RenderGraph::write(instances, Access::TransferDst) }, nullptr);
+    if (!viewportOpen) {
+        graph.addPass("ui", { RenderGraph::write(swapChain, Access::ColorAttachment) }, nullptr);
+        return;
+    }
+
+    ResourceId color = graph.createImage("color", { VK_FORMAT_R8G8B8A8_UNORM, extent,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+    ResourceId entityId = graph.createImage("entity id", { VK_FORMAT_R32_UINT, extent,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+    ResourceId depth = graph.createImage("depth", { VK_FORMAT_D32_SFLOAT, extent,
+        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_DEPTH_BIT });
+    ResourceId display = graph.createImage("display", { VK_FORMAT_R8G8B8A8_UNORM, extent,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+    ResourceId overlay = graph.createImage("overlay", { VK_FORMAT_R16G16B16A16_SFLOAT, extent,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_IMAGE_ASPECT_COLOR_BIT });
+    ResourceId draws = graph.importBuffer("draws", VK_NULL_HANDLE, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
+
+    graph.addPass("cull", { RenderGraph::read(instances, Access::StorageCompute), RenderGraph::write(draws, Access::StorageCompute) }, nullptr);
+    graph.addPass("scene", { RenderGraph::write(color, Access::ColorAttachment), RenderGraph::write(entityId, Access::ColorAttachment),
+                             RenderGraph::write(depth, Access::DepthAttachment), RenderGraph::read(instances, Access::StorageVertex),
+                             RenderGraph::read(draws, Access::IndirectCommand) }, nullptr);
+    graph.addPass("depth pyramid", { RenderGraph::read(depth, Access::SampledCompute) }, nullptr, true);
+    graph.addPass("scene late", { RenderGraph::readWrite(color, Access::ColorAttachment), RenderGraph::readWrite(entityId, Access::ColorAttachment),
+                                  RenderGraph::readWrite(depth, Access::DepthAttachment) }, nullptr);
+    graph.addPass("pick copy", { RenderGraph::read(entityId, Access::TransferSrc) }, nullptr, true);
+    // Nothing reads the overlay: culled.
+    graph.addPass("overlay", { RenderGraph::write(overlay, Access::ColorAttachment) }, nullptr);
+    graph.addPass("upscale", { RenderGraph::read(color, Access::SampledFragment), RenderGraph::write(display, Access::ColorAttachment) }, nullptr);
+    graph.addPass("ui", { RenderGraph::read(display, Access::SampledFragment), RenderGraph::write(swapChain, Access::ColorAttachment) }, nullptr);
+}
+
+bool sameBatch(const RenderGraph::BarrierBatch& a, const RenderGraph::BarrierBatch& b) {
+    if (a.srcStages != b.srcStages || a.dstStages != b.dstStages || a.images.size() != b.images.size() ||
+        a.buffers.size() != b.buffers.size()) return false;
+    for (size_t i = 0; i < a.images.size(); i++) {
+        const RenderGraph::ImageBarrier& x = a.images[i];
+        const RenderGraph::ImageBarrier& y = b.images[i];
+        if (x.resource != y.resource || x.oldLayout != y.oldLayout || x.newLayout != y.newLayout ||
+            x.srcAccess != y.srcAccess || x.dstAccess != y.dstAccess) return false;
+    }
+    for (size_t i = 0; i < a.buffers.size(); i++) {
+        const RenderGraph::BufferBarrier& x = a.buffers[i];
+        const RenderGraph::BufferBarrier& y = b.buffers[i];
+        if (x.resource != y.resource || x.srcAccess != y.srcAccess || x.dstAccess != y.dstAccess) return false;
+    }
+    return true;
+}
+
+bool sameCompile(const RenderGraph& a, const RenderGraph& b) {
+    if (a.compiledPasses().size() != b.compiledPasses().size()) return false;
+    for (size_t i = 0; i < a.compiledPasses().size(); i++) {
+        if (a.compiledPasses()[i].pass != b.compiledPasses()[i].pass ||
+            !sameBatch(a.compiledPasses()[i].barriers, b.compiledPasses()[i].barriers)) return false;
+    }
+    return sameBatch(a.finalBarriers(), b.finalBarriers()) && a.memoryLayout() == b.memoryLayout();
+}
+
+} // namespace
+
+bool renderGraphCompileTest(std::ostream& out) {
+    const VkExtent2D extent{ 1920, 1080 };
+    RenderGraph::MemoryQuery memoryQuery = desktopMemoryRequirements;
+    auto build = [&](RenderGraph& graph) { buildEditorFrame(graph, extent, true); };
+
+    RenderGraph graph;
+    build(graph);
+    graph.compile(memoryQuery);
+    graph.printStats(out);
+
+    bool passed = true;
+    auto fail = [&](const std::string& message) {
+        out << "FAIL: " << message << "\n";
+        passed = false;
+    };
+
+    const RenderGraph::Stats& stats = graph.stats();
+    if (stats.culledPasses != 1 || graph.compiledPasses().size() != 8) fail("expected exactly the overlay pass to be culled");
+    for (const RenderGraph::CompiledPass& compiled : graph.compiledPasses()) {
+        if (graph.passName(compiled.pass) == "overlay") fail("overlay pass survived");
+    }
+    if (stats.transientBytes >= stats.unaliasedBytes) fail("no transient memory was shared");
+    if (stats.barrierBatches >= stats.imageBarriers) fail("barriers were not batched");
+    // instances: after last frame's reads, then for the cull and the vertex shader;
+    // draws: after last frame's indirect reads, then for the indirect draw.
+    if (stats.bufferBarriers != 5) fail("expected 5 buffer barriers, got " + std::to_string(stats.bufferBarriers));
+
+    // Images alive at the same time never share memory.
+    std::vector<uint32_t> firstUse(graph.resourceCount(), UINT32_MAX);
+    std::vector<uint32_t> lastUse(graph.resourceCount(), 0);
+    for (uint32_t i = 0; i < graph.compiledPasses().size(); i++) {
+        for (const RenderGraph::Use& use : graph.passUses(graph.compiledPasses()[i].pass)) {
+            firstUse[use.resource] = std::min(firstUse[use.resource], i);
+            lastUse[use.resource] = std::max(lastUse[use.resource], i);
+        }
+    }
+    for (ResourceId a = 0; a < graph.resourceCount(); a++) {
+        for (ResourceId b = a + 1; b < graph.resourceCount(); b++) {
+            if (!graph.allocated(a) || !graph.allocated(b)) continue;
+            const RenderGraph::Placement& pa = graph.placement(a);
+            const RenderGraph::Placement& pb = graph.placement(b);
+            bool sharesMemory = pa.heap == pb.heap && pa.offset < pb.offset + pb.size && pb.offset < pa.offset + pa.size;
+            bool bothAlive = firstUse[a] <= lastUse[b] && firstUse[b] <= lastUse[a];
+            if (sharesMemory && bothAlive) fail("'" + graph.resourceName(a) + "' and '" + graph.resourceName(b) + "' share memory while both alive");
+        }
+    }
+
+    // Replaying the barriers puts every image in the layout each pass needs.
+    std::map<ResourceId, VkImageLayout> layouts;
+    for (ResourceId id = 0; id < graph.resourceCount(); id++) {
+        layouts[id] = graph.imported(id) ? graph.initialLayout(id) : VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    auto apply = [&](const RenderGraph::BarrierBatch& batch) {
+        for (const RenderGraph::ImageBarrier& barrier : batch.images) {
+            if (barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED && barrier.oldLayout != layouts[barrier.resource]) {
+                fail("barrier on '" + graph.resourceName(barrier.resource) + "' from the wrong layout");
+            }
+            layouts[barrier.resource] = barrier.newLayout;
+        }
+    };
+    for (const RenderGraph::CompiledPass& compiled : graph.compiledPasses()) {
+        apply(compiled.barriers);
+        for (const RenderGraph::Use& use : graph.passUses(compiled.pass)) {
+            if (graph.isBuffer(use.resource)) continue;
+            if (layouts[use.resource] != expectedLayout(use.access, graph.desc(use.resource).aspect)) {
+                fail("pass '" + graph.passName(compiled.pass) + "' sees '" + graph.resourceName(use.resource) + "' in the wrong layout");
+            }
+        }
+    }
+    apply(graph.finalBarriers());
+    for (ResourceId id = 0; id < graph.resourceCount(); id++) {
+        if (graph.imported(id) && !graph.isBuffer(id) && layouts[id] != graph.finalLayout(id)) {
+            fail("'" + graph.resourceName(id) + "' not in its final layout");
+        }
+    }
+
+    // Same declarations, same result: the executor relies on it to keep its allocation.
+    RenderGraph again;
+    build(again);
+    again.compile(memoryQuery);
+    for (ResourceId id = 0; id < graph.resourceCount(); id++) {
+        const RenderGraph::Placement& a = graph.placement(id);
+        const RenderGraph::Placement& b = again.placement(id);
+        if (a.heap != b.heap || a.offset != b.offset || a.size != b.size) fail("placement differs between identical compiles");
+    }
+
+    // An image access on a buffer is rejected.
+    RenderGraph invalid;
+    ResourceId buffer = invalid.importBuffer("buffer", VK_NULL_HANDLE, 0);
+    invalid.addPass("sample", { RenderGraph::read(buffer, Access::SampledFragment) }, nullptr, true);
+    try {
+        invalid.compile(memoryQuery);
+        fail("sampling a buffer compiled");
+    } catch (const std::runtime_error&) {
+    }
+
+    return passed;
+}
+
+bool renderGraphChangingFramesTest(std::ostream& out) {
+    bool passed = true;
+    auto fail = [&](const std::string& message) {
+        out << "FAIL: " << message << "\n";
+        passed = false;
+    };
+
+    struct Frame {
+        VkExtent2D extent;
+        bool viewportOpen;
+    };
+    const Frame open{ { 1920, 1080 }, true };
+    const Frame collapsed{ { 1920, 1080 }, false };
+    const Frame resized{ { 1280, 720 }, true };
+    // Each change lasts two frames, so both frame slots see it.
+    const std::vector<Frame> frames = { open, open, collapsed, collapsed, resized, resized, open, open, open, open };
+    const uint32_t expectedAllocations = 8;
+
+    // Mirrors RenderGraphExecutor: one allocation per frame slot, replaced when the
+    // slot's graph compiles to a different memory layout.
+    const uint32_t frameSlots = 2;
+    std::vector<RenderGraph::MemoryLayout> slots(frameSlots);
+    uint32_t allocations = 0;
+
+    RenderGraph graph;
+    for (size_t frame = 0; frame < frames.size(); frame++) {
+        buildEditorFrame(graph, frames[frame].extent, frames[frame].viewportOpen);
+        graph.compile(desktopMemoryRequirements);
+
+        // Nothing from the previous frame's graph carries over into this one.
+        RenderGraph fresh;
+        buildEditorFrame(fresh, frames[frame].extent, frames[frame].viewportOpen);
+        fresh.compile(desktopMemoryRequirements);
+        if (!sameCompile(graph, fresh)) fail("frame " + std::to_string(frame) + " compiles differently after another graph");
+
+        RenderGraph::MemoryLayout layout = graph.memoryLayout();
+        RenderGraph::MemoryLayout& slot = slots[frame % frameSlots];
+        if (layout != slot) {
+            slot = std::move(layout);
+            allocations++;
+        }
+
+        // A transient's first use only waits for writes to its memory earlier in the
+        // frame; the slot's previous frame has completed.
+        std::vector<bool> seen(graph.resourceCount(), false);
+        std::vector<VkAccessFlags> written(graph.resourceCount(), 0);
+        for (const RenderGraph::CompiledPass& compiled : graph.compiledPasses()) {
+            for (const RenderGraph::ImageBarrier& barrier : compiled.barriers.images) {
+                ResourceId id = barrier.resource;
+                if (graph.imported(id) || seen[id]) continue;
+                VkAccessFlags earlier = 0;
+                for (ResourceId other = 0; other < graph.resourceCount(); other++) {
+                    if (other == id || !graph.allocated(other) || !seen[other]) continue;
+                    const RenderGraph::Placement& a = graph.placement(id);
+                    const RenderGraph::Placement& b = graph.placement(other);
+                    if (a.heap == b.heap && a.offset < b.offset + b.size && b.offset < a.offset + a.size) earlier |= written[other];
+                }
+                if (barrier.oldLayout != VK_IMAGE_LAYOUT_UNDEFINED) fail("'" + graph.resourceName(id) + "' does not start from UNDEFINED");
+                if ((barrier.srcAccess & ~earlier) != 0) fail("'" + graph.resourceName(id) + "' waits for writes from another frame");
+            }
+            for (const RenderGraph::Use& use : graph.passUses(compiled.pass)) {
+                seen[use.resource] = true;
+                if (!use.write || graph.isBuffer(use.resource)) continue;
+                written[use.resource] |= use.access == Access::DepthAttachment ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                                                                                : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+            }
+        }
+    }
+
+    out << frames.size() << " frames, " << allocations << " transient allocations across " << frameSlots << " frame slots\n";
+    if (allocations != expectedAllocations) {
+        fail("expected " + std::to_string(expectedAllocations) + " allocations, got " + std::to_string(allocations));
+    }
+    return passed;
+}
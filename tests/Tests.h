@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ostream>
+
+// Each test writes a summary to `out` and returns false on a failure. Only
+// occlusion_culler_gpu and mesh_pick need a GPU; without a Vulkan device they
+// report SKIPPED and pass.
+
+// Compiles the editor's frame shape (split scene pass around a depth pyramid,
+// buffer uploads, pick copy, upscale, UI) with made-up memory sizes and checks the
+// culling, layouts, barriers and memory aliasing.
+bool renderGraphCompileTest(std::ostream& out);
+
+// Compiles the same RenderGraph through frames whose shape changes (viewport
+// collapsed, resized, restored) and checks that each compiles as if fresh, that
+// transients never wait on another frame, and that a per-slot allocation is only
+// replaced when its slot's memory layout changes.
+bool renderGraphChangingFramesTest(std::ostream& out);
+
+// Replays a flythrough of a ~50 GB synthetic world twice under tight budgets and
+// checks that neither budget nor the per-frame commit cap is ever exceeded and
+// that both runs match.
+bool worldStreamerReplayTest(std::ostream& out);
+
+// Moves 100k of 1M entities with applyDelta() while a snapshot is held, checks the
+// results against plain glm and the snapshot against the old values, and prints
+// the timings.
+bool transformStoreBatchTest(std::ostream& out);
+
+// Runs CPU ports of cull.comp and hiz_downsample.comp over a fixed scene (a wall, a
+// box hidden behind it, boxes beside and in front, boxes outside the frustum) for a
+// few frames and checks what each phase draws and what is found occluded.
+bool occlusionCullerReferenceTest(std::ostream& out);
+
+// Runs the same frames through the real OcclusionCuller on a headless device, with
+// the boxes drawn as MeshRenderer cubes, and checks each phase's counters against
+// the CPU port's.
+bool occlusionCullerGpuTest(std::ostream& out);
+
+// Draws three cubes with MeshRenderer on a headless device, copies the entity-id
+// attachment back and checks which entity each probed pixel resolved to: the nearest
+// one where they overlap, nothing where no mesh is, and world up at the top.
+bool meshPickReadbackTest(std::ostream& out);
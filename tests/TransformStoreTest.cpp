@@ -0,0 +1,141 @@
+#include "Tests.h"
+#include "TransformStore.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+// Deterministic, non-trivial starting transform for the test: a grid position,
+// a per-entity scale and a shear so every matrix element matters.
+glm::mat4 checkTransform(Entity entity) {
+    glm::mat4 matrix(1.0f);
+    matrix[0][0] = 1.0f + (entity % 7) * 0.1f;
+    matrix[1][1] = 1.0f + (entity % 5) * 0.1f;
+    matrix[1][0] = (entity % 3) * 0.05f;
+    matrix[3] = glm::vec4(float(entity % 1000) * 2.0f, float(entity % 13), float(entity / 1000) * 2.0f, 1.0f);
+    return matrix;
+}
+
+bool nearlyEqual(const glm::mat4& a, const glm::mat4& b) {
+    for (int column = 0; column < 4; column++) {
+        for (int row = 0; row < 4; row++) {
+            if (std::abs(a[column][row] - b[column][row]) > 1e-3f * std::max(1.0f, std::abs(b[column][row]))) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool transformStoreBatchTest(std::ostream& out) {
+    using Clock = std::chrono::steady_clock;
+    auto milliseconds = [](Clock::duration duration) { return std::chrono::duration<double, std::milli>(duration).count(); };
+
+    const uint32_t entityCount = 1000000;
+    const Entity firstSelected = 300001;
+    const uint32_t selectedCount = 100000;
+
+    Scene scene;
+    scene.reserve(entityCount + 1);
+    for (uint32_t i = 0; i < entityCount; i++) scene.createEntity("Cube", EntityType::Mesh);
+    TransformStore store;
+    store.init(&scene);
+    for (Entity entity = 1; entity <= entityCount; entity++) store.set(entity, checkTransform(entity));
+    std::vector<TransformStore::Range> ranges;
+    store.takeDirty(ranges);
+
+    Selection selection;
+    for (Entity entity = firstSelected; entity < firstSelected + selectedCount; entity++) selection.add(entity);
+
+    JobSystem jobs;
+    bool passed = true;
+
+    // Rotate 30 degrees about Y, then move.
+    glm::mat4 delta(1.0f);
+    float c = std::cos(0.5235988f), s = std::sin(0.5235988f);
+    delta[0] = glm::vec4(c, 0.0f, -s, 0.0f);
+    delta[2] = glm::vec4(s, 0.0f, c, 0.0f);
+    delta[3] = glm::vec4(1.0f, 2.0f, 3.0f, 1.0f);
+
+    TransformStore::Snapshot before = store.snapshot();
+    auto applyStart = Clock::now();
+    store.applyDelta(selection, delta, jobs);
+    double firstApplyMs = milliseconds(Clock::now() - applyStart);
+
+    for (Entity entity = 1; entity <= entityCount; entity++) {
+        bool selected = selection.contains(entity);
+        glm::mat4 expected = selected ? delta * checkTransform(entity) : checkTransform(entity);
+        if (!nearlyEqual(store.get(entity), expected)) {
+            out << "entity " << entity << ": wrong transform after the batch edit\n";
+            passed = false;
+            break;
+        }
+        if (before.pages[entity / TransformStore::PAGE_SIZE]->matrices[entity % TransformStore::PAGE_SIZE] != checkTransform(entity)) {
+            out << "entity " << entity << ": the snapshot changed under the edit\n";
+            passed = false;
+            break;
+        }
+    }
+
+    // Pages shared with `before` are the ones the edit did not clone.
+    uint32_t copiedPages = 0;
+    size_t pageCount = 0;
+    {
+        TransformStore::Snapshot after = store.snapshot();
+        pageCount = after.pages.size();
+        for (size_t page = 0; page < pageCount; page++) {
+            if (after.pages[page] != before.pages[page]) copiedPages++;
+        }
+    }
+    uint32_t touchedPages = (firstSelected + selectedCount - 1) / TransformStore::PAGE_SIZE - firstSelected / TransformStore::PAGE_SIZE + 1;
+    if (copiedPages != touchedPages) {
+        out << "copied " << copiedPages << " pages, expected " << touchedPages << "\n";
+        passed = false;
+    }
+
+    store.takeDirty(ranges);
+    uint64_t dirtyEntities = 0;
+    for (const TransformStore::Range& range : ranges) dirtyEntities += range.count;
+    if (ranges.size() != 1 || ranges[0].first > firstSelected ||
+        ranges[0].first + ranges[0].count < firstSelected + selectedCount || dirtyEntities > selectedCount + 2 * TransformStore::BLOCK_SIZE) {
+        out << "dirty ranges do not match the selection (" << ranges.size() << " ranges, " << dirtyEntities << " entities)\n";
+        passed = false;
+    }
+
+    glm::vec3 expectedMin(std::numeric_limits<float>::max()), expectedMax(std::numeric_limits<float>::lowest());
+    for (Entity entity : selection.entities()) {
+        for (int corner = 0; corner < 8; corner++) {
+            glm::vec3 point(store.get(entity) * glm::vec4((corner & 1) ? 0.5f : -0.5f, (corner & 2) ? 0.5f : -0.5f, (corner & 4) ? 0.5f : -0.5f, 1.0f));
+            expectedMin = glm::min(expectedMin, point);
+            expectedMax = glm::max(expectedMax, point);
+        }
+    }
+    glm::vec3 min, max;
+    auto boundsStart = Clock::now();
+    store.bounds(selection, jobs, min, max);
+    double boundsMs = milliseconds(Clock::now() - boundsStart);
+    if (glm::any(glm::greaterThan(glm::abs(min - expectedMin), glm::vec3(1e-2f))) ||
+        glm::any(glm::greaterThan(glm::abs(max - expectedMax), glm::vec3(1e-2f)))) {
+        out << "selection bounds differ from the corner-by-corner bounds\n";
+        passed = false;
+    }
+
+    // A second of gizmo drag: one small delta per frame, the snapshot released first.
+    before = {};
+    glm::mat4 nudge(1.0f);
+    nudge[3] = glm::vec4(0.01f, 0.0f, 0.0f, 1.0f);
+    const int frames = 60;
+    auto dragStart = Clock::now();
+    for (int frame = 0; frame < frames; frame++) store.applyDelta(selection, nudge, jobs);
+    double dragMs = milliseconds(Clock::now() - dragStart) / frames;
+
+    out << "Entities: " << entityCount << ", selected " << selectedCount << "\n"
+        << "Threads: " << jobs.workerCount() + 1 << "\n"
+        << "Batch edit with a snapshot held: " << firstApplyMs << " ms (" << copiedPages << " of " << pageCount << " pages copied)\n"
+        << "Batch edit while dragging: " << dragMs << " ms per frame\n"
+        << "Selection bounds: " << boundsMs << " ms\n";
+    return passed;
+}
@@ -0,0 +1,68 @@
+#include "Tests.h"
+#include "WorldStreamer.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace {
+
+double megabytes(uint64_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+} // namespace
+
+bool worldStreamerReplayTest(std::ostream& out) {
+    // 65536 cells of about 800 KB: a bit over 50 GB.
+    auto world = std::make_shared<const WorldPartition>(WorldPartition::synthetic(256, 64.0f, 800ull << 10, 0x5EED));
+    WorldStreamer::Settings settings;
+    settings.cpuBudget = 8ull << 20;
+    settings.gpuBudget = 24ull << 20;
+    settings.commitBytesPerFrame = 4ull << 20;
+    std::vector<WorldStreamer::CameraSample> path = WorldStreamer::flythrough(*world, 3600);
+    const uint32_t latency = 3;
+
+    std::vector<WorldStreamer::ReplayFrame> first = WorldStreamer::replay(world, settings, path, latency);
+    std::vector<WorldStreamer::ReplayFrame> second = WorldStreamer::replay(world, settings, path, latency);
+
+    bool passed = true;
+    uint64_t peakCpu = 0, peakGpu = 0, peakCommit = 0;
+    uint32_t peakResident = 0;
+    for (size_t i = 0; i < first.size(); i++) {
+        const WorldStreamer::ReplayFrame& frame = first[i];
+        peakCpu = std::max(peakCpu, frame.cpuBytes);
+        peakGpu = std::max(peakGpu, frame.gpuBytes);
+        peakCommit = std::max(peakCommit, frame.committedBytes);
+        peakResident = std::max(peakResident, frame.resident);
+
+        if (frame.cpuBytes > settings.cpuBudget || frame.gpuBytes > settings.gpuBudget) {
+            out << "frame " << i << ": over budget (CPU " << megabytes(frame.cpuBytes) << " MB, GPU " << megabytes(frame.gpuBytes) << " MB)\n";
+            passed = false;
+        }
+        if (frame.committedCells > 1 && frame.committedBytes > settings.commitBytesPerFrame) {
+            out << "frame " << i << ": committed " << megabytes(frame.committedBytes) << " MB\n";
+            passed = false;
+        }
+        const WorldStreamer::ReplayFrame& other = second[i];
+        if (frame.resident != other.resident || frame.loading != other.loading || frame.cpuBytes != other.cpuBytes ||
+            frame.gpuBytes != other.gpuBytes || frame.residentHash != other.residentHash) {
+            out << "frame " << i << ": replays diverge\n";
+            passed = false;
+        }
+    }
+    if (peakResident == 0) {
+        out << "nothing was ever streamed in\n";
+        passed = false;
+    }
+
+    const WorldStreamer::ReplayFrame& last = first.back();
+    out << "World: " << world->cellCount() << " cells, " << megabytes(world->totalBytes()) / 1024.0 << " GB\n"
+        << "Frames: " << first.size() << ", load latency " << latency << " frames\n"
+        << "Peak CPU: " << megabytes(peakCpu) << " / " << megabytes(settings.cpuBudget) << " MB\n"
+        << "Peak GPU: " << megabytes(peakGpu) << " / " << megabytes(settings.gpuBudget) << " MB\n"
+        << "Peak commit: " << megabytes(peakCommit) << " / " << megabytes(settings.commitBytesPerFrame) << " MB per frame\n"
+        << "Peak resident: " << peakResident << " cells\n"
+        << "Loads: " << last.loadsStarted << ", evictions: " << last.evictions << "\n"
+        << "Final resident set: " << std::hex << last.residentHash << std::dec << "\n";
+    return passed;
+}
@@ -0,0 +1,43 @@
+#include "Tests.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+struct Test {
+    const char* name;  // as registered with add_test()
+    bool (*run)(std::ostream&);
+};
+
+const Test TESTS[] = {
+    { "render_graph", renderGraphCompileTest },
+    { "render_graph_frames", renderGraphChangingFramesTest },
+    { "world_streamer", worldStreamerReplayTest },
+    { "transform_batch", transformStoreBatchTest },
+    { "occlusion_culler", occlusionCullerReferenceTest },
+    { "occlusion_culler_gpu", occlusionCullerGpuTest },
+    { "mesh_pick", meshPickReadbackTest },
+};
+
+} // namespace
+
+// Runs the test named on the command line, or every test without one.
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+    bool found = false;
+    bool passed = true;
+    for (const Test& test : TESTS) {
+        if (only != nullptr && std::strcmp(only, test.name) != 0) continue;
+        found = true;
+        std::cout << "== " << test.name << "\n";
+        bool result = test.run(std::cout);
+        std::cout << (result ? "PASSED" : "FAILED") << std::endl;
+        passed = passed && result;
+    }
+    if (!found) {
+        std::cerr << "unknown test: " << only << std::endl;
+        return EXIT_FAILURE;
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}